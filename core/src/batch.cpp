@@ -0,0 +1,178 @@
+#include "batch.h"
+#include <core.h>
+#include <utils/flog.h>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <errno.h>
+#include <spawn.h>
+#include <sys/wait.h>
+extern char** environ;
+#endif
+
+namespace batch {
+    struct Job {
+        std::string path;
+        double duration = 0.0;
+        double procTime = 0.0;
+        int result = -1;
+    };
+
+    std::mutex jobMtx;
+    std::vector<Job> jobs;
+    int nextJob = 0;
+
+    // Get the duration of the recording from its wav header, 0 if unknown
+    double getRecordingDuration(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        uint8_t hdr[44];
+        file.read((char*)hdr, sizeof(hdr));
+        if (file.gcount() < sizeof(hdr) || memcmp(hdr, "RIFF", 4)) { return 0.0; }
+        uint32_t sampleRate = *(uint32_t*)&hdr[24];
+        uint16_t bytesPerSample = *(uint16_t*)&hdr[32];
+        if (!sampleRate || !bytesPerSample) { return 0.0; }
+        return (double)(std::filesystem::file_size(path) - sizeof(hdr)) / ((double)sampleRate * (double)bytesPerSample);
+    }
+
+#ifdef _WIN32
+    // Quote an argument so that the C runtime of the child parses it back unchanged
+    std::string quoteArg(const std::string& arg) {
+        std::string quoted = "\"";
+        int backslashes = 0;
+        for (char c : arg) {
+            if (c == '\\') {
+                backslashes++;
+                continue;
+            }
+            // Backslashes are only special when followed by a quote
+            quoted.append(c == '"' ? backslashes * 2 + 1 : backslashes, '\\');
+            backslashes = 0;
+            quoted += c;
+        }
+        quoted.append(backslashes * 2, '\\');
+        return quoted + "\"";
+    }
+#endif
+
+    // Run a process with the given arguments and wait for it to exit, returns its exit status or -1 on failure
+    int runProcess(const std::vector<std::string>& args) {
+#ifdef _WIN32
+        std::string cmd;
+        for (const auto& arg : args) {
+            if (!cmd.empty()) { cmd += ' '; }
+            cmd += quoteArg(arg);
+        }
+        STARTUPINFOA si = { sizeof(STARTUPINFOA) };
+        PROCESS_INFORMATION pi;
+        if (!CreateProcessA(args[0].c_str(), (char*)cmd.c_str(), NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi)) { return -1; }
+        WaitForSingleObject(pi.hProcess, INFINITE);
+        DWORD status = -1;
+        GetExitCodeProcess(pi.hProcess, &status);
+        CloseHandle(pi.hThread);
+        CloseHandle(pi.hProcess);
+        return (int)status;
+#else
+        std::vector<char*> argv;
+        for (const auto& arg : args) { argv.push_back((char*)arg.c_str()); }
+        argv.push_back(NULL);
+        pid_t pid;
+        if (posix_spawn(&pid, argv[0], NULL, NULL, argv.data(), environ)) { return -1; }
+        int status;
+        while (waitpid(pid, &status, 0) < 0) {
+            if (errno != EINTR) { return -1; }
+        }
+        return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+    }
+
+    void worker(std::string executable, std::string root) {
+        while (true) {
+            // Get the next file to process
+            Job* job;
+            {
+                std::lock_guard<std::mutex> lck(jobMtx);
+                if (nextJob >= jobs.size()) { return; }
+                job = &jobs[nextJob++];
+            }
+
+            // Each file is processed by its own offline mode process, since the signal path is global to an instance.
+            // The jobs all use the same root, so they are not allowed to write the config files.
+            flog::info("Processing {0}", job->path);
+            auto start = std::chrono::high_resolution_clock::now();
+            job->result = runProcess({ executable, "--offline", job->path, "--root", root, "--read_only" });
+            job->procTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            if (job->result) {
+                flog::error("Failed to process {0} (status {1})", job->path, job->result);
+                continue;
+            }
+            flog::info("Processed {0} in {1}s ({2}x real time)", job->path, job->procTime, job->duration / job->procTime);
+        }
+    }
+
+    int main(std::string executable) {
+        flog::info("=====| BATCH MODE |=====");
+
+        // Load the list of files
+        std::string listPath = core::args["batch"].s();
+        std::ifstream list(listPath);
+        if (!list.is_open()) {
+            flog::error("Could not open file list {0}", listPath);
+            return -1;
+        }
+        std::string line;
+        while (std::getline(list, line)) {
+            // Skip empty lines and strip windows line endings
+            if (!line.empty() && line.back() == '\r') { line.pop_back(); }
+            if (line.empty()) { continue; }
+            if (!std::filesystem::is_regular_file(line)) {
+                flog::warn("File {0} does not exist, skipping", line);
+                continue;
+            }
+            Job job;
+            job.path = std::filesystem::absolute(line).string();
+            job.duration = getRecordingDuration(job.path);
+            jobs.push_back(job);
+        }
+        if (jobs.empty()) {
+            flog::error("No file to process");
+            return -1;
+        }
+
+        // Start the workers
+        int jobCount = core::args["jobs"];
+        if (jobCount <= 0) { jobCount = std::max<int>(std::thread::hardware_concurrency(), 1); }
+        jobCount = std::min<int>(jobCount, jobs.size());
+        flog::info("Processing {0} files using {1} jobs", jobs.size(), jobCount);
+        std::string root = core::args["root"].s();
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<std::thread> workers;
+        for (int i = 0; i < jobCount; i++) {
+            workers.push_back(std::thread(worker, executable, root));
+        }
+        for (auto& w : workers) { w.join(); }
+        double totalTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        // Report
+        int failed = 0;
+        double totalDuration = 0.0;
+        for (const auto& job : jobs) {
+            if (job.result) {
+                failed++;
+                continue;
+            }
+            totalDuration += job.duration;
+        }
+        flog::info("Processed {0} files ({1} failed) in {2}s, {3}s of recordings ({4}x real time)", jobs.size(), failed, totalTime, totalDuration, totalDuration / totalTime);
+
+        return failed ? -1 : 0;
+    }
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include <string>
+
+namespace batch {
+    int main(std::string executable);
+}
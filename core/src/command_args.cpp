@@ -14,8 +14,13 @@ void CommandArgsParser::defineAll() {
 #endif
 
         define('a', "addr", "Server mode address", "0.0.0.0");
+        define('b', "batch", "Process every wav IQ file listed in the given file (one path per line) in offline mode", "");
         define('h', "help", "Show help");
+        define('j', "jobs", "Number of files processed at the same time in batch mode, 0 for one per CPU core", 0);
+        define('\0', "offline", "Process a wav IQ file as fast as possible without the GUI, then exit", "");
+        define('\0', "offline_source", "Source playing the file in offline mode", "File");
         define('p', "port", "Server mode port", 5259);
+        define('\0', "read_only", "Never write the config files, used by the batch mode jobs sharing the same root");
         define('r', "root", "Root directory, where all config files are stored", std::filesystem::absolute(root).string());
         define('s', "server", "Run in server mode");
         define('\0', "autostart", "Automatically start the SDR after loading");
@@ -4,6 +4,8 @@
 
 #include <filesystem>
 
+bool ConfigManager::readOnly = false;
+
 ConfigManager::ConfigManager() {
 }
 
@@ -45,6 +47,7 @@ void ConfigManager::load(json def, bool lock) {
 }
 
 void ConfigManager::save(bool lock) {
+    if (readOnly) { return; }
     if (lock) { mtx.lock(); }
     std::ofstream file(path.c_str());
     file << conf.dump(4);
@@ -79,6 +82,10 @@ void ConfigManager::release(bool modified) {
     mtx.unlock();
 }
 
+void ConfigManager::setReadOnly(bool enabled) {
+    readOnly = enabled;
+}
+
 void ConfigManager::autoSaveWorker() {
     while (autoSaveEnabled) {
         if (!mtx.try_lock()) {
@@ -19,6 +19,9 @@ public:
     void acquire();
     void release(bool modified = false);
 
+    // Prevent every config manager of the process from writing its file, changes are kept in memory only
+    static void setReadOnly(bool enabled);
+
     json conf;
 
 private:
@@ -33,4 +36,6 @@ private:
     std::mutex termMtx;
     std::condition_variable termCond;
     volatile bool termFlag = false;
+
+    static bool readOnly;
 };
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include <server.h>
+#include <offline.h>
+#include <batch.h>
 #include "imgui.h"
 #include <stdio.h>
 #include <gui/main_window.h>
@@ -39,6 +41,9 @@ namespace core {
     CommandArgsParser args;
 
     void setInputSampleRate(double samplerate) {
+        // If reported by a secondary source, only its own front-end is affected
+        if (sigpath::sourceManager.routeSampleRate(samplerate)) { return; }
+
         // Forward this to the server
         if (args["server"].b()) { server::setInputSampleRate(samplerate); return; }
         
@@ -78,15 +83,20 @@ int sdrpp_main(int argc, char* argv[]) {
     }
 
     bool serverMode = (bool)core::args["server"];
+    bool offlineMode = !core::args["offline"].s().empty();
+    bool batchMode = !core::args["batch"].s().empty();
 
 #ifdef _WIN32
     // Free console if the user hasn't asked for a console and not in server mode
-    if (!core::args["con"].b() && !serverMode) { FreeConsole(); }
+    if (!core::args["con"].b() && !serverMode && !offlineMode && !batchMode) { FreeConsole(); }
 
     // Set error mode to avoid abnoxious popups
     SetErrorMode(SEM_NOOPENFILEERRORBOX | SEM_NOGPFAULTERRORBOX | SEM_FAILCRITICALERRORS);
 #endif
 
+    // Batch jobs share the root of their parent, they must not overwrite each other's config
+    if (core::args["read_only"].b()) { ConfigManager::setReadOnly(true); }
+
     // Check root directory
     std::string root = (std::string)core::args["root"];
     if (!std::filesystem::exists(root)) {
@@ -246,6 +256,8 @@ int sdrpp_main(int argc, char* argv[]) {
     defConfig["showMenu"] = true;
     defConfig["showWaterfall"] = true;
     defConfig["source"] = "";
+    defConfig["secondarySources"] = json::object();
+    defConfig["vfoSources"] = json::object();
     defConfig["decimation"] = 1;
     defConfig["iqCorrection"] = false;
     defConfig["invertIQ"] = false;
@@ -356,6 +368,8 @@ int sdrpp_main(int argc, char* argv[]) {
     core::configManager.release(true);
 
     if (serverMode) { return server::main(); }
+    if (offlineMode) { return offline::main(); }
+    if (batchMode) { return batch::main(std::filesystem::absolute(argv[0]).string()); }
 
     core::configManager.acquire();
     std::string resDir = core::configManager.conf["resourcesDirectory"];
@@ -3,9 +3,16 @@
 #include <thread>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <condition_variable>
 #include "stream.h"
 #include "types.h"
 
+// Time given to the worker to finish its chunk before an update falls back to stopping it
+#define BLOCK_UPDATE_TIMEOUT_MS 250
+
 namespace dsp {
     class generic_block {
     public:
@@ -63,9 +70,73 @@ namespace dsp {
 
         virtual int run() = 0;
 
+        // Apply a configuration change between two chunks. Unlike tempStop()/tempStart(), the worker thread
+        // isn't joined and the streams aren't interrupted, the change only waits for the chunk being processed.
+        // The change must not stop or start the block itself.
+        // Only the input of a single input block is gated, the worker of a block with several inputs holds
+        // the lock while waiting for any of them. If the worker doesn't let the update through in time, like
+        // when it's waiting for input or stuck writing to a stream nobody reads, the block is temporarily
+        // stopped instead.
+        template <class Func>
+        void update(Func change) {
+            assert(_block_init);
+            std::lock_guard<std::recursive_mutex> lck(ctrlMtx);
+            if (!running || tempStopped) {
+                change();
+                return;
+            }
+
+            updateWaiters++;
+            std::unique_lock<std::recursive_timed_mutex> lck2(updateMtx, std::defer_lock);
+            bool locked = lck2.try_lock_for(std::chrono::milliseconds(BLOCK_UPDATE_TIMEOUT_MS));
+            {
+                std::lock_guard<std::mutex> lck3(waitMtx);
+                updateWaiters--;
+            }
+            waitCnd.notify_all();
+
+            if (!locked) {
+                tempStop();
+                change();
+                tempStart();
+                return;
+            }
+            change();
+        }
+
     protected:
         void workerLoop() {
-            while (run() >= 0) {}
+            for (auto& out : outputs) {
+                out->clearEndOfStream();
+            }
+
+            // The update mutex is held by the worker except between two chunks and while waiting for input
+            std::unique_lock<std::recursive_timed_mutex> lck(updateMtx);
+            untyped_stream* gated = (inputs.size() == 1) ? inputs[0] : NULL;
+            if (gated) { gated->setReaderGate(&updateMtx); }
+
+            while (run() >= 0) {
+                // Let a pending update through, blocks that don't wait for input would never do it otherwise
+                if (updateWaiters) {
+                    lck.unlock();
+                    {
+                        std::unique_lock<std::mutex> lck2(waitMtx);
+                        waitCnd.wait(lck2, [this]() { return !updateWaiters; });
+                    }
+                    lck.lock();
+                }
+            }
+
+            if (gated) { gated->setReaderGate(NULL); }
+
+            // If the worker exited because an input ended, forward it to the blocks downstream
+            for (auto& in : inputs) {
+                if (!in->isEndOfStream()) { continue; }
+                for (auto& out : outputs) {
+                    out->setEndOfStream();
+                }
+                break;
+            }
         }
 
         virtual void doStart() {
@@ -120,6 +191,10 @@ namespace dsp {
         bool _block_init = false;
 
         std::recursive_mutex ctrlMtx;
+        std::recursive_timed_mutex updateMtx;
+        std::atomic<int> updateWaiters = 0;
+        std::mutex waitMtx;
+        std::condition_variable waitCnd;
 
         std::vector<untyped_stream*> inputs;
         std::vector<untyped_stream*> outputs;
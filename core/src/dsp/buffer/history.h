@@ -0,0 +1,153 @@
+#pragma once
+#include "buffer.h"
+#include "mirror.h"
+#include <algorithm>
+
+namespace dsp::buffer {
+    // Keeps the last samples of a stream right before the new ones, as needed by filters. When the
+    // system supports it, the samples live in a mirrored ring so that history and new samples are
+    // always contiguous and nothing is ever moved. Otherwise a linear buffer is used and the history
+    // is moved back to its start before each push. The storage grows with the size of the pushes.
+    template <class T>
+    class History {
+    public:
+        History() {}
+
+        History(int length) { init(length); }
+
+        ~History() { release(); }
+
+        void init(int length) {
+            release();
+            _length = length;
+            grow(_length + 1);
+        }
+
+        /**
+         * Append new samples.
+         * @param in New samples.
+         * @param count Number of new samples.
+         * @return The history followed by the new samples, valid until the next call.
+         */
+        inline T* push(const T* in, int count) {
+            if (_length + count > capacity) { grow(_length + count); }
+
+            if (mirrored) {
+                // Writing past the end lands at the start through the mirror
+                memcpy(&data[pos], in, count * sizeof(T));
+                int start = pos - _length;
+                if (start < 0) { start += capacity; }
+                pos = (pos + count) % capacity;
+                return &data[start];
+            }
+
+            // Move the history left behind by the previous push back to the start
+            if (pending) {
+                memmove(data, &data[pending], _length * sizeof(T));
+                pending = 0;
+            }
+            memcpy(&data[_length], in, count * sizeof(T));
+            pending = count;
+            return data;
+        }
+
+        /**
+         * Change the number of samples kept, the most recent ones are preserved and new ones are zero.
+         * @param length New number of samples to keep.
+         */
+        void setLength(int length) {
+            if (length == _length) { return; }
+            if (length + 1 > capacity) { grow(length + 1); }
+
+            if (mirrored) {
+                // Older samples are still in the ring, clear them to behave like the linear buffer
+                if (length > _length) {
+                    int start = pos - length;
+                    if (start < 0) { start += capacity; }
+                    buffer::clear<T>(&data[start], length - _length);
+                }
+            }
+            else if (length < _length) {
+                memmove(data, &data[pending + _length - length], length * sizeof(T));
+            }
+            else {
+                memmove(&data[length - _length], &data[pending], _length * sizeof(T));
+                buffer::clear<T>(data, length - _length);
+            }
+            _length = length;
+            pending = 0;
+        }
+
+        void clear() {
+            buffer::clear<T>(history(), _length);
+        }
+
+        int length() { return _length; }
+
+    private:
+        // Start of the history, contiguous in both modes
+        inline T* history() {
+            if (mirrored) {
+                int start = pos - _length;
+                if (start < 0) { start += capacity; }
+                return &data[start];
+            }
+            return &data[pending];
+        }
+
+        void grow(int required) {
+            // Leave room for pushes bigger than the last one
+            int newCapacity = required * 2;
+            size_t size = newCapacity * sizeof(T);
+            T* newData = (T*)allocMirrored(size);
+            bool newMirrored = (newData != NULL);
+            if (newMirrored && size % sizeof(T)) {
+                freeMirrored(newData, size);
+                newMirrored = false;
+            }
+            if (newMirrored) {
+                newCapacity = size / sizeof(T);
+            }
+            else {
+                newData = buffer::alloc<T>(newCapacity);
+            }
+
+            // Carry over the history
+            if (data) {
+                memcpy(newData, history(), _length * sizeof(T));
+            }
+            else {
+                buffer::clear<T>(newData, _length);
+            }
+
+            release();
+            data = newData;
+            mirrored = newMirrored;
+            capacity = newCapacity;
+            mapSize = size;
+            pos = _length % capacity;
+            pending = 0;
+        }
+
+        void release() {
+            if (!data) { return; }
+            if (mirrored) {
+                freeMirrored(data, mapSize);
+            }
+            else {
+                buffer::free(data);
+            }
+            data = NULL;
+        }
+
+        T* data = NULL;
+        bool mirrored = false;
+        size_t mapSize = 0;
+        int capacity = 0;
+        int _length = 0;
+
+        // Mirrored: write position in the ring. Linear: number of samples after the history.
+        int pos = 0;
+        int pending = 0;
+    };
+}
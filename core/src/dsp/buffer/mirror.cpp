@@ -0,0 +1,107 @@
+#include "mirror.h"
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) || defined(__ANDROID__)
+#include <sys/syscall.h>
+#endif
+
+// Number of attempts at finding a free address range, another thread may take it in between
+#define MIRROR_MAP_ATTEMPTS 8
+
+namespace dsp::buffer {
+#ifdef _WIN32
+    void* allocMirrored(size_t& size) {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        size_t gran = info.dwAllocationGranularity;
+        size = ((size + gran - 1) / gran) * gran;
+
+        HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, NULL);
+        if (!mapping) { return NULL; }
+
+        // Find a free range twice as big, release it and map both views there
+        for (int i = 0; i < MIRROR_MAP_ATTEMPTS; i++) {
+            uint8_t* addr = (uint8_t*)VirtualAlloc(NULL, size * 2, MEM_RESERVE, PAGE_NOACCESS);
+            if (!addr) { break; }
+            VirtualFree(addr, 0, MEM_RELEASE);
+
+            void* first = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, addr);
+            if (!first) { continue; }
+            void* second = MapViewOfFileEx(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size, addr + size);
+            if (!second) {
+                UnmapViewOfFile(first);
+                continue;
+            }
+
+            // The views keep the mapping alive
+            CloseHandle(mapping);
+            return addr;
+        }
+
+        CloseHandle(mapping);
+        return NULL;
+    }
+
+    void freeMirrored(void* mem, size_t size) {
+        UnmapViewOfFile((uint8_t*)mem + size);
+        UnmapViewOfFile(mem);
+    }
+#else
+    static int openAnonymousFile() {
+#if defined(SYS_memfd_create)
+        return syscall(SYS_memfd_create, "sdrpp_mirror", 0);
+#elif defined(__ANDROID__)
+        return -1;
+#else
+        // Use a unique name that is unlinked right away
+        static std::atomic<int> counter = 0;
+        std::string name = "/sdrpp_mirror_" + std::to_string(getpid()) + "_" + std::to_string(counter++);
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd >= 0) { shm_unlink(name.c_str()); }
+        return fd;
+#endif
+    }
+
+    void* allocMirrored(size_t& size) {
+        size_t gran = sysconf(_SC_PAGESIZE);
+        size = ((size + gran - 1) / gran) * gran;
+
+        int fd = openAnonymousFile();
+        if (fd < 0) { return NULL; }
+        if (ftruncate(fd, size) < 0) {
+            close(fd);
+            return NULL;
+        }
+
+        // Reserve the whole range, then replace each half with a view of the file
+        uint8_t* addr = (uint8_t*)mmap(NULL, size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            return NULL;
+        }
+        void* first = mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        void* second = mmap(addr + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        close(fd);
+        if (first != addr || second != addr + size) {
+            munmap(addr, size * 2);
+            return NULL;
+        }
+        return addr;
+    }
+
+    void freeMirrored(void* mem, size_t size) {
+        munmap(mem, size * 2);
+    }
+#endif
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <stddef.h>
+
+namespace dsp::buffer {
+    /**
+     * Allocate memory that is mapped twice, back to back. Anything written past the end of the
+     * first copy lands at its start, so any span starting in the first copy is contiguous.
+     * @param size Minimum size in bytes, rounded up to the allocation granularity of the system.
+     * @return Start of the first copy, NULL if not supported or if the mapping failed.
+     */
+    void* allocMirrored(size_t& size);
+
+    /**
+     * Free memory allocated with allocMirrored.
+     * @param mem Start of the first copy.
+     * @param size Size returned by allocMirrored.
+     */
+    void freeMirrored(void* mem, size_t size);
+}
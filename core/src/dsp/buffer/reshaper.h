@@ -99,32 +99,33 @@ namespace dsp::buffer {
         }
 
         void bufferWorker() {
-            T* buf = new T[_keep];
-            bool delay = _skip < 0;
-
-            int readCount = std::min<int>(_keep + _skip, _keep);
+            // With a negative skip, the start of each block repeats the end of the previous one
+            int delayCount = std::max<int>(-_skip, 0);
+            int readCount = _keep - delayCount;
             int skip = std::max<int>(_skip, 0);
-            int delaySize = (-_skip) * sizeof(T);
-            int delayCount = (-_skip);
-
-            T* start = &buf[std::max<int>(-_skip, 0)];
-            T* delayStart = &buf[_keep + _skip];
+            T* delayBuf = NULL;
+            if (delayCount) {
+                delayBuf = buffer::alloc<T>(delayCount);
+                buffer::clear(delayBuf, delayCount);
+            }
 
             while (true) {
-                if (delay) {
-                    memmove(buf, delayStart, delaySize);
+                if (delayCount) {
+                    memcpy(out.writeBuf, delayBuf, delayCount * sizeof(T));
                     if constexpr (std::is_same_v<T, complex_t> || std::is_same_v<T, stereo_t>) {
                         for (int i = 0; i < delayCount; i++) {
-                            buf[i].re /= 10.0f;
-                            buf[i].im /= 10.0f;
+                            out.writeBuf[i].re /= 10.0f;
+                            out.writeBuf[i].im /= 10.0f;
                         }
                     }
                 }
-                if (ringBuf.readAndSkip(start, readCount, skip) < 0) { break; };
-                memcpy(out.writeBuf, buf, _keep * sizeof(T));
+
+                // Copy the new samples straight from the ring into the output
+                if (ringBuf.readAndSkip(&out.writeBuf[delayCount], readCount, skip) < 0) { break; };
+                if (delayCount) { memcpy(delayBuf, &out.writeBuf[_keep - delayCount], delayCount * sizeof(T)); }
                 if (!out.swap(_keep)) { break; }
             }
-            delete[] buf;
+            if (delayBuf) { buffer::free(delayBuf); }
         }
 
         stream<T>* _in;
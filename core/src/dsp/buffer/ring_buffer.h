@@ -1,11 +1,18 @@
 #pragma once
 #include "buffer.h"
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+#include <assert.h>
+#include <stdint.h>
 
 #define RING_BUF_SZ 1000000
 
-// IMPORTANT: THIS IS TRASH AND MUST BE REWRITTEN IN THE FUTURE
-
 namespace dsp::buffer {
+    // Single producer single consumer ring buffer. Each position is only advanced by its own side so
+    // moving data never takes a lock, the mutex is only used to sleep when there is nothing to do.
+    // Data can be accessed in place through peek/consume and reserve/commit to avoid extra copies.
     template <class T>
     class RingBuffer {
     public:
@@ -26,86 +33,86 @@ namespace dsp::buffer {
             this->maxLatency = maxLatency;
             writec = 0;
             readc = 0;
-            readable = 0;
-            writable = size;
             _buffer = buffer::alloc<T>(size);
             buffer::clear(_buffer, size);
             _init = true;
         }
 
+        /**
+         * Wait for data and get a pointer to it. Reader side only.
+         * @param data Set to the first readable sample.
+         * @return Number of contiguous readable samples, up to the end of the buffer. -1 if the reader was stopped.
+         */
+        int peek(T*& data) {
+            int readable = waitUntilReadable();
+            if (readable < 0) { return -1; }
+            int pos = readc.load(std::memory_order_relaxed) % size;
+            data = &_buffer[pos];
+            return std::min<int>(readable, size - pos);
+        }
+
+        /**
+         * Release samples returned by peek. Reader side only.
+         * @param count Number of samples to release.
+         */
+        void consume(int count) {
+            readc.fetch_add(count);
+            if (writerWaiting) { wake(canWriteVar); }
+        }
+
+        /**
+         * Wait for free space and get a pointer to it. Writer side only.
+         * @param data Set to the first writable sample.
+         * @return Number of contiguous writable samples, up to the end of the buffer. -1 if the writer was stopped.
+         */
+        int reserve(T*& data) {
+            int writable = waitUntilwritable();
+            if (writable < 0) { return -1; }
+            int pos = writec.load(std::memory_order_relaxed) % size;
+            data = &_buffer[pos];
+            return std::min<int>(writable, size - pos);
+        }
+
+        /**
+         * Make samples written through reserve available to the reader. Writer side only.
+         * @param count Number of samples to commit.
+         */
+        void commit(int count) {
+            writec.fetch_add(count);
+            if (readerWaiting) { wake(canReadVar); }
+        }
+
         int read(T* data, int len) {
             assert(_init);
             int dataRead = 0;
-            int toRead = 0;
             while (dataRead < len) {
-                toRead = std::min<int>(waitUntilReadable(), len - dataRead);
-                if (toRead < 0) { return -1; };
-
-                if ((toRead + readc) > size) {
-                    memcpy(&data[dataRead], &_buffer[readc], (size - readc) * sizeof(T));
-                    memcpy(&data[dataRead + (size - readc)], &_buffer[0], (toRead - (size - readc)) * sizeof(T));
-                }
-                else {
-                    memcpy(&data[dataRead], &_buffer[readc], toRead * sizeof(T));
-                }
-
+                T* src;
+                int toRead = peek(src);
+                if (toRead < 0) { return -1; }
+                toRead = std::min<int>(toRead, len - dataRead);
+                memcpy(&data[dataRead], src, toRead * sizeof(T));
+                consume(toRead);
                 dataRead += toRead;
-
-                _readable_mtx.lock();
-                readable -= toRead;
-                _readable_mtx.unlock();
-                _writable_mtx.lock();
-                writable += toRead;
-                _writable_mtx.unlock();
-                readc = (readc + toRead) % size;
-                canWriteVar.notify_one();
             }
             return len;
         }
 
-        int readAndSkip(T* data, int len, int skip) {
+        int discard(int len) {
             assert(_init);
-            int dataRead = 0;
-            int toRead = 0;
-            while (dataRead < len) {
-                toRead = std::min<int>(waitUntilReadable(), len - dataRead);
-                if (toRead < 0) { return -1; };
-
-                if ((toRead + readc) > size) {
-                    memcpy(&data[dataRead], &_buffer[readc], (size - readc) * sizeof(T));
-                    memcpy(&data[dataRead + (size - readc)], &_buffer[0], (toRead - (size - readc)) * sizeof(T));
-                }
-                else {
-                    memcpy(&data[dataRead], &_buffer[readc], toRead * sizeof(T));
-                }
-
-                dataRead += toRead;
-
-                _readable_mtx.lock();
-                readable -= toRead;
-                _readable_mtx.unlock();
-                _writable_mtx.lock();
-                writable += toRead;
-                _writable_mtx.unlock();
-                readc = (readc + toRead) % size;
-                canWriteVar.notify_one();
+            int discarded = 0;
+            while (discarded < len) {
+                int toDiscard = waitUntilReadable();
+                if (toDiscard < 0) { return -1; }
+                toDiscard = std::min<int>(toDiscard, len - discarded);
+                consume(toDiscard);
+                discarded += toDiscard;
             }
-            dataRead = 0;
-            while (dataRead < skip) {
-                toRead = std::min<int>(waitUntilReadable(), skip - dataRead);
-                if (toRead < 0) { return -1; };
-
-                dataRead += toRead;
+            return len;
+        }
 
-                _readable_mtx.lock();
-                readable -= toRead;
-                _readable_mtx.unlock();
-                _writable_mtx.lock();
-                writable += toRead;
-                _writable_mtx.unlock();
-                readc = (readc + toRead) % size;
-                canWriteVar.notify_one();
-            }
+        int readAndSkip(T* data, int len, int skip) {
+            if (read(data, len) < 0) { return -1; }
+            if (discard(skip) < 0) { return -1; }
             return len;
         }
 
@@ -114,47 +121,32 @@ namespace dsp::buffer {
             if (_stopReader) { return -1; }
             int _r = getReadable();
             if (_r != 0) { return _r; }
-            std::unique_lock<std::mutex> lck(_readable_mtx);
-            canReadVar.wait(lck, [=]() { return ((this->getReadable(false) > 0) || this->getReadStop()); });
+
+            // The flag is set before checking again, so that the writer either sees it or we see its data
+            std::unique_lock<std::mutex> lck(waitMtx);
+            readerWaiting = true;
+            canReadVar.wait(lck, [=]() { return ((this->getReadable() > 0) || this->getReadStop()); });
+            readerWaiting = false;
             if (_stopReader) { return -1; }
-            return getReadable(false);
+            return getReadable();
         }
 
-        int getReadable(bool lock = true) {
+        int getReadable() {
             assert(_init);
-            if (lock) { _readable_mtx.lock(); };
-            int _r = readable;
-            if (lock) { _readable_mtx.unlock(); };
-            return _r;
+            return (int)(writec.load() - readc.load());
         }
 
         int write(T* data, int len) {
             assert(_init);
             int dataWritten = 0;
-            int toWrite = 0;
             while (dataWritten < len) {
-                toWrite = std::min<int>(waitUntilwritable(), len - dataWritten);
-                if (toWrite < 0) { return -1; };
-
-                if ((toWrite + writec) > size) {
-                    memcpy(&_buffer[writec], &data[dataWritten], (size - writec) * sizeof(T));
-                    memcpy(&_buffer[0], &data[dataWritten + (size - writec)], (toWrite - (size - writec)) * sizeof(T));
-                }
-                else {
-                    memcpy(&_buffer[writec], &data[dataWritten], toWrite * sizeof(T));
-                }
-
+                T* dst;
+                int toWrite = reserve(dst);
+                if (toWrite < 0) { return -1; }
+                toWrite = std::min<int>(toWrite, len - dataWritten);
+                memcpy(dst, &data[dataWritten], toWrite * sizeof(T));
+                commit(toWrite);
                 dataWritten += toWrite;
-
-                _readable_mtx.lock();
-                readable += toWrite;
-                _readable_mtx.unlock();
-                _writable_mtx.lock();
-                writable -= toWrite;
-                _writable_mtx.unlock();
-                writec = (writec + toWrite) % size;
-
-                canReadVar.notify_one();
             }
             return len;
         }
@@ -164,35 +156,31 @@ namespace dsp::buffer {
             if (_stopWriter) { return -1; }
             int _w = getWritable();
             if (_w != 0) { return _w; }
-            std::unique_lock<std::mutex> lck(_writable_mtx);
-            canWriteVar.wait(lck, [=]() { return ((this->getWritable(false) > 0) || this->getWriteStop()); });
+
+            std::unique_lock<std::mutex> lck(waitMtx);
+            writerWaiting = true;
+            canWriteVar.wait(lck, [=]() { return ((this->getWritable() > 0) || this->getWriteStop()); });
+            writerWaiting = false;
             if (_stopWriter) { return -1; }
-            return getWritable(false);
+            return getWritable();
         }
 
-        int getWritable(bool lock = true) {
+        int getWritable() {
             assert(_init);
-            if (lock) { _writable_mtx.lock(); };
-            int _w = writable;
-            if (lock) {
-                _writable_mtx.unlock();
-                _readable_mtx.lock();
-            };
-            int _r = readable;
-            if (lock) { _readable_mtx.unlock(); };
-            return std::max<int>(std::min<int>(_w, maxLatency - _r), 0);
+            int _r = getReadable();
+            return std::max<int>(std::min<int>(size - _r, maxLatency - _r), 0);
         }
 
         void stopReader() {
             assert(_init);
             _stopReader = true;
-            canReadVar.notify_one();
+            wake(canReadVar);
         }
 
         void stopWriter() {
             assert(_init);
             _stopWriter = true;
-            canWriteVar.notify_one();
+            wake(canWriteVar);
         }
 
         bool getReadStop() {
@@ -218,22 +206,31 @@ namespace dsp::buffer {
         void setMaxLatency(int maxLatency) {
             assert(_init);
             this->maxLatency = maxLatency;
+            wake(canWriteVar);
         }
 
     private:
+        void wake(std::condition_variable& cv) {
+            // Taking the lock guarantees that the other side is either waiting or hasn't checked its condition yet
+            { std::lock_guard<std::mutex> lck(waitMtx); }
+            cv.notify_all();
+        }
+
         bool _init = false;
         T* _buffer;
         int size;
-        int readc;
-        int writec;
-        int readable;
-        int writable;
-        int maxLatency;
-        bool _stopReader;
-        bool _stopWriter;
-        std::mutex _readable_mtx;
-        std::mutex _writable_mtx;
+        std::atomic<int> maxLatency;
+        std::atomic<bool> _stopReader;
+        std::atomic<bool> _stopWriter;
+
+        // Total number of samples read and written, kept on separate cache lines
+        alignas(64) std::atomic<uint64_t> readc;
+        alignas(64) std::atomic<uint64_t> writec;
+
+        std::atomic<bool> readerWaiting = false;
+        std::atomic<bool> writerWaiting = false;
+        std::mutex waitMtx;
         std::condition_variable canReadVar;
         std::condition_variable canWriteVar;
     };
-}
\ No newline at end of file
+}
@@ -0,0 +1,261 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <string.h>
+#include <math.h>
+#include <fftw3.h>
+#include "../types.h"
+#include "../buffer/buffer.h"
+
+namespace dsp::channel {
+    // Fast convolution (overlap-save) channelizer.
+    // One forward FFT of the input is shared by all channels, each enabled channel then only costs
+    // a small inverse FFT that directly produces its decimated output. Channel power is measured
+    // for every channel, even disabled ones, so it can be used for carrier detection.
+    class FFTChannelizer {
+    public:
+        typedef void (*Handler)(int channel, complex_t* data, int count, void* ctx);
+
+        FFTChannelizer() {}
+
+        FFTChannelizer(double samplerate, double channelSamplerate, double passBand, int channelBins = 64) { init(samplerate, channelSamplerate, passBand, channelBins); }
+
+        ~FFTChannelizer() {
+            destroy();
+        }
+
+        void init(double samplerate, double channelSamplerate, double passBand, int channelBins = 64) {
+            destroy();
+
+            // Derive the FFT sizes from the integer decimation closest to the requested channel samplerate
+            _samplerate = samplerate;
+            _channelBins = channelBins;
+            _decim = std::max<int>(1, round(samplerate / channelSamplerate));
+            _fftSize = _channelBins * _decim;
+            _channelSamplerate = _samplerate / (double)_decim;
+            _passBand = passBand;
+
+            fftIn = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
+            fftOut = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
+            ifftIn = (fftwf_complex*)fftwf_malloc(_channelBins * sizeof(fftwf_complex));
+            ifftOut = (fftwf_complex*)fftwf_malloc(_channelBins * sizeof(fftwf_complex));
+            fftPlan = fftwf_plan_dft_1d(_fftSize, fftIn, fftOut, FFTW_FORWARD, FFTW_ESTIMATE);
+            ifftPlan = fftwf_plan_dft_1d(_channelBins, ifftIn, ifftOut, FFTW_BACKWARD, FFTW_ESTIMATE);
+            buffer::clear((complex_t*)fftIn, _fftSize);
+
+            // Design the channel response directly in the frequency domain, flat in the pass band
+            // with a raised cosine transition to the edge of the channel. Bins are in IFFT order.
+            response.resize(_channelBins);
+            double binWidth = _channelSamplerate / (double)_channelBins;
+            double edge = _channelSamplerate / 2.0;
+            for (int i = 0; i < _channelBins; i++) {
+                double freq = fabs((double)((i < _channelBins / 2) ? i : (i - _channelBins)) * binWidth);
+                float gain;
+                if (freq <= _passBand) {
+                    gain = 1.0f;
+                }
+                else if (freq >= edge) {
+                    gain = 0.0f;
+                }
+                else {
+                    gain = 0.5f + 0.5f * cosf(FL_M_PI * (freq - _passBand) / (edge - _passBand));
+                }
+
+                response[i] = gain;
+            }
+            limitImpulse();
+
+            channels.clear();
+            fill = _fftSize / 2;
+            block = 0;
+        }
+
+        /**
+         * Add a channel.
+         * @param offset Offset of the channel from the center of the input in Hz.
+         * @return ID of the channel.
+         */
+        int addChannel(double offset, bool enabled = true) {
+            Channel ch;
+            ch.offset = offset;
+            ch.enabled = enabled;
+            channels.push_back(ch);
+            retune(channels.size() - 1, offset);
+            return channels.size() - 1;
+        }
+
+        void clearChannels() {
+            channels.clear();
+        }
+
+        void retune(int id, double offset) {
+            Channel& ch = channels[id];
+            ch.offset = offset;
+            ch.bin = round(offset * (double)_fftSize / _samplerate);
+            ch.residual = offset - ((double)ch.bin * _samplerate / (double)_fftSize);
+        }
+
+        void setChannelEnabled(int id, bool enabled) {
+            channels[id].enabled = enabled;
+        }
+
+        bool isChannelEnabled(int id) { return channels[id].enabled; }
+
+        // Residual offset in Hz between the requested channel offset and the center of its FFT bin
+        double getResidualOffset(int id) { return channels[id].residual; }
+
+        // Pass band power of the channel in dBFS, averaged over time
+        float getChannelPower(int id) { return 10.0f * log10f(std::max<float>(channels[id].power, 1e-20f)); }
+
+        int getChannelCount() { return channels.size(); }
+
+        double getChannelSamplerate() { return _channelSamplerate; }
+
+        // Number of samples given to the handler at once for each channel
+        int getOutputBlockSize() { return _channelBins / 2; }
+
+        /**
+         * Process input samples. The handler is called for every enabled channel each time a full block is available.
+         * @param count Number of input samples.
+         * @param in Input samples.
+         * @param handler Function called with the output of each enabled channel.
+         * @param ctx Context given to the handler.
+         */
+        void process(int count, const complex_t* in, Handler handler, void* ctx) {
+            complex_t* fin = (complex_t*)fftIn;
+            while (count) {
+                // Fill the second half of the FFT input
+                int toCopy = std::min<int>(count, _fftSize - fill);
+                memcpy(&fin[fill], in, toCopy * sizeof(complex_t));
+                fill += toCopy;
+                in += toCopy;
+                count -= toCopy;
+                if (fill < _fftSize) { break; }
+
+                processBlock(handler, ctx);
+
+                // Keep the second half as the overlap for the next block
+                memmove(fin, &fin[_fftSize / 2], (_fftSize / 2) * sizeof(complex_t));
+                fill = _fftSize / 2;
+            }
+        }
+
+    private:
+        struct Channel {
+            double offset;
+            double residual;
+            int bin;
+            bool enabled;
+            float power = 0.0f;
+        };
+
+        void processBlock(Handler handler, void* ctx) {
+            fftwf_execute(fftPlan);
+            complex_t* fout = (complex_t*)fftOut;
+            complex_t* iin = (complex_t*)ifftIn;
+            complex_t* iout = (complex_t*)ifftOut;
+            int half = _channelBins / 2;
+            float scale = 1.0f / (float)_fftSize;
+            float norm = scale * scale;
+
+            int chCount = channels.size();
+            for (int c = 0; c < chCount; c++) {
+                Channel& ch = channels[c];
+
+                // Extract the bins of the channel, applying its response
+                float power = 0.0f;
+                for (int i = 0; i < _channelBins; i++) {
+                    int bin = ch.bin + ((i < half) ? i : (i - _channelBins));
+                    bin = ((bin % _fftSize) + _fftSize) % _fftSize;
+                    complex_t val = fout[bin];
+                    if (response[i] >= 0.5f) {
+                        power += (val.re * val.re) + (val.im * val.im);
+                    }
+                    iin[i] = val * (response[i] * scale);
+                }
+                ch.power = (0.9f * ch.power) + (0.1f * power * norm);
+
+                if (!ch.enabled) { continue; }
+
+                fftwf_execute(ifftPlan);
+
+                // The impulse is zero-phase and spans a quarter block on each side, so the first and
+                // last quarters are circularly aliased and only the middle half is valid
+                complex_t* valid = &iout[_channelBins / 4];
+
+                // Undo the phase jump between blocks caused by the 50% overlap when the channel bin is odd
+                if ((ch.bin & 1) && (block & 1)) {
+                    for (int i = 0; i < half; i++) {
+                        valid[i].re = -valid[i].re;
+                        valid[i].im = -valid[i].im;
+                    }
+                }
+
+                handler(c, valid, half, ctx);
+            }
+
+            block++;
+        }
+
+        // Only half of each block is kept, so the impulse response must fit in half a block or the
+        // output is aliased in time. Window the zero-phase impulse of the sampled response to +/- a quarter block.
+        void limitImpulse() {
+            int n = _channelBins;
+            int half = n / 4;
+            std::vector<float> impulse(n);
+            for (int t = 0; t < n; t++) {
+                int dt = (t < n / 2) ? t : (t - n);
+                if (abs(dt) >= half) {
+                    impulse[t] = 0.0f;
+                    continue;
+                }
+                double acc = 0.0;
+                for (int k = 0; k < n; k++) {
+                    acc += response[k] * cos(2.0 * FL_M_PI * (double)k * (double)t / (double)n);
+                }
+                float win = 0.5f + 0.5f * cosf(FL_M_PI * (float)dt / (float)half);
+                impulse[t] = (acc / (double)n) * win;
+            }
+
+            // Back to the frequency domain, the response is real and symmetric
+            for (int k = 0; k < n; k++) {
+                double acc = 0.0;
+                for (int t = 0; t < n; t++) {
+                    acc += impulse[t] * cos(2.0 * FL_M_PI * (double)k * (double)t / (double)n);
+                }
+                response[k] = acc;
+            }
+        }
+
+        void destroy() {
+            if (!fftIn) { return; }
+            fftwf_destroy_plan(fftPlan);
+            fftwf_destroy_plan(ifftPlan);
+            fftwf_free(fftIn);
+            fftwf_free(fftOut);
+            fftwf_free(ifftIn);
+            fftwf_free(ifftOut);
+            fftIn = NULL;
+        }
+
+        double _samplerate;
+        double _channelSamplerate;
+        double _passBand;
+        int _channelBins;
+        int _decim;
+        int _fftSize;
+
+        std::vector<Channel> channels;
+        std::vector<float> response;
+
+        fftwf_complex* fftIn = NULL;
+        fftwf_complex* fftOut = NULL;
+        fftwf_complex* ifftIn = NULL;
+        fftwf_complex* ifftOut = NULL;
+        fftwf_plan fftPlan;
+        fftwf_plan ifftPlan;
+
+        int fill;
+        uint64_t block;
+    };
+}
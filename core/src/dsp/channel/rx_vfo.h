@@ -1,6 +1,7 @@
 #pragma once
 #include "frequency_xlator.h"
 #include "../multirate/rational_resampler.h"
+#include "../taps/design_service.h"
 
 namespace dsp::channel {
     class RxVFO : public Processor<complex_t, complex_t> {
@@ -13,7 +14,7 @@ namespace dsp::channel {
         ~RxVFO() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            taps::free(ftaps);
+            taps::DesignService::instance().cancel(this);
         }
 
         void init(stream<complex_t>* in, double inSamplerate, double outSamplerate, double bandwidth, double offset) {
@@ -22,16 +23,28 @@ namespace dsp::channel {
             _bandwidth = bandwidth;
             _offset = offset;
             filterNeeded = (_bandwidth != _outSamplerate);
-            ftaps.taps = NULL;
 
             xlator.init(NULL, -_offset, _inSamplerate);
             resamp.init(NULL, _inSamplerate, _outSamplerate);
-            generateTaps();
-            filter.init(NULL, ftaps);
+            ftaps = taps::DesignService::instance().design(filterSpec());
+            tap<float> t = *ftaps;
+            filter.init(NULL, t);
+            _out = &out;
 
             base_type::init(in);
         }
 
+        // Write into the given stream instead of the block's own output, NULL to go back to it
+        void setOutput(stream<complex_t>* output) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            base_type::unregisterOutput(_out);
+            _out = output ? output : &out;
+            base_type::registerOutput(_out);
+            base_type::tempStart();
+        }
+
         void setInSamplerate(double inSamplerate) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
@@ -51,8 +64,9 @@ namespace dsp::channel {
             filterNeeded = (_bandwidth != _outSamplerate);
             resamp.setOutSamplerate(_outSamplerate);
             if (filterNeeded) {
-                generateTaps();
-                filter.setTaps(ftaps);
+                // A bandwidth change still being designed would be for the old samplerate
+                taps::DesignService::instance().cancel(this);
+                filter.pushTaps(taps::DesignService::instance().design(filterSpec()));
             }
             base_type::tempStart();
         }
@@ -60,13 +74,18 @@ namespace dsp::channel {
         void setBandwidth(double bandwidth) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            std::lock_guard<std::mutex> lck2(filterMtx);
             _bandwidth = bandwidth;
-            filterNeeded = (_bandwidth != _outSamplerate);
-            if (filterNeeded) {
-                generateTaps();
-                filter.setTaps(ftaps);
+            if (_bandwidth == _outSamplerate) {
+                taps::DesignService::instance().cancel(this);
+                filterNeeded = false;
+                return;
             }
+
+            // The taps are designed in the background and swapped in by the DSP thread
+            taps::DesignService::instance().designAsync(this, filterSpec(), [this](taps::shared_taps t) {
+                filter.pushTaps(t);
+                filterNeeded = true;
+            });
         }
 
         void setOffset(double offset) {
@@ -92,10 +111,7 @@ namespace dsp::channel {
                 return resamp.process(count, out, out);
             }
             count = resamp.process(count, out, out);
-            {
-                std::lock_guard<std::mutex> lck(filterMtx);
-                filter.process(count, out, out);
-            }
+            filter.process(count, out, out);
             return count;
         }
 
@@ -103,34 +119,32 @@ namespace dsp::channel {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
-            int outCount = process(count, base_type::_in->readBuf, out.writeBuf);
+            int outCount = process(count, base_type::_in->readBuf, _out->writeBuf);
 
             // Swap if some data was generated
             base_type::_in->flush();
             if (outCount) {
-                if (!out.swap(outCount)) { return -1; }
+                if (!_out->swap(outCount)) { return -1; }
             }
             return outCount;
         }
 
     protected:
-        void generateTaps() {
-            taps::free(ftaps);
+        taps::FilterSpec filterSpec() {
             double filterWidth = _bandwidth / 2.0;
-            ftaps = taps::lowPass(filterWidth, filterWidth * 0.1, _outSamplerate);
+            return taps::lowPassSpec(filterWidth, filterWidth * 0.1, _outSamplerate);
         }
 
         FrequencyXlator xlator;
         multirate::RationalResampler<complex_t> resamp;
         filter::FIR<complex_t, float> filter;
-        tap<float> ftaps;
-        bool filterNeeded;
+        taps::shared_taps ftaps;
+        std::atomic<bool> filterNeeded;
+        stream<complex_t>* _out;
 
         double _inSamplerate;
         double _outSamplerate;
         double _bandwidth;
         double _offset;
-
-        std::mutex filterMtx;
     };
 }
\ No newline at end of file
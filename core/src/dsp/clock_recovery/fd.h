@@ -4,6 +4,7 @@
 #include "../taps/windowed_sinc.h"
 #include "../multirate/polyphase_bank.h"
 #include "../math/step.h"
+#include "../buffer/history.h"
 
 namespace dsp::clock_recovery {
     class FD : public Processor<float, float> {
@@ -17,7 +18,6 @@ namespace dsp::clock_recovery {
             if (!base_type::_block_init) { return; }
             base_type::stop();
             dsp::multirate::freePolyphaseBank(interpBank);
-            buffer::free(buffer);
         }
 
         void init(stream<float>* in, double omega, double omegaGain, double muGain, double omegaRelLimit, int interpPhaseCount = 128, int interpTapCount = 8) {
@@ -30,8 +30,7 @@ namespace dsp::clock_recovery {
 
             pcl.init(_muGain, _omegaGain, 0.0, 0.0, 1.0, _omega, _omega * (1.0 - omegaRelLimit), _omega * (1.0 + omegaRelLimit));
             generateInterpTaps();
-            buffer = buffer::alloc<float>(STREAM_BUFFER_SIZE + _interpTapCount);
-            bufStart = &buffer[_interpTapCount - 1];
+            history.init(_interpTapCount - 1);
         
             base_type::init(in);
         }
@@ -76,10 +75,9 @@ namespace dsp::clock_recovery {
             _interpPhaseCount = interpPhaseCount;
             _interpTapCount = interpTapCount;
             dsp::multirate::freePolyphaseBank(interpBank);
-            buffer::free(buffer);
             generateInterpTaps();
-            buffer = buffer::alloc<float>(STREAM_BUFFER_SIZE + _interpTapCount);
-            bufStart = &buffer[_interpTapCount - 1];
+            history.setLength(_interpTapCount - 1);
+            history.clear();
             base_type::tempStart();
         }
 
@@ -94,8 +92,8 @@ namespace dsp::clock_recovery {
         }
 
         inline int process(int count, const float* in, float* out) {
-            // Copy data to work buffer
-            memcpy(bufStart, in, count * sizeof(float));
+            // Append data to the history
+            float* buffer = history.push(in, count);
 
             // Process all samples
             int outCount = 0;
@@ -143,9 +141,6 @@ namespace dsp::clock_recovery {
             }
             offset -= count;
 
-            // Update delay buffer
-            memmove(buffer, &buffer[count], (_interpTapCount - 1) * sizeof(float));
-
             return outCount;
         }
 
@@ -183,7 +178,6 @@ namespace dsp::clock_recovery {
         int _interpTapCount;
 
         int offset = 0;
-        float* buffer;
-        float* bufStart;
+        buffer::History<float> history;
     };
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "../taps/windowed_sinc.h"
 #include "../multirate/polyphase_bank.h"
 #include "../math/step.h"
+#include "../buffer/history.h"
 
 namespace dsp::clock_recovery {
     template<class T>
@@ -18,7 +19,6 @@ namespace dsp::clock_recovery {
             if (!base_type::_block_init) { return; }
             base_type::stop();
             dsp::multirate::freePolyphaseBank(interpBank);
-            buffer::free(buffer);
         }
 
         void init(stream<T>* in, double omega, double omegaGain, double muGain, double omegaRelLimit, int interpPhaseCount = 128, int interpTapCount = 8) {
@@ -31,8 +31,7 @@ namespace dsp::clock_recovery {
 
             pcl.init(_muGain, _omegaGain, 0.0, 0.0, 1.0, _omega, _omega * (1.0 - omegaRelLimit), _omega * (1.0 + omegaRelLimit));
             generateInterpTaps();
-            buffer = buffer::alloc<T>(STREAM_BUFFER_SIZE + _interpTapCount);
-            bufStart = &buffer[_interpTapCount - 1];
+            history.init(_interpTapCount - 1);
         
             base_type::init(in);
         }
@@ -77,10 +76,9 @@ namespace dsp::clock_recovery {
             _interpPhaseCount = interpPhaseCount;
             _interpTapCount = interpTapCount;
             dsp::multirate::freePolyphaseBank(interpBank);
-            buffer::free(buffer);
             generateInterpTaps();
-            buffer = buffer::alloc<T>(STREAM_BUFFER_SIZE + _interpTapCount);
-            bufStart = &buffer[_interpTapCount - 1];
+            history.setLength(_interpTapCount - 1);
+            history.clear();
             base_type::tempStart();
         }
 
@@ -98,8 +96,8 @@ namespace dsp::clock_recovery {
         }
 
         inline int process(int count, const T* in, T* out) {
-            // Copy data to work buffer
-            memcpy(bufStart, in, count * sizeof(T));
+            // Append data to the history
+            T* buffer = history.push(in, count);
 
             // Process all samples
             int outCount = 0;
@@ -149,9 +147,6 @@ namespace dsp::clock_recovery {
             }
             offset -= count;
 
-            // Update delay buffer
-            memmove(buffer, &buffer[count], (_interpTapCount - 1) * sizeof(T));
-
             return outCount;
         }
 
@@ -193,7 +188,6 @@ namespace dsp::clock_recovery {
         complex_t _c_0T = { 0.0f, 0.0f }, _c_1T = { 0.0f, 0.0f }, _c_2T = { 0.0f, 0.0f };
 
         int offset = 0;
-        T* buffer;
-        T* bufStart;
+        buffer::History<T> history;
     };
 }
\ No newline at end of file
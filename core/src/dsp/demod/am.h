@@ -4,7 +4,7 @@
 #include "../correction/dc_blocker.h"
 #include "../convert/mono_to_stereo.h"
 #include "../filter/fir.h"
-#include "../taps/low_pass.h"
+#include "../taps/design_service.h"
 
 namespace dsp::demod {
     template <class T>
@@ -23,7 +23,7 @@ namespace dsp::demod {
         ~AM() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            taps::free(lpfTaps);
+            taps::DesignService::instance().cancel(this);
         }
 
         void init(stream<complex_t>* in, AGCMode agcMode, double bandwidth, double agcAttack, double agcDecay, double dcBlockRate, double samplerate) {
@@ -34,8 +34,9 @@ namespace dsp::demod {
             carrierAgc.init(NULL, 1.0, agcAttack, agcDecay, 10e6, 10.0, INFINITY);
             audioAgc.init(NULL, 1.0, agcAttack, agcDecay, 10e6, 10.0, INFINITY);
             dcBlock.init(NULL, dcBlockRate);
-            lpfTaps = taps::lowPass(bandwidth / 2.0, (bandwidth / 2.0) * 0.1, samplerate);
-            lpf.init(NULL, lpfTaps);
+            lpfTaps = taps::DesignService::instance().design(taps::lowPassSpec(bandwidth / 2.0, (bandwidth / 2.0) * 0.1, samplerate));
+            tap<float> t = *lpfTaps;
+            lpf.init(NULL, t);
 
             if constexpr (std::is_same_v<T, float>) {
                 audioAgc.out.free();
@@ -60,10 +61,9 @@ namespace dsp::demod {
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             if (bandwidth == _bandwidth) { return; }
             _bandwidth = bandwidth;
-            std::lock_guard<std::mutex> lck2(lpfMtx);
-            taps::free(lpfTaps);
-            lpfTaps = taps::lowPass(_bandwidth / 2.0, (_bandwidth / 2.0) * 0.1, _samplerate);
-            lpf.setTaps(lpfTaps);
+            taps::DesignService::instance().designAsync(this, taps::lowPassSpec(_bandwidth / 2.0, (_bandwidth / 2.0) * 0.1, _samplerate), [this](taps::shared_taps t) {
+                lpf.pushTaps(t);
+            });
         }
 
         void setAGCAttack(double attack) {
@@ -111,10 +111,7 @@ namespace dsp::demod {
                 if (_agcMode == AGCMode::AUDIO) {
                     audioAgc.process(count, out, out);
                 }
-                {
-                    std::lock_guard<std::mutex> lck(lpfMtx);
-                    lpf.process(count, out, out);
-                }
+                lpf.process(count, out, out);
             }
             if constexpr (std::is_same_v<T, stereo_t>) {
                 volk_32fc_magnitude_32f(audioAgc.out.writeBuf, (lv_32fc_t*)in, count);
@@ -122,10 +119,7 @@ namespace dsp::demod {
                 if (_agcMode == AGCMode::AUDIO) {
                     audioAgc.process(count, audioAgc.out.writeBuf, audioAgc.out.writeBuf);
                 }
-                {
-                    std::lock_guard<std::mutex> lck(lpfMtx);
-                    lpf.process(count, audioAgc.out.writeBuf, audioAgc.out.writeBuf);
-                }
+                lpf.process(count, audioAgc.out.writeBuf, audioAgc.out.writeBuf);
                 convert::MonoToStereo::process(count, audioAgc.out.writeBuf, out);
             }
 
@@ -152,9 +146,8 @@ namespace dsp::demod {
         loop::AGC<complex_t> carrierAgc;
         loop::AGC<float> audioAgc;
         correction::DCBlocker<float> dcBlock;
-        tap<float> lpfTaps;
+        taps::shared_taps lpfTaps;
         filter::FIR<float, float> lpf;
-        std::mutex lpfMtx;
 
     };
 }
\ No newline at end of file
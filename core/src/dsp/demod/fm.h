@@ -2,9 +2,8 @@
 #include "../processor.h"
 #include "quadrature.h"
 #include "../filter/fir.h"
-#include "../taps/low_pass.h"
-#include "../taps/high_pass.h"
-#include "../taps/band_pass.h"
+#include "../taps/from_array.h"
+#include "../taps/design_service.h"
 #include "../convert/mono_to_stereo.h"
 
 namespace dsp::demod {
@@ -19,7 +18,8 @@ namespace dsp::demod {
         ~FM() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            dsp::taps::free(filterTaps);
+            taps::DesignService::instance().cancel(this);
+            taps::free(dummyTaps);
         }
 
         void init(dsp::stream<dsp::complex_t>* in, double samplerate, double bandwidth, bool lowPass, bool highPass) {
@@ -29,11 +29,13 @@ namespace dsp::demod {
             _highPass = highPass;
 
             demod.init(NULL, bandwidth / 2.0, _samplerate);
-            loadDummyTaps();
-            fir.init(NULL, filterTaps);
+            // The FIR keeps using these taps until the designed ones are applied
+            float dummyTap = 1.0f;
+            dummyTaps = taps::fromArray<float>(1, &dummyTap);
+            fir.init(NULL, dummyTaps);
 
             // Initialize taps
-            updateFilter(lowPass, highPass);
+            updateFilter(lowPass, highPass, false);
 
             if constexpr (std::is_same_v<T, float>) {
                 demod.out.free();
@@ -49,7 +51,7 @@ namespace dsp::demod {
             base_type::tempStop();
             _samplerate = samplerate;
             demod.setDeviation(_bandwidth / 2.0, _samplerate);
-            updateFilter(_lowPass, _highPass);
+            updateFilter(_lowPass, _highPass, false);
             base_type::tempStart();
         }
 
@@ -59,19 +61,19 @@ namespace dsp::demod {
             if (bandwidth == _bandwidth) { return; }
             _bandwidth = bandwidth;
             demod.setDeviation(_bandwidth / 2.0, _samplerate);
-            updateFilter(_lowPass, _highPass);
+            updateFilter(_lowPass, _highPass, true);
         }
 
         void setLowPass(bool lowPass) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            updateFilter(lowPass, _highPass);
+            updateFilter(lowPass, _highPass, true);
         }
 
         void setHighPass(bool highPass) {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            updateFilter(_lowPass, highPass);
+            updateFilter(_lowPass, highPass, true);
         }
 
         void reset() {
@@ -87,14 +89,12 @@ namespace dsp::demod {
             if constexpr (std::is_same_v<T, float>) {
                 demod.process(count, in, out);
                 if (filtering) {
-                    std::lock_guard<std::mutex> lck(filterMtx);
                     fir.process(count, out, out);
                 }
             }
             if constexpr (std::is_same_v<T, stereo_t>) {
                 demod.process(count, in, demod.out.writeBuf);
                 if (filtering) {
-                    std::lock_guard<std::mutex> lck(filterMtx);
                     fir.process(count, demod.out.writeBuf, demod.out.writeBuf);
                 }
                 convert::MonoToStereo::process(count, demod.out.writeBuf, out);
@@ -114,50 +114,55 @@ namespace dsp::demod {
         }
 
     private:
-        void updateFilter(bool lowPass, bool highPass) {
-            std::lock_guard<std::mutex> lck(filterMtx);
-
-            // Update values
+        // Update the post-demodulation filter. When async, the taps are designed in the background and
+        // swapped in by the DSP thread, otherwise the block must be stopped.
+        void updateFilter(bool lowPass, bool highPass, bool async) {
             _lowPass = lowPass;
             _highPass = highPass;
-            filtering = (lowPass || highPass);
 
-            // Free filter taps
-            dsp::taps::free(filterTaps);
+            // A pending design would be for the old parameters
+            if (!async || (!lowPass && !highPass)) {
+                taps::DesignService::instance().cancel(this);
+            }
+            if (!lowPass && !highPass) {
+                filtering = false;
+                return;
+            }
 
             // Generate filter depending on low and high pass settings
+            taps::FilterSpec spec;
             if (_lowPass && _highPass) {
-                filterTaps = dsp::taps::bandPass<float>(300.0, _bandwidth / 2.0, 100.0, _samplerate);
+                spec = taps::bandPassSpec(300.0, _bandwidth / 2.0, 100.0, _samplerate);
             }
             else if (_highPass) {
-                filterTaps = dsp::taps::highPass(300.0, 100.0, _samplerate);
-            }
-            else if (_lowPass) {
-                filterTaps = dsp::taps::lowPass(_bandwidth / 2.0, (_bandwidth / 2.0) * 0.1, _samplerate);
+                spec = taps::highPassSpec(300.0, 100.0, _samplerate);
             }
             else {
-                loadDummyTaps();
+                spec = taps::lowPassSpec(_bandwidth / 2.0, (_bandwidth / 2.0) * 0.1, _samplerate);
             }
 
-            // Set filter to use new taps
-            fir.setTaps(filterTaps);
-            fir.reset();
-        }
-
-        void loadDummyTaps() {
-            float dummyTap = 1.0f;
-            filterTaps = dsp::taps::fromArray<float>(1, &dummyTap);
+            // Filtering starts once the taps are in
+            if (async) {
+                taps::DesignService::instance().designAsync(this, spec, [this](taps::shared_taps t) {
+                    fir.pushTaps(t);
+                    filtering = true;
+                });
+            }
+            else {
+                fir.pushTaps(taps::DesignService::instance().design(spec));
+                fir.reset();
+                filtering = true;
+            }
         }
 
         double _samplerate;
         double _bandwidth;
         bool _lowPass;
         bool _highPass;
-        bool filtering;
+        std::atomic<bool> filtering;
 
         Quadrature demod;
-        tap<float> filterTaps;
         filter::FIR<float, float> fir;
-        std::mutex filterMtx;
+        tap<float> dummyTaps;
     };
 }
\ No newline at end of file
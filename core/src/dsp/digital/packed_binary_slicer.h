@@ -0,0 +1,67 @@
+#pragma once
+#include "../processor.h"
+
+namespace dsp::digital {
+    // Packed bit streams carry 8 bits per byte, first received bit in the MSB.
+    // Bits that don't fill up a complete byte are kept until the next call.
+    class BitPackerState {
+    public:
+        inline void reset() {
+            acc = 0;
+            accBits = 0;
+        }
+
+        inline void push(int bits, uint8_t value, uint8_t* out, int& outCount) {
+            acc = (acc << bits) | value;
+            accBits += bits;
+            if (accBits >= 8) {
+                accBits -= 8;
+                out[outCount++] = acc >> accBits;
+            }
+        }
+
+    private:
+        uint32_t acc = 0;
+        int accBits = 0;
+    };
+
+    class PackedBinarySlicer : public Processor<float, uint8_t> {
+        using base_type = Processor<float, uint8_t>;
+    public:
+        PackedBinarySlicer() {}
+
+        PackedBinarySlicer(stream<float> *in) { base_type::init(in); }
+
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            packer.reset();
+            base_type::tempStart();
+        }
+
+        inline int process(int count, const float* in, uint8_t* out) {
+            int outCount = 0;
+            for (int i = 0; i < count; i++) {
+                packer.push(1, in[i] > 0.0f, out, outCount);
+            }
+            return outCount;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        BitPackerState packer;
+    };
+}
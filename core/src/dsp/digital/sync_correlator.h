@@ -0,0 +1,131 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace dsp::digital {
+    inline int popcount64(uint64_t x) {
+#if defined(_MSC_VER) && defined(_M_X64)
+        return (int)__popcnt64(x);
+#elif defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(x);
+#else
+        // SWAR fallback
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return (int)((x * 0x0101010101010101ULL) >> 56);
+#endif
+    }
+
+    /**
+     * Sliding sync word correlator.
+     * Bits are shifted into a 64bit register and compared against every registered sync word
+     * using the hamming distance. A match is reported when the distance is below or equal to
+     * the configured error threshold, allowing sync to be acquired despite bit errors.
+     * When several sync words are equally close no match is reported, the threshold must be
+     * kept low enough for words that differ in few bits to be told apart.
+     */
+    class SyncCorrelator {
+    public:
+        SyncCorrelator() {}
+
+        SyncCorrelator(int syncLength, int maxErrors) { init(syncLength, maxErrors); }
+
+        void init(int syncLength, int maxErrors) {
+            _syncLength = syncLength;
+            _maxErrors = maxErrors;
+            _mask = (syncLength >= 64) ? ~0ULL : ((1ULL << syncLength) - 1ULL);
+            syncWords.clear();
+            reset();
+        }
+
+        /**
+         * Register a sync word. The first bit received is the MSB of the word.
+         * @param word Sync word, right aligned.
+         * @return ID of the sync word as returned by push().
+         */
+        int addSyncWord(uint64_t word) {
+            syncWords.push_back(word & _mask);
+            return syncWords.size() - 1;
+        }
+
+        /**
+         * Register a sync word given as an array with one bit per byte.
+         * @param bits Array of bits, first bit received first.
+         * @return ID of the sync word as returned by push().
+         */
+        int addSyncWord(const uint8_t* bits) {
+            uint64_t word = 0;
+            for (int i = 0; i < _syncLength; i++) {
+                word = (word << 1) | (bits[i] & 1);
+            }
+            return addSyncWord(word);
+        }
+
+        void setMaxErrors(int maxErrors) {
+            _maxErrors = maxErrors;
+        }
+
+        void reset() {
+            sr = 0;
+            filled = 0;
+            lastDist = 0;
+        }
+
+        /**
+         * Shift a bit into the correlator.
+         * @param bit Bit to shift in, must be 0 or 1.
+         * @return ID of the closest matching sync word or -1 if none is within the error threshold.
+         */
+        inline int push(int bit) {
+            sr = (sr << 1) | (uint64_t)bit;
+            if (filled < _syncLength) {
+                if (++filled < _syncLength) { return -1; }
+            }
+
+            int best = -1;
+            int bestDist = _maxErrors + 1;
+            bool tie = false;
+            int n = syncWords.size();
+            for (int i = 0; i < n; i++) {
+                int dist = popcount64((sr ^ syncWords[i]) & _mask);
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    best = i;
+                    tie = false;
+                }
+                else if (dist == bestDist && best >= 0) {
+                    tie = true;
+                }
+            }
+            lastDist = bestDist;
+
+            // Ambiguous, the word could be either of the sync words
+            if (tie) { return -1; }
+            return best;
+        }
+
+        /**
+         * Get the hamming distance of the last reported match.
+         */
+        inline int lastDistance() { return lastDist; }
+
+        /**
+         * Get the raw content of the shift register, most recent bit in the LSB.
+         */
+        inline uint64_t shiftRegister() { return sr; }
+
+    private:
+        std::vector<uint64_t> syncWords;
+        uint64_t sr = 0;
+        uint64_t _mask = 0;
+        int _syncLength = 0;
+        int _maxErrors = 0;
+        int filled = 0;
+        int lastDist = 0;
+    };
+}
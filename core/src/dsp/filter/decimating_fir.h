@@ -17,34 +17,33 @@ namespace dsp::filter {
 
         void setTaps(tap<T>& taps) {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            offset = 0;
-            base_type::setTaps(taps);
-            base_type::tempStart();
+            base_type::update([&]() {
+                offset = 0;
+                base_type::setTaps(taps);
+            });
         }
 
         void setDecimation(int decimation) {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            _decimation = decimation;
-            offset = 0;
-            base_type::tempStart();
+            base_type::update([&]() {
+                _decimation = decimation;
+                offset = 0;
+            });
         }
 
         void reset() {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            offset = 0;
-            base_type::reset();
-            base_type::tempStart();
+            base_type::update([&]() {
+                offset = 0;
+                base_type::reset();
+            });
         }
 
         inline int process(int count, const D* in, D* out) {
-            // Copy data to work buffer
-            memcpy(base_type::bufStart, in, count * sizeof(D));
+            base_type::applyPendingTaps();
+
+            // Append data to the history
+            base_type::buffer = base_type::history.push(in, count);
 
             // Do convolution
             int outCount = 0;
@@ -61,9 +60,6 @@ namespace dsp::filter {
             }
             offset -= count;
 
-            // Move unused data
-            memmove(base_type::buffer, &base_type::buffer[count], (base_type::_taps.size - 1) * sizeof(D));
-
             return outCount;
         }
 
@@ -1,6 +1,9 @@
 #pragma once
 #include "../processor.h"
 #include "../taps/tap.h"
+#include "../buffer/history.h"
+#include <memory>
+#include <atomic>
 
 namespace dsp::filter {
     template <class D, class T>
@@ -14,55 +17,48 @@ namespace dsp::filter {
         ~FIR() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            buffer::free(buffer);
         }
 
         virtual void init(stream<D>* in, tap<T>& taps) {
             _taps = taps;
 
-            // Allocate and clear buffer
-            buffer = buffer::alloc<D>(STREAM_BUFFER_SIZE + 64000);
-            bufStart = &buffer[_taps.size - 1];
-            buffer::clear<D>(buffer, _taps.size - 1);
+            // Allocate and clear history
+            history.init(_taps.size - 1);
 
             base_type::init(in);
         }
 
         virtual void setTaps(tap<T>& taps) {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-
-            int oldTC = _taps.size;
-            _taps = taps;
-
-            // Update start of buffer
-            bufStart = &buffer[_taps.size - 1];
+            base_type::update([&]() {
+                // Taps pushed before are now outdated
+                tapsPending = false;
+                std::atomic_store(&pendingTaps, std::shared_ptr<const tap<T>>());
+                sharedTaps.reset();
+                installTaps(taps);
+            });
+        }
 
-            // Move existing data to make transition seemless
-            if (_taps.size < oldTC) {
-                memmove(buffer, &buffer[oldTC - _taps.size], (_taps.size - 1) * sizeof(D));
-            }
-            else if (_taps.size > oldTC) {
-                memmove(&buffer[_taps.size - oldTC], buffer, (oldTC - 1) * sizeof(D));
-                buffer::clear<D>(buffer, _taps.size - oldTC);
-            }
-            
-            base_type::tempStart();
+        // Replace the taps without stopping the block. The new taps are installed by the DSP thread
+        // before processing the next buffer, so this can be called from any thread at any time.
+        void pushTaps(std::shared_ptr<const tap<T>> taps) {
+            std::atomic_store(&pendingTaps, taps);
+            tapsPending = true;
         }
 
         virtual void reset() {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            buffer::clear<D>(buffer, _taps.size - 1);
-            base_type::tempStart();
+            base_type::update([&]() {
+                history.clear();
+            });
         }
 
         inline int process(int count, const D* in, D* out) {
-            // Copy data to work buffer
-            memcpy(bufStart, in, count * sizeof(D));
-            
+            applyPendingTaps();
+
+            // Append data to the history
+            buffer = history.push(in, count);
+
             // Do convolution
             for (int i = 0; i < count; i++) {
                 if constexpr (std::is_same_v<D, float> && std::is_same_v<T, float>) {
@@ -76,9 +72,6 @@ namespace dsp::filter {
                 }
             }
 
-            // Move unused data
-            memmove(buffer, &buffer[count], (_taps.size - 1) * sizeof(D));
-
             return count;
         }
 
@@ -94,8 +87,33 @@ namespace dsp::filter {
         }
 
     protected:
+        // Install the taps pushed with pushTaps if any, returns true if the taps changed
+        inline bool applyPendingTaps() {
+            if (!tapsPending.exchange(false)) { return false; }
+            std::shared_ptr<const tap<T>> taps = std::atomic_exchange(&pendingTaps, std::shared_ptr<const tap<T>>());
+            if (!taps) { return false; }
+            tap<T> t = *taps;
+            installTaps(t);
+            sharedTaps = taps;
+            return true;
+        }
+
+        void installTaps(tap<T>& taps) {
+            _taps = taps;
+
+            // Keep the most recent samples to make transition seemless
+            history.setLength(_taps.size - 1);
+        }
+
         tap<T> _taps;
+        buffer::History<D> history;
+
+        // History followed by the samples being processed
         D* buffer;
-        D* bufStart;
+
+        // Taps pushed by another thread, and the ones in use if they came from there
+        std::shared_ptr<const tap<T>> pendingTaps;
+        std::shared_ptr<const tap<T>> sharedTaps;
+        std::atomic<bool> tapsPending = false;
     };
 }
\ No newline at end of file
@@ -0,0 +1,133 @@
+#pragma once
+#include "decimating_fir.h"
+#include <vector>
+
+namespace dsp::filter {
+    // Decimating FIR for linear-phase real taps. Mirrored samples are added together into a scratch buffer
+    // before the dot product, which halves its length, and taps that are exactly zero (like every other
+    // tap of a half-band filter) are left out. Falls back to the generic FIR if the taps aren't symmetric.
+    template <class D>
+    class SymmetricDecimatingFIR : public DecimatingFIR<D, float> {
+        using base_type = DecimatingFIR<D, float>;
+    public:
+        SymmetricDecimatingFIR() {}
+
+        SymmetricDecimatingFIR(stream<D>* in, tap<float>& taps, int decimation) { init(in, taps, decimation); }
+
+        ~SymmetricDecimatingFIR() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(foldedTaps);
+            buffer::free(scratch);
+        }
+
+        void init(stream<D>* in, tap<float>& taps, int decimation) {
+            base_type::init(in, taps, decimation);
+            fold();
+        }
+
+        void setTaps(tap<float>& taps) {
+            assert(base_type::_block_init);
+            base_type::update([&]() {
+                base_type::setTaps(taps);
+                fold();
+            });
+        }
+
+        inline int process(int count, const D* in, D* out) {
+            if (base_type::applyPendingTaps()) { fold(); }
+            if (!symmetric) { return base_type::process(count, in, out); }
+
+            // Append data to the history
+            base_type::buffer = base_type::history.push(in, count);
+
+            // Do convolution
+            const int n = base_type::_taps.size;
+            const int half = n / 2;
+            const int nz = indices.size();
+            const int* idx = indices.data();
+            float* s = (float*)scratch;
+            int outCount = 0;
+            for (; base_type::offset < count; base_type::offset += base_type::_decimation) {
+                // Fold the mirrored samples, the center sample of an odd length goes last
+                const float* x = (const float*)&base_type::buffer[base_type::offset];
+                const float* y = &x[(n - 1) * CHANNELS];
+                if (dense) {
+                    for (int i = 0; i < half * CHANNELS; i += CHANNELS) {
+                        for (int c = 0; c < CHANNELS; c++) { s[i + c] = x[i + c] + y[c - i]; }
+                    }
+                }
+                else {
+                    for (int i = 0; i < nz; i++) {
+                        int j = idx[i] * CHANNELS;
+                        for (int c = 0; c < CHANNELS; c++) { s[i * CHANNELS + c] = x[j + c] + y[c - j]; }
+                    }
+                }
+                if (n & 1) {
+                    for (int c = 0; c < CHANNELS; c++) { s[nz * CHANNELS + c] = x[half * CHANNELS + c]; }
+                }
+
+                if constexpr (std::is_same_v<D, float>) {
+                    volk_32f_x2_dot_prod_32f(&out[outCount++], scratch, foldedTaps, foldedCount);
+                }
+                else {
+                    volk_32fc_32f_dot_prod_32fc((lv_32fc_t*)&out[outCount++], (lv_32fc_t*)scratch, foldedTaps, foldedCount);
+                }
+            }
+            base_type::offset -= count;
+
+            return outCount;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        // Number of interleaved floats per sample
+        static constexpr int CHANNELS = sizeof(D) / sizeof(float);
+
+        void fold() {
+            const float* taps = base_type::_taps.taps;
+            int n = base_type::_taps.size;
+
+            // Check that the taps are symmetric
+            symmetric = (n > 1);
+            for (int i = 0; i < n / 2 && symmetric; i++) {
+                symmetric = (taps[i] == taps[n - 1 - i]);
+            }
+            if (!symmetric) { return; }
+
+            // Keep the non-zero taps of the first half and their index, followed by the center tap of an odd length
+            indices.clear();
+            for (int i = 0; i < n / 2; i++) {
+                if (taps[i] != 0.0f) { indices.push_back(i); }
+            }
+            dense = (indices.size() == n / 2);
+            foldedCount = indices.size() + (n & 1);
+            buffer::free(foldedTaps);
+            buffer::free(scratch);
+            foldedTaps = buffer::alloc<float>(foldedCount);
+            scratch = buffer::alloc<D>(foldedCount);
+            for (int i = 0; i < indices.size(); i++) { foldedTaps[i] = taps[indices[i]]; }
+            if (n & 1) { foldedTaps[foldedCount - 1] = taps[n / 2]; }
+        }
+
+        bool symmetric = false;
+        bool dense = false;
+        std::vector<int> indices;
+        float* foldedTaps = NULL;
+        D* scratch = NULL;
+        int foldedCount = 0;
+    };
+}
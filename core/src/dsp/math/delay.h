@@ -1,5 +1,6 @@
 #pragma once
 #include "../processor.h"
+#include "../buffer/history.h"
 
 namespace dsp::math {
     template<class T>
@@ -13,15 +14,12 @@ namespace dsp::math {
         ~Delay() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            buffer::free(buffer);
         }
 
         void init(stream<T>* in, int delay) {
             _delay = delay;
 
-            buffer = buffer::alloc<T>(STREAM_BUFFER_SIZE + 64000);
-            bufStart = &buffer[_delay];
-            buffer::clear(buffer, _delay);
+            history.init(_delay);
 
             base_type::init(in);
         }
@@ -31,7 +29,7 @@ namespace dsp::math {
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
             _delay = delay;
-            bufStart = &buffer[_delay];
+            history.setLength(_delay);
             reset();
             base_type::tempStart();
         }
@@ -40,20 +38,17 @@ namespace dsp::math {
             assert(base_type::_block_init);
             std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
             base_type::tempStop();
-            buffer::clear(buffer, _delay);
+            history.clear();
             base_type::tempStart();
         }
 
         inline int process(int count, const T* in, T* out) {
             // Copy data into delay buffer
-            memcpy(bufStart, in, count * sizeof(T));
+            T* buffer = history.push(in, count);
 
             // Copy data out of the delay buffer
             memcpy(out, buffer, count * sizeof(T));
 
-            // Move end of the delay buffer to the front
-            memmove(buffer, &buffer[count], _delay * sizeof(T));
-
             return count;
         }
 
@@ -70,7 +65,6 @@ namespace dsp::math {
 
     private:
         int _delay;
-        T* buffer;
-        T* bufStart;
+        buffer::History<T> history;
     };
 }
\ No newline at end of file
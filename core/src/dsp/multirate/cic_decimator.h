@@ -0,0 +1,125 @@
+#pragma once
+#include "../processor.h"
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+
+// Magnitude of the input samples that can be processed without clipping
+#define CIC_DECIMATOR_HEADROOM_BITS     7
+// Minimum number of fractional bits left once the gain of the CIC is accounted for
+#define CIC_DECIMATOR_MIN_FRAC_BITS     16
+
+namespace dsp::multirate {
+    // Check that the gain of a CIC with these parameters fits in its 64 bit accumulators
+    inline bool cicSupported(int decimation, int order) {
+        int growth = (int)ceil(order * log2((double)decimation));
+        return 62 - growth - CIC_DECIMATOR_HEADROOM_BITS >= CIC_DECIMATOR_MIN_FRAC_BITS;
+    }
+
+    // Cascaded integrator-comb decimator. The samples are converted to fixed point so that the
+    // integrators can wrap around without any loss, floats would accumulate rounding errors forever.
+    // The output is normalized to unity gain at DC but isn't compensated for the passband droop.
+    template <class T>
+    class CICDecimator : public Processor<T, T> {
+        using base_type = Processor<T, T>;
+    public:
+        CICDecimator() {}
+
+        CICDecimator(stream<T>* in, int decimation, int order) { init(in, decimation, order); }
+
+        void init(stream<T>* in, int decimation, int order) {
+            assert(decimation > 0 && order > 0 && order <= CIC_DECIMATOR_MAX_ORDER);
+            _decimation = decimation;
+            _order = order;
+            configure();
+            base_type::init(in);
+        }
+
+        void reset() {
+            assert(base_type::_block_init);
+            base_type::update([&]() {
+                clear();
+            });
+        }
+
+        inline int process(int count, const T* in, T* out) {
+            const float* x = (const float*)in;
+            float* y = (float*)out;
+            int outCount = 0;
+            for (int i = 0; i < count; i++) {
+                // Integrate
+                for (int c = 0; c < CHANNELS; c++) {
+                    float v = std::clamp<float>(x[i * CHANNELS + c], -maxInput, maxInput);
+                    uint64_t acc = (uint64_t)(int64_t)(v * inScale);
+                    for (int k = 0; k < _order; k++) {
+                        integ[c][k] += acc;
+                        acc = integ[c][k];
+                    }
+                }
+
+                // Comb and output once every decimation samples
+                if (++phase < _decimation) { continue; }
+                phase = 0;
+                for (int c = 0; c < CHANNELS; c++) {
+                    uint64_t acc = integ[c][_order - 1];
+                    for (int k = 0; k < _order; k++) {
+                        uint64_t prev = comb[c][k];
+                        comb[c][k] = acc;
+                        acc -= prev;
+                    }
+                    y[outCount * CHANNELS + c] = (float)((double)(int64_t)acc * outScale);
+                }
+                outCount++;
+            }
+            return outCount;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        static constexpr int CHANNELS = sizeof(T) / sizeof(float);
+        static constexpr int CIC_DECIMATOR_MAX_ORDER = 8;
+
+        void configure() {
+            // The gain of the CIC is decimation^order, leave enough bits for it and the headroom
+            int growth = (int)ceil(_order * log2((double)_decimation));
+            int fracBits = std::min<int>(62 - growth - CIC_DECIMATOR_HEADROOM_BITS, 40);
+            assert(fracBits >= CIC_DECIMATOR_MIN_FRAC_BITS);
+            inScale = ldexp(1.0, fracBits);
+            outScale = 1.0 / (inScale * pow((double)_decimation, _order));
+            maxInput = (float)(1 << CIC_DECIMATOR_HEADROOM_BITS);
+            clear();
+        }
+
+        void clear() {
+            phase = 0;
+            for (int c = 0; c < CHANNELS; c++) {
+                for (int k = 0; k < CIC_DECIMATOR_MAX_ORDER; k++) {
+                    integ[c][k] = 0;
+                    comb[c][k] = 0;
+                }
+            }
+        }
+
+        int _decimation;
+        int _order;
+        int phase = 0;
+        double inScale;
+        double outScale;
+        float maxInput;
+        uint64_t integ[CHANNELS][CIC_DECIMATOR_MAX_ORDER];
+        uint64_t comb[CHANNELS][CIC_DECIMATOR_MAX_ORDER];
+    };
+}
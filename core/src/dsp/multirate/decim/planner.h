@@ -0,0 +1,217 @@
+#pragma once
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <math.h>
+#include <string.h>
+#include "plans.h"
+#include "../cic_decimator.h"
+#include "../../types.h"
+#include "../../math/constants.h"
+#include "../../taps/tap.h"
+#include "../../taps/windowed_sinc.h"
+#include "../../window/nuttall.h"
+
+// Fraction of the output nyquist band that is kept free of aliasing
+#define DECIM_PLANNER_PASSBAND          0.9
+// Order of the CIC first stage
+#define DECIM_PLANNER_CIC_ORDER         4
+// Minimum alias rejection of the CIC first stage in the kept band
+#define DECIM_PLANNER_CIC_MIN_ATT_DB    100.0
+// Cost of an add relative to a multiply-accumulate
+#define DECIM_PLANNER_ADD_COST          0.5
+// Transition width times tap count of a nuttall windowed sinc, the main lobe of the window
+#define DECIM_PLANNER_TRANSITION_FACTOR 8.0
+// Number of points used to integrate the response of compensated filters
+#define DECIM_PLANNER_INTEG_POINTS      512
+// Maximum tap count of a FIR stage, ratios with a large prime factor would need far more than that
+#define DECIM_PLANNER_MAX_TAPS          4096
+
+namespace dsp::multirate::decim {
+    struct designed_stage {
+        unsigned int decimation;
+        unsigned int cicOrder; // 0 if the stage is a FIR
+        std::vector<float> taps;
+    };
+
+    typedef std::vector<designed_stage> design;
+
+    namespace planner {
+        // Magnitude of a CIC at frequency f relative to its input rate, normalized to 1 at DC
+        inline double cicResponse(double f, unsigned int decimation, unsigned int order) {
+            if (f == 0.0) { return 1.0; }
+            double num = sin(DB_M_PI * f * decimation);
+            double den = decimation * sin(DB_M_PI * f);
+            return pow(fabs(num / den), order);
+        }
+
+        // Windowed low-pass whose passband compensates the droop of a CIC placed before it.
+        // All frequencies are relative to the input rate of the FIR.
+        inline std::vector<float> designLowPass(int count, double cutoff, double cicRate = 0.0, unsigned int cicDecim = 0, unsigned int cicOrder = 0) {
+            std::vector<float> taps(count);
+            if (!cicOrder) {
+                tap<float> t = taps::windowedSinc<float>(count, 2.0 * DB_M_PI * cutoff, window::nuttall);
+                memcpy(taps.data(), t.taps, count * sizeof(float));
+                taps::free(t);
+            }
+            else {
+                // The ideal response is integrated numerically, then windowed like a windowed sinc
+                double half = (double)count / 2.0;
+                double step = cutoff / DECIM_PLANNER_INTEG_POINTS;
+                std::vector<double> comp(DECIM_PLANNER_INTEG_POINTS + 1);
+                for (int k = 0; k <= DECIM_PLANNER_INTEG_POINTS; k++) {
+                    comp[k] = 1.0 / cicResponse(k * step * cicRate, cicDecim, cicOrder);
+                }
+                for (int i = 0; i < count; i++) {
+                    double t = (double)i - half + 0.5;
+                    double sum = 0.0;
+                    for (int k = 0; k <= DECIM_PLANNER_INTEG_POINTS; k++) {
+                        double w = (k == 0 || k == DECIM_PLANNER_INTEG_POINTS) ? 0.5 : 1.0;
+                        sum += w * comp[k] * cos(2.0 * DB_M_PI * k * step * t);
+                    }
+                    taps[i] = 2.0 * step * sum * window::nuttall(t - half, count);
+                }
+            }
+
+            // Make the taps exactly symmetric and normalize the DC gain
+            double sum = 0.0;
+            for (int i = 0; i < count / 2; i++) { taps[count - 1 - i] = taps[i]; }
+            for (int i = 0; i < count; i++) { sum += taps[i]; }
+            for (int i = 0; i < count; i++) { taps[i] /= sum; }
+            return taps;
+        }
+
+        inline int firTapCount(double inRate, double outRate, double passband) {
+            int count = ceil(DECIM_PLANNER_TRANSITION_FACTOR * inRate / (outRate - 2.0 * passband));
+            return std::max<int>(count, 3);
+        }
+
+        // Cost per input sample of the whole decimator of a FIR stage, infinite if it needs too many taps
+        inline double firCost(double inRate, unsigned int decimation, double passband) {
+            double outRate = inRate / decimation;
+            int count = firTapCount(inRate, outRate, passband);
+            if (count > DECIM_PLANNER_MAX_TAPS) { return INFINITY; }
+            return outRate * (double)((count + 1) / 2);
+        }
+
+        inline double cicCost(double inRate, unsigned int decimation) {
+            return inRate * DECIM_PLANNER_CIC_ORDER * DECIM_PLANNER_ADD_COST * (1.0 + 1.0 / decimation);
+        }
+
+        inline bool cicUsable(double inRate, unsigned int decimation, double passband) {
+            // The gain of the CIC must leave enough bits in its accumulators
+            if (!cicSupported(decimation, DECIM_PLANNER_CIC_ORDER)) { return false; }
+
+            // The worst alias is at the edge of the kept band around the first null
+            double outRate = inRate / decimation;
+            double att = -20.0 * log10(cicResponse((outRate - passband) / inRate, decimation, DECIM_PLANNER_CIC_ORDER));
+            return att >= DECIM_PLANNER_CIC_MIN_ATT_DB;
+        }
+
+        struct choice {
+            double cost;
+            unsigned int factor;
+        };
+
+        // Find the cheapest factorization of the remaining ratio, memoized on the remaining ratio
+        inline choice bestFIRs(unsigned int remaining, unsigned int ratio, double passband, std::map<unsigned int, choice>& memo) {
+            if (remaining == 1) { return { 0.0, 1 }; }
+            auto it = memo.find(remaining);
+            if (it != memo.end()) { return it->second; }
+
+            double inRate = (double)remaining / (double)ratio;
+            choice best = { INFINITY, remaining };
+            for (unsigned int d = 2; d <= remaining; d++) {
+                if (remaining % d) { continue; }
+                double cost = firCost(inRate, d, passband) + bestFIRs(remaining / d, ratio, passband, memo).cost;
+                if (cost < best.cost) { best = { cost, d }; }
+            }
+
+            memo[remaining] = best;
+            return best;
+        }
+
+        inline design generate(unsigned int ratio, double passbandFrac = DECIM_PLANNER_PASSBAND) {
+            design result;
+            if (ratio <= 1) { return result; }
+
+            // Rates are relative to the input rate
+            double passband = passbandFrac * 0.5 / (double)ratio;
+            std::map<unsigned int, choice> memo;
+            choice best = bestFIRs(ratio, ratio, passband, memo);
+
+            // Check if starting with a CIC is cheaper
+            unsigned int cicDecim = 0;
+            for (unsigned int d = 2; d < ratio; d++) {
+                if (ratio % d || !cicUsable(1.0, d, passband)) { continue; }
+                double cost = cicCost(1.0, d) + bestFIRs(ratio / d, ratio, passband, memo).cost;
+                if (cost < best.cost) {
+                    best.cost = cost;
+                    cicDecim = d;
+                }
+            }
+
+            // Every factorization needs a FIR stage with too many taps
+            if (best.cost == INFINITY) {
+                throw std::runtime_error("[DecimationPlanner] Decimation ratio has a prime factor too large");
+            }
+
+            unsigned int remaining = ratio;
+            if (cicDecim) {
+                result.push_back({ cicDecim, DECIM_PLANNER_CIC_ORDER, {} });
+                remaining /= cicDecim;
+            }
+
+            // Build the FIR stages, the first one compensates the CIC if there is one
+            bool compensate = (cicDecim != 0);
+            while (remaining > 1) {
+                unsigned int d = bestFIRs(remaining, ratio, passband, memo).factor;
+                double inRate = (double)remaining / (double)ratio;
+                double outRate = inRate / d;
+                int count = firTapCount(inRate, outRate, passband);
+                std::vector<float> taps;
+                if (compensate) {
+                    taps = designLowPass(count, 0.5 * outRate / inRate, inRate, cicDecim, DECIM_PLANNER_CIC_ORDER);
+                }
+                else {
+                    taps = designLowPass(count, 0.5 * outRate / inRate);
+                }
+                result.push_back({ d, 0, taps });
+                compensate = false;
+                remaining /= d;
+            }
+
+            return result;
+        }
+    }
+
+    // Get the design for a ratio. Power of two ratios use the precomputed plans, other ratios
+    // are designed at runtime. Designs are cached since they're expensive for large ratios.
+    // Throws if the ratio has a prime factor too large for a FIR stage of reasonable length.
+    inline std::shared_ptr<const design> getDesign(unsigned int ratio) {
+        static std::mutex cacheMtx;
+        static std::map<unsigned int, std::shared_ptr<const design>> cache;
+
+        std::lock_guard<std::mutex> lck(cacheMtx);
+        auto it = cache.find(ratio);
+        if (it != cache.end()) { return it->second; }
+
+        std::shared_ptr<design> d = std::make_shared<design>();
+        bool pow2 = ratio > 1 && !(ratio & (ratio - 1));
+        if (pow2 && ratio <= (1u << plans_len)) {
+            const plan& p = plans[(int)log2(ratio) - 1];
+            for (int i = 0; i < p.stageCount; i++) {
+                const stage& s = p.stages[i];
+                d->push_back({ s.decimation, 0, std::vector<float>(s.taps, s.taps + s.tapcount) });
+            }
+        }
+        else {
+            *d = planner::generate(ratio);
+        }
+
+        cache[ratio] = d;
+        return d;
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include "../filter/symmetric_decimating_fir.h"
+#include "../taps/from_array.h"
+#include "cic_decimator.h"
+#include "decim/planner.h"
+
+namespace dsp::multirate {
+    // Decimator for any integer ratio. Power of two ratios use the same precomputed plans as the
+    // PowerDecimator, other ratios use a multi-stage cascade designed at runtime.
+    template<class T>
+    class Decimator : public Processor<T, T> {
+        using base_type = Processor<T, T>;
+    public:
+        Decimator() {}
+
+        Decimator(stream<T>* in, unsigned int ratio) { init(in, ratio); }
+
+        ~Decimator() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            freeStages();
+        }
+
+        void init(stream<T>* in, unsigned int ratio) {
+            assert(ratio > 0);
+            if (ratio > 1) { decim::getDesign(ratio); }
+            _ratio = ratio;
+            reconfigure();
+            base_type::init(in);
+        }
+
+        void setRatio(unsigned int ratio) {
+            assert(base_type::_block_init);
+            assert(ratio > 0);
+
+            // Design outside of the update so that an unsupported ratio throws before anything is changed
+            if (ratio > 1) { decim::getDesign(ratio); }
+            base_type::update([&]() {
+                _ratio = ratio;
+                reconfigure();
+            });
+        }
+
+        unsigned int getRatio() { return _ratio; }
+
+        void reset() {
+            assert(base_type::_block_init);
+            base_type::update([&]() {
+                if (cic) { cic->reset(); }
+                for (auto& fir : firs) { fir->reset(); }
+            });
+        }
+
+        inline int process(int count, const T* in, T* out) {
+            // If the ratio is 1, no need to decimate
+            if (_ratio == 1) {
+                memcpy(out, in, count * sizeof(T));
+                return count;
+            }
+
+            // Process data through each stage
+            const T* data = in;
+            if (cic) {
+                count = cic->process(count, data, out);
+                data = out;
+            }
+            for (auto& fir : firs) {
+                count = fir->process(count, data, out);
+                data = out;
+            }
+            return count;
+        }
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            int outCount = process(count, base_type::_in->readBuf, base_type::out.writeBuf);
+
+            // Swap if some data was generated
+            base_type::_in->flush();
+            if (outCount) {
+                if (!base_type::out.swap(outCount)) { return -1; }
+            }
+            return outCount;
+        }
+
+    protected:
+        void freeStages() {
+            if (cic) {
+                delete cic;
+                cic = NULL;
+            }
+            for (auto& fir : firs) { delete fir; }
+            for (auto& taps : firTaps) { taps::free(taps); }
+            firs.clear();
+            firTaps.clear();
+        }
+
+        void reconfigure() {
+            freeStages();
+            if (_ratio <= 1) { return; }
+
+            // Create the stages from the design
+            auto design = decim::getDesign(_ratio);
+            for (const auto& stage : *design) {
+                if (stage.cicOrder) {
+                    cic = new CICDecimator<T>(NULL, stage.decimation, stage.cicOrder);
+                    cic->out.free();
+                    continue;
+                }
+                tap<float> taps = taps::fromArray<float>(stage.taps.size(), stage.taps.data());
+                auto fir = new filter::SymmetricDecimatingFIR<T>(NULL, taps, stage.decimation);
+                fir->out.free();
+                firTaps.push_back(taps);
+                firs.push_back(fir);
+            }
+        }
+
+        CICDecimator<T>* cic = NULL;
+        std::vector<filter::SymmetricDecimatingFIR<T>*> firs;
+        std::vector<tap<float>> firTaps;
+        unsigned int _ratio;
+    };
+}
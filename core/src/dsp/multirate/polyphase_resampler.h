@@ -2,6 +2,7 @@
 #include "../processor.h"
 #include "../taps/tap.h"
 #include "polyphase_bank.h"
+#include "../buffer/history.h"
 
 namespace dsp::multirate {
     template<class T>
@@ -15,7 +16,6 @@ namespace dsp::multirate {
         ~PolyphaseResampler() {
             if (!base_type::_block_init) { return; }
             base_type::stop();
-            buffer::free(buffer);
             freePolyphaseBank(phases);
         }
 
@@ -28,49 +28,43 @@ namespace dsp::multirate {
             phases = buildPolyphaseBank(_interp, _taps);
 
             // Allocate delay buffer
-            buffer = buffer::alloc<T>(STREAM_BUFFER_SIZE + 64000);
-            bufStart = &buffer[phases.tapsPerPhase - 1];
-            buffer::clear<T>(buffer, phases.tapsPerPhase - 1);
+            history.init(phases.tapsPerPhase - 1);
 
             base_type::init(in);
         }
 
         void setRatio(int interp, int decim, tap<float>& taps) {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-
-            // Update settings
-            _interp = interp;
-            _decim = decim;
-            _taps = taps;
-
-            // Re-generate polyphase bank
-            freePolyphaseBank(phases);
-            phases = buildPolyphaseBank(_interp, _taps);
-
-            // Reset buffer
-            bufStart = &buffer[phases.tapsPerPhase - 1];
-            reset();
-
-            base_type::tempStart();
+            base_type::update([&]() {
+                // Update settings
+                _interp = interp;
+                _decim = decim;
+                _taps = taps;
+
+                // Re-generate polyphase bank
+                freePolyphaseBank(phases);
+                phases = buildPolyphaseBank(_interp, _taps);
+
+                // Reset buffer
+                history.setLength(phases.tapsPerPhase - 1);
+                reset();
+            });
         }
 
         void reset() {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            buffer::clear<T>(buffer, phases.tapsPerPhase - 1);
-            phase = 0;
-            offset = 0;
-            base_type::tempStart();
+            base_type::update([&]() {
+                history.clear();
+                phase = 0;
+                offset = 0;
+            });
         }
 
         inline int process(int count, const T* in, T* out) {
             int outCount = 0;
 
-            // Copy input to buffer
-            memcpy(bufStart, in, count * sizeof(T));
+            // Append input to the delay buffer
+            T* buffer = history.push(in, count);
 
             while (offset < count) {
                 // Do convolution
@@ -92,9 +86,6 @@ namespace dsp::multirate {
             }
             offset -= count;
 
-            // Move delay
-            memmove(buffer, &buffer[count], (phases.tapsPerPhase - 1) * sizeof(T));
-
             return outCount;
         }
 
@@ -119,8 +110,6 @@ namespace dsp::multirate {
         PolyphaseBank<float> phases;
         int phase = 0;
         int offset = 0;
-        T* buffer;
-        T* bufStart;
-
+        buffer::History<T> history;
     };
 }
\ No newline at end of file
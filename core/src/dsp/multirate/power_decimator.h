@@ -1,5 +1,5 @@
 #pragma once
-#include "../filter/decimating_fir.h"
+#include "../filter/symmetric_decimating_fir.h"
 #include "../taps/from_array.h"
 #include "decim/plans.h"
 
@@ -31,21 +31,19 @@ namespace dsp::multirate {
 
         void setRatio(unsigned int ratio) {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            _ratio = ratio;
-            reconfigure();
-            base_type::tempStart();
+            base_type::update([&]() {
+                _ratio = ratio;
+                reconfigure();
+            });
         }
 
         void reset() {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            for (auto& fir : decimFirs) {
-                fir->reset();
-            }
-            base_type::tempStart();
+            base_type::update([&]() {
+                for (auto& fir : decimFirs) {
+                    fir->reset();
+                }
+            });
         }
 
         inline int process(int count, const T* in, T* out) {
@@ -99,7 +97,7 @@ namespace dsp::multirate {
                 stageCount = plan.stageCount;
                 for (int i = 0; i < stageCount; i++) {
                     tap<float> taps = taps::fromArray<float>(plan.stages[i].tapcount, plan.stages[i].taps);
-                    auto fir = new filter::DecimatingFIR<T, float>(NULL, taps, plan.stages[i].decimation);
+                    auto fir = new filter::SymmetricDecimatingFIR<T>(NULL, taps, plan.stages[i].decimation);
                     fir->out.free();
                     decimTaps.push_back(taps);
                     decimFirs.push_back(fir);
@@ -112,7 +110,7 @@ namespace dsp::multirate {
             return ((ratio & (ratio - 1)) == 0) && ratio && ratio <= getMaxRatio();
         }
 
-        std::vector<filter::DecimatingFIR<T, float>*> decimFirs;
+        std::vector<filter::SymmetricDecimatingFIR<T>*> decimFirs;
         std::vector<tap<float>> decimTaps;
         unsigned int _ratio;
         int stageCount;
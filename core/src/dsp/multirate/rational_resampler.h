@@ -44,39 +44,35 @@ namespace dsp::multirate {
 
         void reset() {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            decim.reset();
-            resamp.reset();
-            base_type::tempStart();
+            base_type::update([&]() {
+                decim.reset();
+                resamp.reset();
+            });
         }
 
         void setInSamplerate(double inSamplerate) {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            _inSamplerate = inSamplerate;
-            reconfigure();
-            base_type::tempStart();
+            base_type::update([&]() {
+                _inSamplerate = inSamplerate;
+                reconfigure();
+            });
         }
 
         void setOutSamplerate(double outSamplerate) {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            _outSamplerate = outSamplerate;
-            reconfigure();
-            base_type::tempStart();
+            base_type::update([&]() {
+                _outSamplerate = outSamplerate;
+                reconfigure();
+            });
         }
 
         void setRates(double inSamplerate, double outSamplerate) {
             assert(base_type::_block_init);
-            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
-            base_type::tempStop();
-            _inSamplerate = inSamplerate;
-            _outSamplerate = outSamplerate;
-            reconfigure();
-            base_type::tempStart();
+            base_type::update([&]() {
+                _inSamplerate = inSamplerate;
+                _outSamplerate = outSamplerate;
+                reconfigure();
+            });
         }
 
         inline int process(int count, const T* in, T* out) {
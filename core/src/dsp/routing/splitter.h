@@ -19,11 +19,11 @@ namespace dsp::routing {
                 throw std::runtime_error("[Splitter] Tried to bind stream to that is already bound");
             }
 
-            // Add to the list
-            base_type::tempStop();
-            base_type::registerOutput(stream);
-            streams.push_back(stream);
-            base_type::tempStart();
+            // Add to the list, the other streams keep flowing
+            base_type::update([&]() {
+                base_type::registerOutput(stream);
+                streams.push_back(stream);
+            });
         }
 
         void unbindStream(stream<T>* stream) {
@@ -36,23 +36,24 @@ namespace dsp::routing {
                 throw std::runtime_error("[Splitter] Tried to unbind stream to that isn't bound");
             }
 
-            // Add to the list
-            base_type::tempStop();
-            streams.erase(sit);
-            base_type::unregisterOutput(stream);
-            base_type::tempStart();
+            // Abort a write to the stream in case its reader is gone, then remove it from the list
+            stream->stopWriter();
+            base_type::update([&]() {
+                streams.erase(std::find(streams.begin(), streams.end(), stream));
+                base_type::unregisterOutput(stream);
+            });
+            stream->clearWriteStop();
         }
 
         int run() {
             int count = base_type::_in->read();
             if (count < 0) { return -1; }
 
+            // A failed swap means the stream is being unbound or that the splitter is stopping,
+            // in the latter case the next read fails
             for (const auto& stream : streams) {
                 memcpy(stream->writeBuf, base_type::_in->readBuf, count * sizeof(T));
-                if (!stream->swap(count)) {
-                    base_type::_in->flush();
-                    return -1;
-                }
+                stream->swap(count);
             }
 
             base_type::_in->flush();
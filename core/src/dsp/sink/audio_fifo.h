@@ -0,0 +1,243 @@
+#pragma once
+#include "../sink.h"
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#define AUDIO_FIFO_CHUNK_SIZE       1024
+#define AUDIO_FIFO_FILL_ALPHA       0.01
+#define AUDIO_FIFO_KP               0.01
+#define AUDIO_FIFO_KI               1e-8
+#define AUDIO_FIFO_MAX_CORRECTION   0.005
+#define AUDIO_FIFO_FADE_LENGTH      64
+#define AUDIO_FIFO_DECAY            0.995f
+#define AUDIO_FIFO_WRITE_TIMEOUT    100
+
+namespace dsp::sink {
+    // FIFO between the DSP and an audio callback. The callback side never blocks nor locks and conceals
+    // underruns. The DSP side goes through a fractional resampler whose ratio is slowly adjusted so that
+    // the fill level, and thus the latency, stays around the target despite the clock drift between
+    // the SDR and the sound card. A live producer can't be slowed down, so samples that don't fit are dropped.
+    // Otherwise the DSP side waits for the callback to make room, up to a timeout in case it stopped.
+    class AudioFIFO : public Sink<stereo_t> {
+        using base_type = Sink<stereo_t>;
+    public:
+        AudioFIFO() {}
+
+        AudioFIFO(stream<stereo_t>* in, int targetFill) { init(in, targetFill); }
+
+        ~AudioFIFO() {
+            if (!base_type::_block_init) { return; }
+            base_type::stop();
+            buffer::free(ring);
+            buffer::free(work);
+            buffer::free(resampled);
+        }
+
+        void init(stream<stereo_t>* in, int targetFill) {
+            work = buffer::alloc<stereo_t>(AUDIO_FIFO_CHUNK_SIZE + 3);
+            resampled = buffer::alloc<stereo_t>(2 * AUDIO_FIFO_CHUNK_SIZE);
+            _targetFill = targetFill;
+            capacity = 4 * targetFill + 2 * AUDIO_FIFO_CHUNK_SIZE;
+            ring = buffer::alloc<stereo_t>(capacity);
+            clear();
+            base_type::init(in);
+        }
+
+        // Must not be called while the callback might be reading
+        void setTargetFill(int targetFill) {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            _targetFill = targetFill;
+            capacity = 4 * targetFill + 2 * AUDIO_FIFO_CHUNK_SIZE;
+            buffer::free(ring);
+            ring = buffer::alloc<stereo_t>(capacity);
+            clear();
+            base_type::tempStart();
+        }
+
+        // Must not be called while the callback might be reading
+        void reset() {
+            assert(base_type::_block_init);
+            std::lock_guard<std::recursive_mutex> lck(base_type::ctrlMtx);
+            base_type::tempStop();
+            clear();
+            base_type::tempStart();
+        }
+
+        // Called from the audio callback, always returns immediately
+        void read(stereo_t* out, int count) {
+            size_t w = writeCount.load(std::memory_order_acquire);
+            size_t r = readCount.load(std::memory_order_relaxed);
+            int avail = w - r;
+
+            // After an underrun, wait for the FIFO to be filled up to the target again before resuming
+            if (!primed) {
+                if (avail < _targetFill) {
+                    conceal(out, count);
+                    return;
+                }
+                primed = true;
+                fadePos = 0;
+            }
+
+            // Copy what's available
+            int toRead = std::min<int>(count, avail);
+            int start = r % capacity;
+            int first = std::min<int>(toRead, capacity - start);
+            memcpy(out, &ring[start], first * sizeof(stereo_t));
+            memcpy(&out[first], ring, (toRead - first) * sizeof(stereo_t));
+            readCount.store(r + toRead, std::memory_order_release);
+
+            // Fade in after an underrun to avoid a click
+            for (int i = 0; fadePos < AUDIO_FIFO_FADE_LENGTH && i < toRead; i++, fadePos++) {
+                float gain = (float)fadePos / (float)AUDIO_FIFO_FADE_LENGTH;
+                out[i].l *= gain;
+                out[i].r *= gain;
+            }
+            if (toRead) { lastSample = out[toRead - 1]; }
+
+            // Conceal the missing samples
+            if (toRead < count) {
+                underruns++;
+                primed = false;
+                conceal(&out[toRead], count - toRead);
+            }
+        }
+
+        // Live producers drop samples on overrun, others are paced by the callback
+        void setRealTime(bool enabled) { realTime = enabled; }
+
+        double getRatio() { return ratio; }
+        double getFill() { return avgFill; }
+        int getTargetFill() { return _targetFill; }
+
+        std::atomic<int> underruns = 0;
+        std::atomic<int> overruns = 0;
+        std::atomic<int> dropped = 0;
+
+        int run() {
+            int count = base_type::_in->read();
+            if (count < 0) { return -1; }
+
+            for (int i = 0; i < count; i += AUDIO_FIFO_CHUNK_SIZE) {
+                process(std::min<int>(count - i, AUDIO_FIFO_CHUNK_SIZE), &base_type::_in->readBuf[i]);
+            }
+
+            base_type::_in->flush();
+            return count;
+        }
+
+    private:
+        void clear() {
+            writeCount = 0;
+            readCount = 0;
+            for (int i = 0; i < 3; i++) { work[i] = { 0.0f, 0.0f }; }
+            phase = 0.0;
+            avgFill = 0.0;
+            integral = 0.0;
+            ratio = 1.0;
+            primed = false;
+            lastSample = { 0.0f, 0.0f };
+            fadePos = 0;
+            underruns = 0;
+            overruns = 0;
+            dropped = 0;
+        }
+
+        void process(int count, const stereo_t* in) {
+            // Wait for the callback to drain the FIFO down to the target when the producer can be slowed down
+            size_t w = writeCount.load(std::memory_order_relaxed);
+            int fill = w - readCount.load(std::memory_order_acquire);
+            bool rt = realTime;
+            if (!rt) {
+                auto timeout = std::chrono::steady_clock::now() + std::chrono::milliseconds(AUDIO_FIFO_WRITE_TIMEOUT);
+                while (fill > _targetFill && std::chrono::steady_clock::now() < timeout) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    fill = w - readCount.load(std::memory_order_acquire);
+                }
+            }
+
+            // Update the fill level estimate and the correction applied to the resampling ratio,
+            // there is no clock drift to correct when the callback paces the producer
+            avgFill += (fill - avgFill) * AUDIO_FIFO_FILL_ALPHA;
+            if (rt) {
+                double error = (avgFill - _targetFill) / (double)_targetFill;
+                integral = std::clamp<double>(integral + error * count * AUDIO_FIFO_KI, -AUDIO_FIFO_MAX_CORRECTION, AUDIO_FIFO_MAX_CORRECTION);
+                ratio = 1.0 - std::clamp<double>(error * AUDIO_FIFO_KP + integral, -AUDIO_FIFO_MAX_CORRECTION, AUDIO_FIFO_MAX_CORRECTION);
+            }
+            else {
+                integral = 0.0;
+                ratio = 1.0;
+            }
+
+            // Resample using cubic hermite interpolation, the last 3 input samples are kept for the next call
+            memcpy(&work[3], in, count * sizeof(stereo_t));
+            int last = count - 1;
+            double step = 1.0 / ratio;
+            int outCount = 0;
+            while ((int)phase <= last) {
+                int i = (int)phase;
+                float mu = phase - i;
+                resampled[outCount].l = hermite(work[i].l, work[i + 1].l, work[i + 2].l, work[i + 3].l, mu);
+                resampled[outCount].r = hermite(work[i].r, work[i + 1].r, work[i + 2].r, work[i + 3].r, mu);
+                outCount++;
+                phase += step;
+            }
+            phase -= count;
+            memmove(work, &work[count], 3 * sizeof(stereo_t));
+
+            // Write to the FIFO, dropping what doesn't fit
+            int space = capacity - fill;
+            if (outCount > space) {
+                overruns++;
+                dropped += outCount - space;
+                outCount = space;
+            }
+            int start = w % capacity;
+            int first = std::min<int>(outCount, capacity - start);
+            memcpy(&ring[start], resampled, first * sizeof(stereo_t));
+            memcpy(ring, &resampled[first], (outCount - first) * sizeof(stereo_t));
+            writeCount.store(w + outCount, std::memory_order_release);
+        }
+
+        void conceal(stereo_t* out, int count) {
+            // Decay the last sample to zero instead of cutting abruptly
+            for (int i = 0; i < count; i++) {
+                lastSample.l *= AUDIO_FIFO_DECAY;
+                lastSample.r *= AUDIO_FIFO_DECAY;
+                out[i] = lastSample;
+            }
+        }
+
+        static inline float hermite(float x0, float x1, float x2, float x3, float mu) {
+            float c0 = x1;
+            float c1 = 0.5f * (x2 - x0);
+            float c2 = x0 - 2.5f * x1 + 2.0f * x2 - 0.5f * x3;
+            float c3 = 0.5f * (x3 - x0) + 1.5f * (x1 - x2);
+            return ((c3 * mu + c2) * mu + c1) * mu + c0;
+        }
+
+        int _targetFill;
+        int capacity;
+        stereo_t* ring;
+        std::atomic<size_t> writeCount = 0;
+        std::atomic<size_t> readCount = 0;
+
+        // Writer state
+        stereo_t* work;
+        stereo_t* resampled;
+        double phase;
+        double avgFill;
+        double integral;
+        std::atomic<double> ratio = 1.0;
+        std::atomic<bool> realTime = true;
+
+        // Reader state
+        bool primed;
+        stereo_t lastSample;
+        int fadePos;
+    };
+}
@@ -19,6 +19,15 @@ namespace dsp {
         virtual void clearWriteStop() {}
         virtual void stopReader() {}
         virtual void clearReadStop() {}
+        virtual void setEndOfStream() {}
+        virtual bool isEndOfStream() { return false; }
+        virtual void clearEndOfStream() {}
+
+        // Mutex released by the reader while it waits for data, see block::update()
+        void setReaderGate(std::recursive_timed_mutex* gate) { readerGate = gate; }
+
+    protected:
+        std::recursive_timed_mutex* readerGate = NULL;
     };
 
     template <class T>
@@ -68,11 +77,21 @@ namespace dsp {
         }
 
         virtual inline int read() {
+            // The reader is idle while waiting, so updates to it can be applied meanwhile
+            if (readerGate) { readerGate->unlock(); }
+
             // Wait for data to be ready or to be stopped
-            std::unique_lock<std::mutex> lck(rdyMtx);
-            rdyCV.wait(lck, [this] { return (dataReady || readerStop); });
+            int ret;
+            {
+                std::unique_lock<std::mutex> lck(rdyMtx);
+                rdyCV.wait(lck, [this] { return (dataReady || readerStop || endOfStream); });
 
-            return (readerStop ? -1 : dataSize);
+                // Pending data is still returned once the end of the stream was signaled
+                ret = (readerStop || !dataReady) ? -1 : dataSize;
+            }
+
+            if (readerGate) { readerGate->lock(); }
+            return ret;
         }
 
         virtual inline void flush() {
@@ -115,6 +134,26 @@ namespace dsp {
             readerStop = false;
         }
 
+        // Signal that the writer won't send any more data. The reader receives whatever
+        // is pending then stops as if it was asked to.
+        virtual void setEndOfStream() {
+            {
+                std::lock_guard<std::mutex> lck(rdyMtx);
+                endOfStream = true;
+            }
+            rdyCV.notify_all();
+        }
+
+        virtual bool isEndOfStream() {
+            std::lock_guard<std::mutex> lck(rdyMtx);
+            return endOfStream && !dataReady;
+        }
+
+        virtual void clearEndOfStream() {
+            std::lock_guard<std::mutex> lck(rdyMtx);
+            endOfStream = false;
+        }
+
         void free() {
             if (writeBuf) { buffer::free(writeBuf); }
             if (readBuf) { buffer::free(readBuf); }
@@ -136,6 +175,7 @@ namespace dsp {
 
         bool readerStop = false;
         bool writerStop = false;
+        bool endOfStream = false;
 
         int dataSize = 0;
     };
@@ -0,0 +1,8 @@
+#include "design_service.h"
+
+namespace dsp::taps {
+    DesignService& DesignService::instance() {
+        static DesignService service;
+        return service;
+    }
+}
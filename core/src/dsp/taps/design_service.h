@@ -0,0 +1,183 @@
+#pragma once
+#include "low_pass.h"
+#include "high_pass.h"
+#include "band_pass.h"
+#include <memory>
+#include <map>
+#include <tuple>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <functional>
+
+// Maximum number of designs kept in the cache
+#define DESIGN_SERVICE_CACHE_SIZE   256
+
+namespace dsp::taps {
+    typedef std::shared_ptr<const tap<float>> shared_taps;
+
+    enum FilterType {
+        FILTER_TYPE_LOW_PASS,
+        FILTER_TYPE_HIGH_PASS,
+        FILTER_TYPE_BAND_PASS
+    };
+
+    struct FilterSpec {
+        FilterType type;
+        double lowCutoff;   // Unused for low pass filters
+        double highCutoff;  // Unused for high pass filters
+        double transWidth;
+        double samplerate;
+
+        bool operator<(const FilterSpec& b) const {
+            return std::tie(type, lowCutoff, highCutoff, transWidth, samplerate) < std::tie(b.type, b.lowCutoff, b.highCutoff, b.transWidth, b.samplerate);
+        }
+    };
+
+    inline FilterSpec lowPassSpec(double cutoff, double transWidth, double samplerate) {
+        return { FILTER_TYPE_LOW_PASS, 0.0, cutoff, transWidth, samplerate };
+    }
+
+    inline FilterSpec highPassSpec(double cutoff, double transWidth, double samplerate) {
+        return { FILTER_TYPE_HIGH_PASS, cutoff, 0.0, transWidth, samplerate };
+    }
+
+    inline FilterSpec bandPassSpec(double bandStart, double bandStop, double transWidth, double samplerate) {
+        return { FILTER_TYPE_BAND_PASS, bandStart, bandStop, transWidth, samplerate };
+    }
+
+    // Designs filters for the blocks whose parameters change while running. Designs are cached by their
+    // parameters and asynchronous requests are computed on a worker thread. Only the latest request of each
+    // owner is kept, so a stream of requests (like dragging the bandwidth of a VFO) never piles up.
+    class DesignService {
+    public:
+        typedef std::function<void(shared_taps taps)> Handler;
+
+        DesignService() {
+            workerThread = std::thread(&DesignService::worker, this);
+        }
+
+        ~DesignService() {
+            {
+                std::lock_guard<std::mutex> lck(workMtx);
+                stop = true;
+            }
+            workCnd.notify_all();
+            if (workerThread.joinable()) { workerThread.join(); }
+        }
+
+        // Defined in core so that the modules all share the same instance
+        static DesignService& instance();
+
+        // Get a design, blocking if it isn't in the cache
+        shared_taps design(const FilterSpec& spec) {
+            {
+                std::lock_guard<std::mutex> lck(cacheMtx);
+                auto it = cache.find(spec);
+                if (it != cache.end()) {
+                    it->second.lastUse = ++useCounter;
+                    return it->second.taps;
+                }
+            }
+
+            // Design outside of the lock so that other requests aren't blocked
+            tap<float>* t = new tap<float>;
+            switch (spec.type) {
+                case FILTER_TYPE_LOW_PASS:
+                    *t = lowPass(spec.highCutoff, spec.transWidth, spec.samplerate);
+                    break;
+                case FILTER_TYPE_HIGH_PASS:
+                    *t = highPass(spec.lowCutoff, spec.transWidth, spec.samplerate);
+                    break;
+                case FILTER_TYPE_BAND_PASS:
+                    *t = bandPass<float>(spec.lowCutoff, spec.highCutoff, spec.transWidth, spec.samplerate);
+                    break;
+            }
+            shared_taps taps(t, [](const tap<float>* t) {
+                taps::free(*(tap<float>*)t);
+                delete t;
+            });
+
+            std::lock_guard<std::mutex> lck(cacheMtx);
+            if (cache.size() >= DESIGN_SERVICE_CACHE_SIZE) { evict(); }
+            cache[spec] = { taps, ++useCounter };
+            return taps;
+        }
+
+        // Design in the background and call the handler from the worker thread once done. A pending
+        // request of the same owner is replaced.
+        void designAsync(const void* owner, const FilterSpec& spec, Handler handler) {
+            {
+                std::lock_guard<std::mutex> lck(workMtx);
+                requests[owner] = { spec, handler };
+            }
+            workCnd.notify_all();
+        }
+
+        // Drop the pending request of an owner and wait for its handler to return if it's running.
+        // Must be called before the owner is destroyed or does a synchronous update.
+        void cancel(const void* owner) {
+            std::unique_lock<std::mutex> lck(workMtx);
+            requests.erase(owner);
+            if (std::this_thread::get_id() == workerThread.get_id()) { return; }
+            workCnd.wait(lck, [this, owner]() { return running != owner; });
+        }
+
+    private:
+        struct CacheEntry {
+            shared_taps taps;
+            uint64_t lastUse;
+        };
+
+        struct Request {
+            FilterSpec spec;
+            Handler handler;
+        };
+
+        void evict() {
+            auto oldest = cache.begin();
+            for (auto it = cache.begin(); it != cache.end(); it++) {
+                if (it->second.lastUse < oldest->second.lastUse) { oldest = it; }
+            }
+            cache.erase(oldest);
+        }
+
+        void worker() {
+            std::unique_lock<std::mutex> lck(workMtx);
+            while (true) {
+                workCnd.wait(lck, [this]() { return stop || !requests.empty(); });
+                if (stop) { return; }
+
+                // Take the next request
+                auto it = requests.begin();
+                const void* owner = it->first;
+                Request req = it->second;
+                requests.erase(it);
+                running = owner;
+                lck.unlock();
+
+                shared_taps taps = design(req.spec);
+
+                // Don't deliver if a newer request came in the meantime
+                lck.lock();
+                bool superseded = (requests.find(owner) != requests.end());
+                lck.unlock();
+                if (!superseded) { req.handler(taps); }
+                lck.lock();
+                running = NULL;
+                workCnd.notify_all();
+            }
+        }
+
+        std::mutex cacheMtx;
+        std::map<FilterSpec, CacheEntry> cache;
+        uint64_t useCounter = 0;
+
+        std::mutex workMtx;
+        std::condition_variable workCnd;
+        std::map<const void*, Request> requests;
+        const void* running = NULL;
+        bool stop = false;
+        std::thread workerThread;
+    };
+}
@@ -3,6 +3,7 @@
 #include "imgui.h"
 #include <stdio.h>
 #include <thread>
+#include <chrono>
 #include <complex>
 #include <gui/widgets/waterfall.h>
 #include <gui/widgets/frequency_select.h>
@@ -96,8 +97,10 @@ void MainWindow::init() {
     sigpath::vfoManager.onVfoCreated.bindHandler(&vfoCreatedHandler);
 
     flog::info("Loading modules");
+    auto loadStart = std::chrono::steady_clock::now();
 
-    // Load modules from /module directory
+    // List modules from /module directory
+    std::vector<std::string> modulePaths;
     if (std::filesystem::is_directory(modulesDir)) {
         for (const auto& file : std::filesystem::directory_iterator(modulesDir)) {
             std::string path = file.path().generic_string();
@@ -105,9 +108,7 @@ void MainWindow::init() {
                 continue;
             }
             if (!file.is_regular_file()) { continue; }
-            flog::info("Loading {0}", path);
-            LoadingScreen::show("Loading " + file.path().filename().string());
-            core::moduleManager.loadModule(path);
+            modulePaths.push_back(path);
         }
     }
     else {
@@ -120,28 +121,38 @@ void MainWindow::init() {
     auto modList = core::configManager.conf["moduleInstances"].items();
     core::configManager.release();
 
-    // Load additional modules specified through config
+    // Add modules specified through config
     for (auto const& path : modules) {
 #ifndef __ANDROID__
-        std::string apath = std::filesystem::absolute(path).string();
-        flog::info("Loading {0}", apath);
-        LoadingScreen::show("Loading " + std::filesystem::path(path).filename().string());
-        core::moduleManager.loadModule(apath);
+        modulePaths.push_back(std::filesystem::absolute(path).string());
 #else
-        core::moduleManager.loadModule(path);
+        modulePaths.push_back(path);
 #endif
     }
 
-    // Create module instances
+    // Load all modules
+    core::moduleManager.loadModules(modulePaths, [](std::string path, void* ctx) {
+        flog::info("Loading {0}", path);
+        LoadingScreen::show("Loading " + std::filesystem::path(path).filename().string());
+    });
+
+    // Create module instances. This stays sequential since the modules register themselves
+    // with the GUI and signal path, source modules only enumerate their devices once selected.
     for (auto const& [name, _module] : modList) {
         std::string mod = _module["module"];
         bool enabled = _module["enabled"];
         flog::info("Initializing {0} ({1})", name, mod);
         LoadingScreen::show("Initializing " + name + " (" + mod + ")");
+        auto start = std::chrono::steady_clock::now();
         core::moduleManager.createInstance(name, mod);
         if (!enabled) { core::moduleManager.disableInstance(name); }
+        auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        flog::info("Initialized {0} in {1}ms", name, (int64_t)time.count());
     }
 
+    auto loadTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - loadStart);
+    flog::info("Loaded modules in {0}ms", (int64_t)loadTime.count());
+
     // Load color maps
     LoadingScreen::show("Loading color maps");
     flog::info("Loading color maps");
@@ -261,6 +272,9 @@ void MainWindow::draw() {
     ImGui::Begin("Main", NULL, WINDOW_FLAGS);
     ImVec4 textCol = ImGui::GetStyleColorVec4(ImGuiCol_Text);
 
+    // Stop if the source stopped on its own
+    if (sigpath::sourceManager.takeStopRequest() && playing) { setPlayState(false); }
+
     ImGui::WaterfallVFO* vfo = NULL;
     if (gui::waterfall.selectedVFO != "") {
         vfo = gui::waterfall.vfos[gui::waterfall.selectedVFO];
@@ -35,6 +35,12 @@ namespace sourcemenu {
     bool showDelOffsetDialog = false;
     std::string delOffsetName = "";
 
+    int secondaryId = 0;
+    OptionList<std::string, std::string> secondaryCandidates;
+    OptionList<std::string, std::string> vfoSourceOptions;
+    std::map<std::string, double> secondaryFreqs;
+    EventHandler<VFOManager::VFO*> vfoCreatedHandler;
+
     // Offset IDs
     enum {
         OFFSET_ID_NONE,
@@ -113,12 +119,65 @@ namespace sourcemenu {
         sigpath::sourceManager.selectSource(name);
     }
 
+    void refreshSecondaries() {
+        // Sources that can still be added as secondary sources
+        secondaryCandidates.clear();
+        for (auto& name : sigpath::sourceManager.getSourceNames()) {
+            if (name == selectedSource || sigpath::sourceManager.isSecondary(name)) { continue; }
+            secondaryCandidates.define(name, name, name);
+        }
+        secondaryId = 0;
+
+        // Sources a VFO can be bound to, the empty name being the main source
+        vfoSourceOptions.clear();
+        vfoSourceOptions.define("", "Main", "");
+        for (auto& name : sigpath::sourceManager.getSecondaryNames()) {
+            vfoSourceOptions.define(name, name, name);
+        }
+    }
+
+    void bindVFOSource(const std::string& vfoName) {
+        core::configManager.acquire();
+        std::string source = core::configManager.conf["vfoSources"].contains(vfoName) ? core::configManager.conf["vfoSources"][vfoName] : "";
+        core::configManager.release();
+        if (!source.empty() && sigpath::sourceManager.isSecondary(source)) {
+            sigpath::vfoManager.setSource(vfoName, source);
+        }
+    }
+
+    void onVfoCreated(VFOManager::VFO* vfo, void* ctx) {
+        bindVFOSource(vfo->getName());
+    }
+
+    void addSecondarySource(const std::string& name, double freq) {
+        if (!sigpath::sourceManager.addSecondarySource(name)) { return; }
+        secondaryFreqs[name] = freq;
+        sigpath::sourceManager.tuneSecondary(name, freq);
+        refreshSecondaries();
+
+        // Rebind the VFOs that were using it
+        for (auto& [vfoName, vfo] : gui::waterfall.vfos) { bindVFOSource(vfoName); }
+    }
+
+    void removeSecondarySource(const std::string& name) {
+        sigpath::sourceManager.removeSecondarySource(name);
+        secondaryFreqs.erase(name);
+        refreshSecondaries();
+    }
+
     void onSourcesChanged(std::string name, void* ctx) {
         // Update the source list
         refreshSources();
 
         // Reselect the current source
         selectSource(selectedSource);
+
+        // Forget secondary sources that went away
+        for (auto it = secondaryFreqs.begin(); it != secondaryFreqs.end();) {
+            if (sigpath::sourceManager.isSecondary(it->first)) { it++; continue; }
+            it = secondaryFreqs.erase(it);
+        }
+        refreshSecondaries();
     }
 
     void onSourceUnregister(std::string name, void* ctx) {
@@ -161,11 +220,26 @@ namespace sourcemenu {
         // Define decimation values
         decimations.define(1, "None", 1);
         decimations.define(2, "2x", 2);
+        decimations.define(3, "3x", 3);
         decimations.define(4, "4x", 4);
+        decimations.define(5, "5x", 5);
+        decimations.define(6, "6x", 6);
         decimations.define(8, "8x", 8);
+        decimations.define(10, "10x", 10);
+        decimations.define(12, "12x", 12);
         decimations.define(16, "16x", 16);
+        decimations.define(20, "20x", 20);
+        decimations.define(24, "24x", 24);
+        decimations.define(25, "25x", 25);
         decimations.define(32, "32x", 32);
+        decimations.define(40, "40x", 40);
+        decimations.define(48, "48x", 48);
+        decimations.define(50, "50x", 50);
         decimations.define(64, "64x", 64);
+        decimations.define(100, "100x", 100);
+        decimations.define(128, "128x", 128);
+        decimations.define(250, "250x", 250);
+        decimations.define(256, "256x", 256);
 
         // Acquire the config file
         core::configManager.acquire();
@@ -180,6 +254,10 @@ namespace sourcemenu {
         if (decimations.keyExists(decimation)) {
             decimId = decimations.keyId(decimation);
         }
+        std::map<std::string, double> secondaries;
+        for (auto& s : core::configManager.conf["secondarySources"].items()) {
+            secondaries[s.key()] = s.value();
+        }
 
         // Release the config file
         core::configManager.release();
@@ -194,12 +272,21 @@ namespace sourcemenu {
         sigpath::iqFrontEnd.setDecimation(decimations.value(decimId));
         selectOffsetByName(selectedOffset);
 
+        // Restore the secondary sources, this also rebinds the existing VFOs
+        refreshSecondaries();
+        for (auto& [name, freq] : secondaries) {
+            if (name == sourcemenu::selectedSource || !sources.valueExists(name)) { continue; }
+            addSecondarySource(name, freq);
+        }
+
         // Register handlers
         sourcesChangedHandler.handler = onSourcesChanged;
         sourceUnregisterHandler.handler = onSourceUnregister;
         sigpath::sourceManager.onSourceRegistered.bindHandler(&sourcesChangedHandler);
         sigpath::sourceManager.onSourceUnregister.bindHandler(&sourceUnregisterHandler);
         sigpath::sourceManager.onSourceUnregistered.bindHandler(&sourcesChangedHandler);
+        vfoCreatedHandler.handler = onVfoCreated;
+        sigpath::vfoManager.onVfoCreated.bindHandler(&vfoCreatedHandler);
     }
 
     void addOffset(const std::string& name, double offset) {
@@ -289,11 +376,21 @@ namespace sourcemenu {
         if (running) { style::beginDisabled(); }
 
         ImGui::SetNextItemWidth(itemWidth);
-        if (ImGui::Combo("##source", &sourceId, sources.txt)) {
+        bool sourceChanged = ImGui::Combo("##source", &sourceId, sources.txt);
+
+        // Sources enumerate their devices lazily, start them all in the background once the list is about to be opened
+        // and enumerate them again when it's opened so that newly plugged devices show up
+        if (ImGui::IsItemHovered()) { sigpath::sourceManager.prefetchSources(); }
+        if (ImGui::IsItemActivated()) { sigpath::sourceManager.refreshSources(); }
+
+        if (sourceChanged) {
             std::string newSource = sources.value(sourceId);
             selectSource(newSource);
+            secondaryFreqs.erase(newSource);
+            refreshSecondaries();
             core::configManager.acquire();
             core::configManager.conf["source"] = newSource;
+            core::configManager.conf["secondarySources"].erase(newSource);
             core::configManager.release(true);
         }
 
@@ -374,5 +471,66 @@ namespace sourcemenu {
             core::configManager.release(true);
         }
         if (running) { style::endDisabled(); }
+
+        // Secondary sources
+        ImGui::LeftLabel("Secondary");
+        ImGui::SetNextItemWidth(itemWidth - ImGui::GetCursorPosX() - (lineHeight + 1.5f*spacing));
+        ImGui::Combo("##_sdrpp_sec_src", &secondaryId, secondaryCandidates.txt);
+        if (ImGui::IsItemHovered()) { sigpath::sourceManager.prefetchSources(); }
+        if (ImGui::IsItemActivated()) { sigpath::sourceManager.refreshSources(); }
+        ImGui::SameLine();
+        ImGui::SetCursorPosX(ImGui::GetCursorPosX() - spacing);
+        if (secondaryCandidates.empty()) { style::beginDisabled(); }
+        if (ImGui::Button("+##_sdrpp_sec_src_add_", ImVec2(lineHeight + 0.5f*spacing, 0))) {
+            std::string name = secondaryCandidates.value(secondaryId);
+            addSecondarySource(name, 100000000.0);
+            core::configManager.acquire();
+            core::configManager.conf["secondarySources"][name] = 100000000.0;
+            core::configManager.release(true);
+        }
+        if (secondaryCandidates.empty()) { style::endDisabled(); }
+
+        std::string toRemove = "";
+        for (auto& [name, freq] : secondaryFreqs) {
+            if (!ImGui::TreeNode((name + "##_sdrpp_sec_src_node_").c_str())) { continue; }
+
+            ImGui::LeftLabel("Frequency");
+            ImGui::FillWidth();
+            if (ImGui::InputDouble(("##_sdrpp_sec_src_freq_" + name).c_str(), &freq, 1000.0, 1000000.0, "%.0f", ImGuiInputTextFlags_EnterReturnsTrue)) {
+                sigpath::sourceManager.tuneSecondary(name, freq);
+                core::configManager.acquire();
+                core::configManager.conf["secondarySources"][name] = freq;
+                core::configManager.release(true);
+            }
+
+            sigpath::sourceManager.showSecondaryMenu(name);
+
+            if (ImGui::Button(("Remove##_sdrpp_sec_src_del_" + name).c_str(), ImVec2(ImGui::GetContentRegionAvail().x, 0))) {
+                toRemove = name;
+            }
+            ImGui::TreePop();
+        }
+        if (!toRemove.empty()) {
+            removeSecondarySource(toRemove);
+            core::configManager.acquire();
+            core::configManager.conf["secondarySources"].erase(toRemove);
+            core::configManager.release(true);
+        }
+
+        // Source used by each VFO, only useful when there are secondary sources
+        if (secondaryFreqs.empty()) { return; }
+        for (auto& [vfoName, wtfVFO] : gui::waterfall.vfos) {
+            std::string source = sigpath::vfoManager.getSource(vfoName);
+            int id = vfoSourceOptions.keyExists(source) ? vfoSourceOptions.keyId(source) : 0;
+            ImGui::LeftLabel(vfoName.c_str());
+            ImGui::FillWidth();
+            if (ImGui::Combo(("##_sdrpp_vfo_src_" + vfoName).c_str(), &id, vfoSourceOptions.txt)) {
+                std::string newSource = vfoSourceOptions.value(id);
+                sigpath::vfoManager.setSource(vfoName, newSource);
+                core::configManager.acquire();
+                core::configManager.conf["vfoSources"][vfoName] = newSource;
+                core::configManager.release(true);
+            }
+        }
     }
 }
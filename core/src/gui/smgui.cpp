@@ -38,7 +38,7 @@ namespace SmGui {
     }
     
     // Rec/Play functions
-    void setDiff(std::string id, SmGui::DrawListElem value) {
+    void setDiff(const std::string& id, const SmGui::DrawListElem& value) {
         diffId = id;
         diffValue = value;
     }
@@ -47,9 +47,11 @@ namespace SmGui {
 
     void startRecord(DrawList* dl) {
         rdl = dl;
+        if (rdl) { rdl->beginUpdate(); }
     }
 
     void stopRecord() {
+        if (rdl) { rdl->endUpdate(); }
         rdl = NULL;
     }
 
@@ -203,53 +205,127 @@ namespace SmGui {
     }
 
     // Drawlist stuff
+    int DrawList::nextElem(DrawListElemType type) {
+        // Append if not updating or if the list grew
+        if (updateId < 0 || updateId >= elements.size()) {
+            elements.emplace_back();
+            elements.back().type = type;
+            changed.resize(elements.size(), true);
+            changed.back() = true;
+            if (updateId >= 0) { updateId++; }
+            return elements.size() - 1;
+        }
+
+        // Otherwise reuse the existing element
+        int id = updateId++;
+        if (elements[id].type != type) {
+            elements[id].type = type;
+            changed[id] = true;
+        }
+        return id;
+    }
+
     void DrawList::pushStep(DrawStep step, bool forceSync) {
-        DrawListElem elem;
-        elem.type = DRAW_LIST_ELEM_TYPE_DRAW_STEP;
-        elem.step = step;
-        elem.forceSync = forceSync;
-        elements.push_back(elem);
+        int id = nextElem(DRAW_LIST_ELEM_TYPE_DRAW_STEP);
+        DrawListElem& elem = elements[id];
+        if (changed[id] || elem.step != step || elem.forceSync != forceSync) {
+            elem.step = step;
+            elem.forceSync = forceSync;
+            changed[id] = true;
+        }
     }
 
     void DrawList::pushBool(bool b) {
-        DrawListElem elem;
-        elem.type = DRAW_LIST_ELEM_TYPE_BOOL;
-        elem.b = b;
-        elements.push_back(elem);
+        int id = nextElem(DRAW_LIST_ELEM_TYPE_BOOL);
+        DrawListElem& elem = elements[id];
+        if (changed[id] || elem.b != b) {
+            elem.b = b;
+            changed[id] = true;
+        }
     }
     
     void DrawList::pushInt(int i) {
-        DrawListElem elem;
-        elem.type = DRAW_LIST_ELEM_TYPE_INT;
-        elem.i = i;
-        elements.push_back(elem);
+        int id = nextElem(DRAW_LIST_ELEM_TYPE_INT);
+        DrawListElem& elem = elements[id];
+        if (changed[id] || elem.i != i) {
+            elem.i = i;
+            changed[id] = true;
+        }
     }
     
     void DrawList::pushFloat(float f) {
-        DrawListElem elem;
-        elem.type = DRAW_LIST_ELEM_TYPE_FLOAT;
-        elem.f = f;
-        elements.push_back(elem);
+        int id = nextElem(DRAW_LIST_ELEM_TYPE_FLOAT);
+        DrawListElem& elem = elements[id];
+        if (changed[id] || elem.f != f) {
+            elem.f = f;
+            changed[id] = true;
+        }
+    }
+
+    void DrawList::pushString(const char* str) {
+        pushString(str, strlen(str));
+    }
+
+    void DrawList::pushString(const char* str, int len) {
+        int id = nextElem(DRAW_LIST_ELEM_TYPE_STRING);
+        DrawListElem& elem = elements[id];
+        if (changed[id] || elem.str.size() != len || memcmp(elem.str.data(), str, len)) {
+            elem.str.assign(str, len);
+            changed[id] = true;
+        }
     }
     
-    void DrawList::pushString(std::string str) {
-        DrawListElem elem;
-        elem.type = DRAW_LIST_ELEM_TYPE_STRING;
-        elem.str = str;
-        elements.push_back(elem);
+    void DrawList::pushString(const std::string& str) {
+        pushString(str.data(), str.size());
+    }
+
+    void DrawList::beginUpdate() {
+        changed.resize(elements.size(), true);
+        updateId = 0;
+    }
+
+    void DrawList::endUpdate() {
+        // Drop the elements that weren't drawn this time
+        if (updateId >= 0 && updateId < elements.size()) {
+            elements.resize(updateId);
+            changed.resize(updateId);
+        }
+        updateId = -1;
+    }
+
+    void DrawList::invalidate() {
+        changed.assign(elements.size(), true);
+    }
+
+    void DrawList::invalidate(const std::string& id) {
+        changed.resize(elements.size(), true);
+        int count = elements.size();
+        for (int i = 0; i < count; i++) {
+            if (elements[i].type != DRAW_LIST_ELEM_TYPE_STRING || elements[i].str != id) { continue; }
+
+            // Flag the entire widget, from its draw step to the next one
+            int start = i;
+            while (start > 0 && elements[start].type != DRAW_LIST_ELEM_TYPE_DRAW_STEP) { start--; }
+            changed[start++] = true;
+            for (; start < count && elements[start].type != DRAW_LIST_ELEM_TYPE_DRAW_STEP; start++) {
+                changed[start] = true;
+            }
+        }
     }
 
     int DrawList::loadItem(DrawListElem& elem, uint8_t* data, int len) {
         // Get type
+        if (len < 1) { return -1; }
         int i = 0;
         elem.type = (DrawListElemType)data[i++];
+        len--;
 
         // Read data depending on type
         if (elem.type == DRAW_LIST_ELEM_TYPE_DRAW_STEP && len >= 2) {
             elem.step = (DrawStep)data[i++];
             elem.forceSync = data[i++];
         }
-        else if (elem.type == DRAW_LIST_ELEM_TYPE_BOOL && len-- >= 1) {
+        else if (elem.type == DRAW_LIST_ELEM_TYPE_BOOL && len >= 1) {
             elem.b = data[i++];
         }
         else if (elem.type == DRAW_LIST_ELEM_TYPE_INT && len >= 4) {
@@ -263,7 +339,7 @@ namespace SmGui {
         else if (elem.type == DRAW_LIST_ELEM_TYPE_STRING && len >= 2) {
             uint16_t slen = *(uint16_t*)&data[i];
             if (len < slen + 2) { return -1; }
-            elem.str = std::string(&data[i + 2], &data[i + 2 + slen]);
+            elem.str.assign((char*)&data[i + 2], slen);
             i += slen + 2;
         }
         else {
@@ -301,6 +377,62 @@ namespace SmGui {
         return i;
     }
 
+    int DrawList::loadDelta(void* data, int len) {
+        uint8_t* buf = (uint8_t*)data;
+        if (len < 4) { return -1; }
+
+        // Check that every element count is plausible, every element that isn't new is at least 2 bytes long
+        int i = 0;
+        uint32_t count = *(uint32_t*)&buf[i];
+        i += 4;
+        len -= 4;
+        if (count > elements.size() + (len / 2)) { return -1; }
+
+        // Check the whole delta before touching the list
+        DrawListElem dummy;
+        for (int j = i, left = len; left > 0;) {
+            if (left < 8) { return -1; }
+            uint32_t start = *(uint32_t*)&buf[j];
+            uint32_t n = *(uint32_t*)&buf[j + 4];
+            j += 8;
+            left -= 8;
+            if (n > count || start > count - n) { return -1; }
+            for (uint32_t k = 0; k < n; k++) {
+                int consumed = loadItem(dummy, &buf[j], left);
+                if (consumed < 0) { return -1; }
+                j += consumed;
+                left -= consumed;
+            }
+        }
+
+        // Keep the current list in case the result doesn't validate
+        std::vector<DrawListElem> prev = elements;
+        elements.resize(count);
+
+        // Overwrite the elements of each run
+        while (len > 0) {
+            uint32_t start = *(uint32_t*)&buf[i];
+            uint32_t n = *(uint32_t*)&buf[i + 4];
+            i += 8;
+            len -= 8;
+            for (uint32_t j = start; j < start + n; j++) {
+                int consumed = loadItem(elements[j], &buf[i], len);
+                i += consumed;
+                len -= consumed;
+            }
+        }
+
+        // Validate and restore if invalid
+        if (!validate()) {
+            flog::error("Drawlist validation failed");
+            elements = std::move(prev);
+            return -1;
+        }
+        changed.resize(count, false);
+
+        return i;
+    }
+
     int DrawList::storeItem(DrawListElem& elem, void* data, int len) {
         // Check size requirement
         uint8_t* buf = (uint8_t*)data;
@@ -356,6 +488,45 @@ namespace SmGui {
         return i;
     }
 
+    int DrawList::storeDelta(void* data, int len) {
+        uint8_t* buf = (uint8_t*)data;
+        if (len < 4) { return -1; }
+        int count = elements.size();
+        changed.resize(count, true);
+
+        // Store the element count
+        int i = 0;
+        *(uint32_t*)&buf[i] = count;
+        i += 4;
+        len -= 4;
+
+        // Store each run of changed elements, prefixed by its start and length
+        for (int start = 0; start < count;) {
+            if (!changed[start]) {
+                start++;
+                continue;
+            }
+            int end = start;
+            while (end < count && changed[end]) { end++; }
+
+            if (len < 8) { return -1; }
+            *(uint32_t*)&buf[i] = start;
+            *(uint32_t*)&buf[i + 4] = end - start;
+            i += 8;
+            len -= 8;
+
+            for (; start < end; start++) {
+                int n = storeItem(elements[start], &buf[i], len);
+                if (n < 0) { return -1; }
+                i += n;
+                len -= n;
+                changed[start] = false;
+            }
+        }
+
+        return i;
+    }
+
     int DrawList::getItemSize(DrawListElem& elem) {
         if (elem.type == DRAW_LIST_ELEM_TYPE_DRAW_STEP) { return 3; }
         else if (elem.type == DRAW_LIST_ELEM_TYPE_BOOL) { return 2; }
@@ -493,7 +664,9 @@ namespace SmGui {
             rdl->pushStep(DRAW_STEP_COMBO, forceSyncForNext);
             rdl->pushString(label);
             rdl->pushInt(*current_item);
-            rdl->pushString(ImStrToString(items_separated_by_zeros));
+            const char* itemsEnd = items_separated_by_zeros;
+            while (*itemsEnd) { itemsEnd += strlen(itemsEnd) + 1; }
+            rdl->pushString(items_separated_by_zeros, itemsEnd - items_separated_by_zeros);
             rdl->pushInt(popup_max_height_in_items);
             forceSyncForNext = false;
         }
@@ -83,26 +83,43 @@ namespace SmGui {
         void pushBool(bool b);
         void pushInt(int i);
         void pushFloat(float f);
-        void pushString(std::string str);
+        void pushString(const char* str);
+        void pushString(const char* str, int len);
+        void pushString(const std::string& str);
+
+        // While updating, pushed elements overwrite the existing ones in place instead of being appended.
+        // This reuses their storage and keeps track of which elements changed for the next delta.
+        void beginUpdate();
+        void endUpdate();
+        void invalidate();
+        void invalidate(const std::string& id);
 
         void draw(std::string& diffId, DrawListElem& diffValue, bool& syncRequired);
         
         static int loadItem(DrawListElem& elem, uint8_t* data, int len);
         int load(void* data, int len);
+        int loadDelta(void* data, int len);
         static int storeItem(DrawListElem& elem, void* data, int len);
         int store(void* data, int len);
+        int storeDelta(void* data, int len);
         static int getItemSize(DrawListElem& elem);
         int getSize();
         bool checkTypes(int firstId, int n, ...);
         bool validate();
 
         std::vector<DrawListElem> elements;
+
+    private:
+        int nextElem(DrawListElemType type);
+
+        int updateId = -1;
+        std::vector<bool> changed;
     };
 
     // Rec/Play functions
     // TODO: Maybe move verification to the load function instead of checking in drawFrame
     void init(bool server);
-    void setDiff(std::string id, SmGui::DrawListElem value);
+    void setDiff(const std::string& id, const SmGui::DrawListElem& value);
     void startRecord(DrawList* dl);
     void stopRecord();
 
@@ -27,6 +27,7 @@ namespace ImGui {
         int _height;
 
         GLuint textureId;
+        bool textureAllocated = false;
 
         bool newData = false;
     };
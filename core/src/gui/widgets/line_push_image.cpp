@@ -1,13 +1,23 @@
 #include <gui/widgets/line_push_image.h>
+#include <algorithm>
+
+// Not defined by the OpenGL 1.1 headers of some platforms
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
 
 namespace ImGui {
     LinePushImage::LinePushImage(int frameWidth, int reservedIncrement) {
         _frameWidth = frameWidth;
         _reservedIncrement = reservedIncrement;
-        frameBuffer = (uint8_t*)malloc(_frameWidth * _reservedIncrement * 4);
-        reservedCount = reservedIncrement;
+    }
 
-        glGenTextures(1, &textureId);
+    LinePushImage::~LinePushImage() {
+        for (auto& tile : tiles) {
+            free(tile.buffer);
+            if (tile.textureId) { unusedTextures.push_back(tile.textureId); }
+        }
+        if (!unusedTextures.empty()) { glDeleteTextures(unusedTextures.size(), unusedTextures.data()); }
     }
 
     void LinePushImage::draw(const ImVec2& size_arg) {
@@ -34,27 +44,39 @@ namespace ImGui {
 
         if (newData) {
             newData = false;
-            updateTexture();
+            updateTextures();
         }
 
-        window->DrawList->AddImage((void*)(intptr_t)textureId, min, ImVec2(min.x + width, min.y + height));
+        // Draw the tiles one under the other, only the filled part of each texture is shown
+        float lineHeight = width / (float)_frameWidth;
+        float y = min.y;
+        for (auto& tile : tiles) {
+            if (!tile.lineCount) { break; }
+            float tileHeight = lineHeight * (float)tile.lineCount;
+            float v = (float)tile.lineCount / (float)tile.capacity;
+            window->DrawList->AddImage((void*)(intptr_t)tile.textureId, ImVec2(min.x, y), ImVec2(min.x + width, y + tileHeight), ImVec2(0, 0), ImVec2(1, v));
+            y += tileHeight;
+        }
     }
 
     uint8_t* LinePushImage::acquireNextLine(int count) {
         bufferMtx.lock();
 
-        int oldLineCount = _lineCount;
-        _lineCount += count;
-
-        // If new data either fills up or exceeds the limit, reallocate
-        // TODO: Change it to avoid bug if count >= reservedIncrement
-        if (_lineCount > reservedCount) {
-            printf("Reallocating\n");
-            reservedCount += _reservedIncrement;
-            frameBuffer = (uint8_t*)realloc(frameBuffer, _frameWidth * reservedCount * 4);
+        // Lines must be contiguous, if they don't fit in the last tile start a new one big enough for them
+        int last = (int)tiles.size() - 1;
+        if (last < 0 || tiles[last].lineCount + count > tiles[last].capacity) {
+            Tile tile;
+            tile.capacity = std::max<int>(_reservedIncrement, count);
+            tile.buffer = (uint8_t*)malloc(_frameWidth * tile.capacity * 4);
+            tiles.push_back(tile);
+            last++;
         }
 
-        return &frameBuffer[_frameWidth * oldLineCount * 4];
+        Tile& tile = tiles[last];
+        uint8_t* line = &tile.buffer[_frameWidth * tile.lineCount * 4];
+        tile.lineCount += count;
+        _lineCount += count;
+        return line;
     }
 
     void LinePushImage::releaseNextLine() {
@@ -64,9 +86,18 @@ namespace ImGui {
 
     void LinePushImage::clear() {
         std::lock_guard<std::mutex> lck(bufferMtx);
+
+        // Keep the first tile, textures can only be deleted from the GUI thread
+        for (int i = 1; i < (int)tiles.size(); i++) {
+            free(tiles[i].buffer);
+            if (tiles[i].textureId) { unusedTextures.push_back(tiles[i].textureId); }
+        }
+        if (!tiles.empty()) {
+            tiles.resize(1);
+            tiles[0].lineCount = 0;
+            tiles[0].uploadedCount = 0;
+        }
         _lineCount = 0;
-        frameBuffer = (uint8_t*)realloc(frameBuffer, _frameWidth * _reservedIncrement * 4);
-        reservedCount = _reservedIncrement;
         newData = true;
     }
 
@@ -78,12 +109,33 @@ namespace ImGui {
         return _lineCount;
     }
 
-    void LinePushImage::updateTexture() {
-        glBindTexture(GL_TEXTURE_2D, textureId);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    void LinePushImage::updateTextures() {
+        if (!unusedTextures.empty()) {
+            glDeleteTextures(unusedTextures.size(), unusedTextures.data());
+            unusedTextures.clear();
+        }
+
         glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _frameWidth, _lineCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, frameBuffer);
+        for (auto& tile : tiles) {
+            if (tile.uploadedCount == tile.lineCount) { continue; }
+
+            // Allocate the whole tile once, then only upload the lines added since the last update
+            if (!tile.textureId) {
+                glGenTextures(1, &tile.textureId);
+                glBindTexture(GL_TEXTURE_2D, tile.textureId);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, _frameWidth, tile.capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+            }
+            else {
+                glBindTexture(GL_TEXTURE_2D, tile.textureId);
+            }
+            int first = tile.uploadedCount;
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, first, _frameWidth, tile.lineCount - first, GL_RGBA, GL_UNSIGNED_BYTE, &tile.buffer[_frameWidth * first * 4]);
+            tile.uploadedCount = tile.lineCount;
+        }
     }
 
-}
\ No newline at end of file
+}
@@ -4,13 +4,17 @@
 #include <imgui_internal.h>
 #include <dsp/stream.h>
 #include <mutex>
+#include <vector>
 
 #include <utils/opengl_include_code.h>
 
 namespace ImGui {
+    // Image that grows one line at a time. The lines are stored in fixed size tiles that each
+    // have their own texture, so pushing lines never moves old lines and only uploads the new ones.
     class LinePushImage {
     public:
         LinePushImage(int frameWidth, int reservedIncrement);
+        ~LinePushImage();
 
         void draw(const ImVec2& size_arg = ImVec2(0, 0));
 
@@ -25,18 +29,24 @@ namespace ImGui {
         int getLineCount();
 
     private:
-        void updateTexture();
+        struct Tile {
+            uint8_t* buffer;
+            int capacity;
+            int lineCount = 0;
+            int uploadedCount = 0;
+            GLuint textureId = 0;
+        };
+
+        void updateTextures();
 
         std::mutex bufferMtx;
-        uint8_t* frameBuffer;
+        std::vector<Tile> tiles;
+        std::vector<GLuint> unusedTextures;
 
         int _frameWidth;
         int _reservedIncrement;
         int _lineCount = 0;
-        int reservedCount = 0;
-
-        GLuint textureId;
 
         bool newData = false;
     };
-}
\ No newline at end of file
+}
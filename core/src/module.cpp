@@ -1,6 +1,7 @@
 #include <module.h>
 #include <filesystem>
 #include <utils/flog.h>
+#include <chrono>
 
 ModuleManager::Module_t ModuleManager::loadModule(std::string path) {
     Module_t mod;
@@ -83,6 +84,17 @@ ModuleManager::Module_t ModuleManager::loadModule(std::string path) {
     return mod;
 }
 
+void ModuleManager::loadModules(const std::vector<std::string>& paths, void (*progress)(std::string path, void* ctx), void* ctx) {
+    // Load one after the other, the dynamic loader serializes the opening of libraries anyway
+    for (const auto& path : paths) {
+        if (progress) { progress(path, ctx); }
+        auto start = std::chrono::steady_clock::now();
+        loadModule(path);
+        auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        flog::info("Loaded {0} in {1}ms", path, (int64_t)time.count());
+    }
+}
+
 int ModuleManager::createInstance(std::string name, std::string module) {
     if (modules.find(module) == modules.end()) {
         flog::error("Module '{0}' doesn't exist", module);
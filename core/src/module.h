@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <map>
+#include <vector>
 #include <json.hpp>
 #include <utils/event.h>
 
@@ -79,6 +80,14 @@ public:
 
     ModuleManager::Module_t loadModule(std::string path);
 
+    /**
+     * Load several modules in the given order.
+     * @param paths Paths of the modules.
+     * @param progress Called right before each module is loaded. Can be NULL.
+     * @param ctx Context passed to the progress callback.
+     */
+    void loadModules(const std::vector<std::string>& paths, void (*progress)(std::string path, void* ctx) = NULL, void* ctx = NULL);
+
     int createInstance(std::string name, std::string module);
     int deleteInstance(std::string name);
     int deleteInstance(ModuleManager::Instance* instance);
@@ -0,0 +1,155 @@
+#include "offline.h"
+#include <core.h>
+#include <signal_path/signal_path.h>
+#include <dsp/sink/null_sink.h>
+#include <utils/flog.h>
+#include "../../misc_modules/recorder/src/recorder_interface.h"
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include <chrono>
+
+#define OFFLINE_FFT_SIZE        1024
+#define OFFLINE_POLL_INTERVAL   100
+
+namespace offline {
+    dsp::stream<dsp::complex_t> dummyStream;
+    dsp::stream<dsp::complex_t> iqTap;
+    dsp::sink::Null<dsp::complex_t> iqTapSink;
+    float* fftBuffer = NULL;
+
+    // Nothing displays the FFT, it's computed into a scratch buffer
+    float* acquireFFTBuffer(void* ctx) {
+        return fftBuffer;
+    }
+
+    void releaseFFTBuffer(void* ctx) {}
+
+    bool finished() {
+        if (!iqTap.isEndOfStream()) { return false; }
+        for (const auto& name : sigpath::sinkManager.getStreamNames()) {
+            if (!sigpath::sinkManager.streamEnded(name)) { return false; }
+        }
+        return true;
+    }
+
+    int main() {
+        flog::info("=====| OFFLINE MODE |=====");
+
+        std::string input = core::args["offline"].s();
+        if (!std::filesystem::is_regular_file(input)) {
+            flog::error("Input file {0} does not exist", input);
+            return -1;
+        }
+
+        // Init the IQ frontend without buffering so that the file source is only paced by the processing
+        fftBuffer = dsp::buffer::alloc<float>(OFFLINE_FFT_SIZE);
+        sigpath::iqFrontEnd.init(&dummyStream, 8000000, false, 1, false, OFFLINE_FFT_SIZE, 1.0, IQFrontEnd::FFTWindow::RECTANGULAR, acquireFFTBuffer, releaseFFTBuffer, NULL);
+        sigpath::iqFrontEnd.start();
+
+        // Load config
+        core::configManager.acquire();
+        std::string modulesDir = core::configManager.conf["modulesDirectory"];
+        std::vector<std::string> modules = core::configManager.conf["modules"];
+        auto modList = core::configManager.conf["moduleInstances"].items();
+        core::configManager.release();
+        modulesDir = std::filesystem::absolute(modulesDir).string();
+
+        // Nothing is played back, sink modules are loaded but every stream stays on the null sink
+        sigpath::sinkManager.forceNullSinks(true);
+
+        // Load modules
+        flog::info("Loading modules");
+        if (std::filesystem::is_directory(modulesDir)) {
+            for (const auto& file : std::filesystem::directory_iterator(modulesDir)) {
+                std::string path = file.path().generic_string();
+                if (file.path().extension().generic_string() != SDRPP_MOD_EXTENTSION) {
+                    continue;
+                }
+                if (!file.is_regular_file()) { continue; }
+
+                flog::info("Loading {0}", path);
+                core::moduleManager.loadModule(path);
+            }
+        }
+        else {
+            flog::warn("Module directory {0} does not exist, not loading modules from directory", modulesDir);
+        }
+
+        // Load additional modules through the config
+        for (auto const& apath : modules) {
+            std::filesystem::path file = std::filesystem::absolute(apath);
+            std::string path = file.generic_string();
+            if (!std::filesystem::is_regular_file(file)) { continue; }
+
+            flog::info("Loading {0}", path);
+            core::moduleManager.loadModule(path);
+        }
+
+        // Create module instances
+        std::vector<std::string> instances;
+        for (auto const& [name, _module] : modList) {
+            std::string mod = _module["module"];
+            bool enabled = _module["enabled"];
+            if (core::moduleManager.modules.find(mod) == core::moduleManager.modules.end()) { continue; }
+            flog::info("Initializing {0} ({1})", name, mod);
+            core::moduleManager.createInstance(name, mod);
+            if (!enabled) { core::moduleManager.disableInstance(name); }
+            instances.push_back(name);
+        }
+
+        // Select the source playing the input, the file source reads it from the command line by default
+        std::string source = core::args["offline_source"].s();
+        auto sources = sigpath::sourceManager.getSourceNames();
+        if (std::find(sources.begin(), sources.end(), source) == sources.end()) {
+            flog::error("Source '{0}' does not exist", source);
+            return -1;
+        }
+        sigpath::sourceManager.selectSource(source);
+
+        // Do post-init
+        core::moduleManager.doPostInitAll();
+
+        // Record the whole file with every enabled recorder, named after the input so that runs don't overwrite each other
+        std::string prefix = std::filesystem::path(input).stem().string() + "_";
+        std::vector<std::string> recorders;
+        for (const auto& name : instances) {
+            if (core::modComManager.getModuleName(name) != "recorder" || !core::moduleManager.instanceEnabled(name)) { continue; }
+            core::modComManager.callInterface(name, RECORDER_IFACE_CMD_SET_NAME_PREFIX, &prefix, NULL);
+            recorders.push_back(name);
+        }
+
+        // Tap the baseband to know when the whole file went through the frontend
+        sigpath::iqFrontEnd.bindIQStream(&iqTap);
+        iqTapSink.init(&iqTap);
+        iqTapSink.start();
+
+        // Process the file and wait for the end of stream to reach every audio stream
+        flog::info("Processing {0}", input);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const auto& name : recorders) {
+            core::modComManager.callInterface(name, RECORDER_IFACE_CMD_START, NULL, NULL);
+        }
+        sigpath::sourceManager.start();
+        while (!finished()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(OFFLINE_POLL_INTERVAL));
+        }
+        double duration = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+        flog::info("Processing done in {0}s", duration);
+
+        // Stop everything and let the recorders finalize their files
+        for (const auto& name : recorders) {
+            core::modComManager.callInterface(name, RECORDER_IFACE_CMD_STOP, NULL, NULL);
+        }
+        sigpath::sourceManager.stop();
+        iqTapSink.stop();
+        sigpath::iqFrontEnd.unbindIQStream(&iqTap);
+        for (const auto& name : instances) {
+            core::moduleManager.deleteInstance(name);
+        }
+        sigpath::iqFrontEnd.stop();
+        dsp::buffer::free(fftBuffer);
+
+        return 0;
+    }
+}
@@ -36,6 +36,11 @@ namespace server {
 
     SmGui::DrawListElem dummyElem;
 
+    // UI state last sent to the client, only the elements that changed since are sent
+    SmGui::DrawList uiDrawList;
+    SmGui::DrawListElem diffId;
+    SmGui::DrawListElem diffValue;
+
     ZSTD_CCtx* cctx;
 
     net::Listener listener;
@@ -248,6 +253,15 @@ namespace server {
 
     void commandHandler(Command cmd, uint8_t* data, int len) {
         if (cmd == COMMAND_GET_UI) {
+            // Reject clients expecting another UI format
+            if (len < 4 || *(uint32_t*)data != SERVER_PROTOCOL_VERSION) {
+                flog::error("Client uses an incompatible protocol version");
+                sendError(ERROR_INVALID_VERSION);
+                return;
+            }
+
+            // The client has nothing to apply a delta to, send everything
+            uiDrawList.invalidate();
             sendUI(COMMAND_GET_UI, "", dummyElem);
         }
         else if (cmd == COMMAND_UI_ACTION && len >= 3) {
@@ -257,7 +271,6 @@ namespace server {
             len--;
             
             // Load id
-            SmGui::DrawListElem diffId;
             int count = SmGui::DrawList::loadItem(diffId, &data[i], len);
             if (count < 0) { sendError(ERROR_INVALID_ARGUMENT); return; }
             if (diffId.type != SmGui::DRAW_LIST_ELEM_TYPE_STRING) { sendError(ERROR_INVALID_ARGUMENT); return; } 
@@ -265,12 +278,15 @@ namespace server {
             len -= count;
 
             // Load value
-            SmGui::DrawListElem diffValue;
             count = SmGui::DrawList::loadItem(diffValue, &data[i], len);
             if (count < 0) { sendError(ERROR_INVALID_ARGUMENT); return; }
             i += count;
             len -= count;
 
+            // The client already applied the action locally, send the widget again on the next update
+            // in case the server didn't accept the value as is
+            uiDrawList.invalidate(diffId.str);
+
             // Render and send back
             if (sendback) {
                 sendUI(COMMAND_UI_ACTION, diffId.str, diffValue);
@@ -319,7 +335,7 @@ namespace server {
         sigpath::sourceManager.showSelectedMenu();
     }
 
-    void renderUI(SmGui::DrawList* dl, std::string diffId, SmGui::DrawListElem diffValue) {
+    void renderUI(SmGui::DrawList* dl, const std::string& diffId, const SmGui::DrawListElem& diffValue) {
         // If we're recording and there's an action, render once with the action and record without
 
         if (dl && !diffId.empty()) {
@@ -339,17 +355,21 @@ namespace server {
         }
     }
 
-    void sendUI(Command originCmd, std::string diffId, SmGui::DrawListElem diffValue) {
+    void sendUI(Command originCmd, const std::string& diffId, const SmGui::DrawListElem& diffValue) {
         // Render UI
-        SmGui::DrawList dl;
-        renderUI(&dl, diffId, diffValue);
+        renderUI(&uiDrawList, diffId, diffValue);
 
         // Create response
-        int size = dl.getSize();
-        dl.store(s_cmd_data, size);
+        *(uint32_t*)s_cmd_data = SERVER_PROTOCOL_VERSION;
+        int size = uiDrawList.storeDelta(&s_cmd_data[4], SERVER_MAX_PACKET_SIZE - sizeof(PacketHeader) - sizeof(CommandHeader) - 4);
+        if (size < 0) {
+            flog::error("UI too large to be sent");
+            sendError(ERROR_INVALID_ARGUMENT);
+            return;
+        }
 
         // Send to network
-        sendCommandAck(originCmd, size);
+        sendCommandAck(originCmd, size + 4);
     }
 
     void sendError(Error err) {
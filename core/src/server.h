@@ -15,8 +15,8 @@ namespace server {
     void drawMenu();
 
     void commandHandler(Command cmd, uint8_t* data, int len);
-    void renderUI(SmGui::DrawList* dl, std::string diffId, SmGui::DrawListElem diffValue);
-    void sendUI(Command originCmd, std::string diffId, SmGui::DrawListElem diffValue);
+    void renderUI(SmGui::DrawList* dl, const std::string& diffId, const SmGui::DrawListElem& diffValue);
+    void sendUI(Command originCmd, const std::string& diffId, const SmGui::DrawListElem& diffValue);
     void sendError(Error err);
     void sendSampleRate(double sampleRate);
     void setInputSampleRate(double samplerate);
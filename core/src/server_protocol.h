@@ -5,6 +5,10 @@
 
 #define SERVER_MAX_PACKET_SIZE  (STREAM_BUFFER_SIZE * sizeof(dsp::complex_t) * 2)
 
+// Sent by the client with GET_UI and ahead of every UI sent by the server. The low byte can't be a draw list
+// element type so that the UI of servers predating the version, which starts with the first element, is rejected too.
+#define SERVER_PROTOCOL_VERSION 0x000002FF
+
 namespace server {
     enum PacketType {
         // Client to Server
@@ -37,7 +41,8 @@ namespace server {
         ERROR_NONE = 0x00,
         ERROR_INVALID_PACKET,
         ERROR_INVALID_COMMAND,
-        ERROR_INVALID_ARGUMENT
+        ERROR_INVALID_ARGUMENT,
+        ERROR_INVALID_VERSION
     };
     
 #pragma pack(push, 1)
@@ -4,11 +4,13 @@
 #include <utils/flog.h>
 #include <gui/gui.h>
 #include <core.h>
+#include <signal_path/signal_path.h>
 
 IQFrontEnd::~IQFrontEnd() {
     if (!_init) { return; }
     stop();
     dsp::buffer::free(fftWindowBuf);
+    dsp::buffer::free(fftDbOut);
     fftwf_destroy_plan(fftwPlan);
     fftwf_free(fftInBuf);
     fftwf_free(fftOutBuf);
@@ -60,11 +62,13 @@ void IQFrontEnd::init(dsp::stream<dsp::complex_t>* in, double sampleRate, bool b
     fftInBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
     fftOutBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
     fftwPlan = fftwf_plan_dft_1d(_fftSize, fftInBuf, fftOutBuf, FFTW_FORWARD, FFTW_ESTIMATE);
+    fftDbOut = dsp::buffer::alloc<float>(_fftSize);
 
     // Clear the rest of the FFT input buffer
     dsp::buffer::clear(fftInBuf, _fftSize - _nzFFTSize, _nzFFTSize);
 
-    split.bindStream(&fftIn);
+    // Without an FFT buffer, the FFT path is only used once a tap is bound
+    if (_acquireFFTBuffer) { setFFTPathEnabled(true); }
 
     _init = true;
 }
@@ -76,16 +80,16 @@ void IQFrontEnd::setInput(dsp::stream<dsp::complex_t>* in) {
 void IQFrontEnd::setSampleRate(double sampleRate) {
     // Temp stop the necessary blocks
     dcBlock.tempStop();
-    for (auto& [name, vfo] : vfos) {
-        vfo->tempStop();
+    for (auto& chan : channels) {
+        chan->vfo.tempStop();
     }
 
     // Update the samplerate
     _sampleRate = sampleRate;
     effectiveSr = _sampleRate / _decimRatio;
     dcBlock.setRate(genDCBlockRate(effectiveSr));
-    for (auto& [name, vfo] : vfos) {
-        vfo->setInSamplerate(effectiveSr);
+    for (auto& chan : channels) {
+        chan->vfo.setInSamplerate(effectiveSr);
     }
 
     // Reconfigure the FFT
@@ -93,13 +97,14 @@ void IQFrontEnd::setSampleRate(double sampleRate) {
 
     // Restart blocks
     dcBlock.tempStart();
-    for (auto& [name, vfo] : vfos) {
-        vfo->tempStart();
+    for (auto& chan : channels) {
+        chan->vfo.tempStart();
     }
 }
 
 void IQFrontEnd::setBuffering(bool enabled) {
     inBuf.bypass = !enabled;
+    onBufferingChanged.emit(enabled);
 }
 
 void IQFrontEnd::setDecimation(int ratio) {
@@ -118,7 +123,7 @@ void IQFrontEnd::setDecimation(int ratio) {
     preproc.setBlockEnabled(&decim, _decimRatio > 1, [=](dsp::stream<dsp::complex_t>* out){ split.setInput(out); });
 
     // Update the DSP sample rate (TODO: Find a way to get rid of this)
-    core::setInputSampleRate(_sampleRate);
+    if (this == &sigpath::iqFrontEnd) { core::setInputSampleRate(_sampleRate); }
 }
 
 void IQFrontEnd::setDCBlocking(bool enabled) {
@@ -137,49 +142,163 @@ void IQFrontEnd::unbindIQStream(dsp::stream<dsp::complex_t>* stream) {
     split.unbindStream(stream);
 }
 
-dsp::channel::RxVFO* IQFrontEnd::addVFO(std::string name, double sampleRate, double bandwidth, double offset) {
+dsp::stream<dsp::complex_t>* IQFrontEnd::addVFO(std::string name, double sampleRate, double bandwidth, double offset) {
     // Make sure no other VFO with that name already exists
-    if (vfos.find(name) != vfos.end()) {
+    if (vfoOutputs.find(name) != vfoOutputs.end()) {
         flog::error("[IQFrontEnd] Tried to add VFO with existing name.");
         return NULL;
     }
 
-    // Create VFO and its input stream
-    dsp::stream<dsp::complex_t>* vfoIn = new dsp::stream<dsp::complex_t>;
-    dsp::channel::RxVFO* vfo = new dsp::channel::RxVFO(vfoIn, effectiveSr, sampleRate, bandwidth, offset);
+    // Create the output stream and attach it to a channel with the same parameters, or a new one
+    vfoOutputs[name] = new dsp::stream<dsp::complex_t>;
+    VFOChannel* chan = findChannel(sampleRate, bandwidth, offset);
+    attachVFO(name, chan ? chan : createChannel(sampleRate, bandwidth, offset));
 
-    // Register them
-    vfoStreams[name] = vfoIn;
-    vfos[name] = vfo;
-    bindIQStream(vfoIn);
-
-    // Start VFO
-    vfo->start();
-
-    return vfo;
+    return vfoOutputs[name];
 }
 
 void IQFrontEnd::removeVFO(std::string name) {
     // Make sure that a VFO with that name exists
-    if (vfos.find(name) == vfos.end()) {
+    if (vfoOutputs.find(name) == vfoOutputs.end()) {
         flog::error("[IQFrontEnd] Tried to remove a VFO that doesn't exist.");
         return;
     }
 
-    // Remove the VFO and stream from registry
-    dsp::stream<dsp::complex_t>* vfoIn = vfoStreams[name];
-    dsp::channel::RxVFO* vfo = vfos[name];
+    // Detach from its channel and delete the output stream
+    detachVFO(name);
+    delete vfoOutputs[name];
+    vfoOutputs.erase(name);
+}
 
-    // Stop the VFO
-    vfo->stop();
+void IQFrontEnd::setVFOOffset(std::string name, double offset) {
+    if (vfoChannels.find(name) == vfoChannels.end()) { return; }
+    VFOChannel* chan = vfoChannels[name];
+    reconfigureVFO(name, chan->sampleRate, chan->bandwidth, offset);
+}
 
-    unbindIQStream(vfoIn);
-    vfoStreams.erase(name);
-    vfos.erase(name);
+void IQFrontEnd::setVFOBandwidth(std::string name, double bandwidth) {
+    if (vfoChannels.find(name) == vfoChannels.end()) { return; }
+    VFOChannel* chan = vfoChannels[name];
+    reconfigureVFO(name, chan->sampleRate, bandwidth, chan->offset);
+}
 
-    // Delete the VFO and its input stream
-    delete vfo;
-    delete vfoIn;
+void IQFrontEnd::setVFOSampleRate(std::string name, double sampleRate, double bandwidth) {
+    if (vfoChannels.find(name) == vfoChannels.end()) { return; }
+    VFOChannel* chan = vfoChannels[name];
+    reconfigureVFO(name, sampleRate, bandwidth, chan->offset);
+}
+
+void IQFrontEnd::moveVFO(std::string name, IQFrontEnd* dest, double offset) {
+    if (vfoChannels.find(name) == vfoChannels.end()) { return; }
+    VFOChannel* chan = vfoChannels[name];
+    if (dest == this) {
+        reconfigureVFO(name, chan->sampleRate, chan->bandwidth, offset);
+        return;
+    }
+
+    // Detach the output from this front-end and attach it to a channel of the other one
+    double sampleRate = chan->sampleRate;
+    double bandwidth = chan->bandwidth;
+    dsp::stream<dsp::complex_t>* output = vfoOutputs[name];
+    detachVFO(name);
+    vfoOutputs.erase(name);
+    dest->vfoOutputs[name] = output;
+    VFOChannel* match = dest->findChannel(sampleRate, bandwidth, offset);
+    dest->attachVFO(name, match ? match : dest->createChannel(sampleRate, bandwidth, offset));
+}
+
+IQFrontEnd::VFOChannel* IQFrontEnd::findChannel(double sampleRate, double bandwidth, double offset) {
+    for (auto& chan : channels) {
+        if (chan->sampleRate == sampleRate && chan->bandwidth == bandwidth && chan->offset == offset) { return chan; }
+    }
+    return NULL;
+}
+
+IQFrontEnd::VFOChannel* IQFrontEnd::createChannel(double sampleRate, double bandwidth, double offset) {
+    VFOChannel* chan = new VFOChannel;
+    chan->sampleRate = sampleRate;
+    chan->bandwidth = bandwidth;
+    chan->offset = offset;
+
+    // Create the DSP and bind it to the baseband
+    chan->vfo.init(&chan->in, effectiveSr, sampleRate, bandwidth, offset);
+    bindIQStream(&chan->in);
+    chan->vfo.start();
+
+    channels.push_back(chan);
+    return chan;
+}
+
+void IQFrontEnd::attachVFO(std::string name, VFOChannel* chan) {
+    dsp::stream<dsp::complex_t>* output = vfoOutputs[name];
+    if (chan->outputs.empty()) {
+        // A VFO alone on its channel is written to directly
+        chan->vfo.setOutput(output);
+    }
+    else {
+        // The splitter is only needed once a second VFO joins the channel
+        if (!chan->split) {
+            chan->split = new dsp::routing::Splitter<dsp::complex_t>(&chan->vfo.out);
+            chan->split->bindStream(chan->outputs[0]);
+            chan->split->start();
+            chan->vfo.setOutput(NULL);
+        }
+        chan->split->bindStream(output);
+    }
+    chan->outputs.push_back(output);
+    vfoChannels[name] = chan;
+}
+
+void IQFrontEnd::detachVFO(std::string name) {
+    VFOChannel* chan = vfoChannels[name];
+    dsp::stream<dsp::complex_t>* output = vfoOutputs[name];
+    vfoChannels.erase(name);
+    chan->outputs.erase(std::find(chan->outputs.begin(), chan->outputs.end(), output));
+
+    if (chan->split) {
+        chan->split->unbindStream(output);
+        if (chan->outputs.size() > 1) { return; }
+
+        // Only one VFO left, write to it directly again and get rid of the splitter
+        chan->split->stop();
+        chan->vfo.setOutput(chan->outputs[0]);
+        delete chan->split;
+        chan->split = NULL;
+        return;
+    }
+
+    // Nobody uses the channel anymore, destroy it
+    chan->vfo.stop();
+    unbindIQStream(&chan->in);
+    channels.erase(std::find(channels.begin(), channels.end(), chan));
+    delete chan;
+}
+
+void IQFrontEnd::reconfigureVFO(std::string name, double sampleRate, double bandwidth, double offset) {
+    VFOChannel* chan = vfoChannels[name];
+    if (chan->sampleRate == sampleRate && chan->bandwidth == bandwidth && chan->offset == offset) { return; }
+
+    // If the VFO is the only user of its channel and doesn't join another one, reconfigure the channel in place
+    VFOChannel* match = findChannel(sampleRate, bandwidth, offset);
+    if (chan->outputs.size() == 1 && !match) {
+        if (sampleRate != chan->sampleRate) {
+            chan->vfo.setOutSamplerate(sampleRate, bandwidth);
+        }
+        else if (bandwidth != chan->bandwidth) {
+            chan->vfo.setBandwidth(bandwidth);
+        }
+        if (offset != chan->offset) {
+            chan->vfo.setOffset(offset);
+        }
+        chan->sampleRate = sampleRate;
+        chan->bandwidth = bandwidth;
+        chan->offset = offset;
+        return;
+    }
+
+    // Otherwise move it to the matching channel or a new one
+    detachVFO(name);
+    attachVFO(name, match ? match : createChannel(sampleRate, bandwidth, offset));
 }
 
 void IQFrontEnd::setFFTSize(int size) {
@@ -197,6 +316,21 @@ void IQFrontEnd::setFFTWindow(FFTWindow fftWindow) {
     updateFFTPath();
 }
 
+void IQFrontEnd::bindFFTTap(FFTTap* tap) {
+    fftSink.update([&]() {
+        fftTaps.push_back(tap);
+    });
+    setFFTPathEnabled(true);
+}
+
+void IQFrontEnd::unbindFFTTap(FFTTap* tap) {
+    fftSink.update([&]() {
+        auto it = std::find(fftTaps.begin(), fftTaps.end(), tap);
+        if (it != fftTaps.end()) { fftTaps.erase(it); }
+    });
+    if (!_acquireFFTBuffer && fftTaps.empty()) { setFFTPathEnabled(false); }
+}
+
 void IQFrontEnd::flushInputBuffer() {
     inBuf.flush();
 }
@@ -212,11 +346,14 @@ void IQFrontEnd::start() {
     split.start();
 
     // Start all VFOs
-    for (auto& [name, vfo] : vfos) {
-        vfo->start();
+    for (auto& chan : channels) {
+        chan->vfo.start();
+        if (chan->split) { chan->split->start(); }
     }
 
     // Start FFT chain
+    running = true;
+    if (!fftPathEnabled) { return; }
     reshape.start();
     fftSink.start();
 }
@@ -232,13 +369,15 @@ void IQFrontEnd::stop() {
     split.stop();
 
     // Stop all VFOs
-    for (auto& [name, vfo] : vfos) {
-        vfo->stop();
+    for (auto& chan : channels) {
+        chan->vfo.stop();
+        if (chan->split) { chan->split->stop(); }
     }
 
     // Stop FFT chain
     reshape.stop();
     fftSink.stop();
+    running = false;
 }
 
 double IQFrontEnd::getEffectiveSamplerate() {
@@ -255,15 +394,27 @@ void IQFrontEnd::handler(dsp::complex_t* data, int count, void* ctx) {
     fftwf_execute(_this->fftwPlan);
 
     // Aquire buffer
-    float* fftBuf = _this->_acquireFFTBuffer(_this->_fftCtx);
+    float* fftBuf = _this->_acquireFFTBuffer ? _this->_acquireFFTBuffer(_this->_fftCtx) : NULL;
 
     // Convert the complex output of the FFT to dB amplitude
     if (fftBuf) {
         volk_32fc_s32f_power_spectrum_32f(fftBuf, (lv_32fc_t*)_this->fftOutBuf, _this->_fftSize, _this->_fftSize);
     }
 
+    // Send the spectrum to the taps, computing it if the waterfall didn't get it
+    if (!_this->fftTaps.empty()) {
+        const float* power = fftBuf;
+        if (!power) {
+            volk_32fc_s32f_power_spectrum_32f(_this->fftDbOut, (lv_32fc_t*)_this->fftOutBuf, _this->_fftSize, _this->_fftSize);
+            power = _this->fftDbOut;
+        }
+        for (auto& tap : _this->fftTaps) {
+            tap->handler(power, _this->_fftSize, _this->effectiveSr, tap->ctx);
+        }
+    }
+
     // Release buffer
-    _this->_releaseFFTBuffer(_this->_fftCtx);
+    if (_this->_releaseFFTBuffer) { _this->_releaseFFTBuffer(_this->_fftCtx); }
 }
 
 void IQFrontEnd::updateFFTPath(bool updateWaterfall) {
@@ -296,6 +447,8 @@ void IQFrontEnd::updateFFTPath(bool updateWaterfall) {
     fftInBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
     fftOutBuf = (fftwf_complex*)fftwf_malloc(_fftSize * sizeof(fftwf_complex));
     fftwPlan = fftwf_plan_dft_1d(_fftSize, fftInBuf, fftOutBuf, FFTW_FORWARD, FFTW_ESTIMATE);
+    dsp::buffer::free(fftDbOut);
+    fftDbOut = dsp::buffer::alloc<float>(_fftSize);
 
     // Clear the rest of the FFT input buffer
     dsp::buffer::clear(fftInBuf, _fftSize - _nzFFTSize, _nzFFTSize);
@@ -306,4 +459,23 @@ void IQFrontEnd::updateFFTPath(bool updateWaterfall) {
     // Restart branch
     reshape.tempStart();
     fftSink.tempStart();
+}
+
+void IQFrontEnd::setFFTPathEnabled(bool enabled) {
+    if (fftPathEnabled == enabled) { return; }
+    fftPathEnabled = enabled;
+
+    // Feed the FFT branch from the splitter only while something uses it
+    if (enabled) {
+        split.bindStream(&fftIn);
+        if (running) {
+            reshape.start();
+            fftSink.start();
+        }
+    }
+    else {
+        split.unbindStream(&fftIn);
+        reshape.stop();
+        fftSink.stop();
+    }
 }
\ No newline at end of file
@@ -1,13 +1,14 @@
 #pragma once
 #include "../dsp/buffer/frame_buffer.h"
 #include "../dsp/buffer/reshaper.h"
-#include "../dsp/multirate/power_decimator.h"
+#include "../dsp/multirate/decimator.h"
 #include "../dsp/correction/dc_blocker.h"
 #include "../dsp/chain.h"
 #include "../dsp/routing/splitter.h"
 #include "../dsp/channel/rx_vfo.h"
 #include "../dsp/sink/handler_sink.h"
 #include "../dsp/math/conjugate.h"
+#include <utils/event.h>
 #include <fftw3.h>
 
 class IQFrontEnd {
@@ -27,6 +28,7 @@ public:
     inline double getSampleRate() { return _sampleRate / _decimRatio; }
 
     void setBuffering(bool enabled);
+    inline bool isBuffering() { return !inBuf.bypass; }
     void setDecimation(int ratio);
     void setInvertIQ(bool enabled);
     void setDCBlocking(bool enabled);
@@ -34,13 +36,29 @@ public:
     void bindIQStream(dsp::stream<dsp::complex_t>* stream);
     void unbindIQStream(dsp::stream<dsp::complex_t>* stream);
 
-    dsp::channel::RxVFO* addVFO(std::string name, double sampleRate, double bandwidth, double offset);
+    // VFOs with identical parameters transparently share the same channel
+    dsp::stream<dsp::complex_t>* addVFO(std::string name, double sampleRate, double bandwidth, double offset);
     void removeVFO(std::string name);
+    void setVFOOffset(std::string name, double offset);
+    void setVFOBandwidth(std::string name, double bandwidth);
+    void setVFOSampleRate(std::string name, double sampleRate, double bandwidth);
+
+    // Move a VFO to another front-end, its output stream stays the same
+    void moveVFO(std::string name, IQFrontEnd* dest, double offset);
 
     void setFFTSize(int size);
     void setFFTRate(double rate);
     void setFFTWindow(FFTWindow fftWindow);
 
+    // Receives every power spectrum in dB with DC in the middle, from the DSP thread
+    struct FFTTap {
+        void (*handler)(const float* data, int size, double sampleRate, void* ctx);
+        void* ctx;
+    };
+
+    void bindFFTTap(FFTTap* tap);
+    void unbindFFTTap(FFTTap* tap);
+
     void flushInputBuffer();
 
     void start();
@@ -48,9 +66,30 @@ public:
 
     double getEffectiveSamplerate();
 
+    // Emitted with the new state when buffering is toggled. It's disabled by sources that can be slowed down
+    // (eg. file playback), which sinks can use to apply back-pressure instead of dropping samples.
+    Event<bool> onBufferingChanged;
+
 protected:
+    struct VFOChannel {
+        dsp::stream<dsp::complex_t> in;
+        dsp::channel::RxVFO vfo;
+        dsp::routing::Splitter<dsp::complex_t>* split = NULL;
+        std::vector<dsp::stream<dsp::complex_t>*> outputs;
+        double sampleRate;
+        double bandwidth;
+        double offset;
+    };
+
+    VFOChannel* findChannel(double sampleRate, double bandwidth, double offset);
+    VFOChannel* createChannel(double sampleRate, double bandwidth, double offset);
+    void attachVFO(std::string name, VFOChannel* chan);
+    void detachVFO(std::string name);
+    void reconfigureVFO(std::string name, double sampleRate, double bandwidth, double offset);
+
     static void handler(dsp::complex_t* data, int count, void* ctx);
     void updateFFTPath(bool updateWaterfall = false);
+    void setFFTPathEnabled(bool enabled);
 
     static inline double genDCBlockRate(double sampleRate) {
         return 50.0 / sampleRate;
@@ -66,7 +105,7 @@ protected:
     dsp::buffer::SampleFrameBuffer<dsp::complex_t> inBuf;
 
     // Pre-processing chain
-    dsp::multirate::PowerDecimator<dsp::complex_t> decim;
+    dsp::multirate::Decimator<dsp::complex_t> decim;
     dsp::math::Conjugate conjugate;
     dsp::correction::DCBlocker<dsp::complex_t> dcBlock;
     dsp::chain<dsp::complex_t> preproc;
@@ -78,10 +117,13 @@ protected:
     dsp::stream<dsp::complex_t> fftIn;
     dsp::buffer::Reshaper<dsp::complex_t> reshape;
     dsp::sink::Handler<dsp::complex_t> fftSink;
+    std::vector<FFTTap*> fftTaps;
+    bool fftPathEnabled = false;
 
     // VFOs
-    std::map<std::string, dsp::stream<dsp::complex_t>*> vfoStreams;
-    std::map<std::string, dsp::channel::RxVFO*> vfos;
+    std::map<std::string, dsp::stream<dsp::complex_t>*> vfoOutputs;
+    std::map<std::string, VFOChannel*> vfoChannels;
+    std::vector<VFOChannel*> channels;
 
     // Parameters
     double _sampleRate;
@@ -103,5 +145,6 @@ protected:
     double effectiveSr;
 
     bool _init = false;
+    bool running = false;
 
 };
\ No newline at end of file
@@ -199,6 +199,17 @@ float SinkManager::getStreamSampleRate(std::string name) {
     return streams[name]->getSampleRate();
 }
 
+bool SinkManager::streamEnded(std::string name) {
+    if (streams.find(name) == streams.end()) {
+        flog::error("Cannot check the end of stream '{0}', this stream doesn't exist", name);
+        return true;
+    }
+    Stream* stream = streams[name];
+
+    // A stopped stream will never receive the end of stream
+    return !stream->running || stream->sinkOut->isEndOfStream();
+}
+
 dsp::stream<dsp::stereo_t>* SinkManager::bindStream(std::string name) {
     if (streams.find(name) == streams.end()) {
         flog::error("Cannot bind to stream '{0}'. Stream doesn't exist", name);
@@ -225,6 +236,7 @@ void SinkManager::setStreamSink(std::string name, std::string providerName) {
         flog::error("Unknown sink provider '{0}'", providerName);
         return;
     }
+    if (nullSinksOnly) { providerName = "None"; }
 
     if (stream->running) {
         stream->sink->stop();
@@ -239,6 +251,10 @@ void SinkManager::setStreamSink(std::string name, std::string providerName) {
     }
 }
 
+void SinkManager::forceNullSinks(bool enabled) {
+    nullSinksOnly = enabled;
+}
+
 void SinkManager::showVolumeSlider(std::string name, std::string prefix, float width, float btnHeight, int btnBorder, bool sameLine) {
     // TODO: Replace map with some hashmap for it to be faster
     float height = ImGui::GetTextLineHeightWithSpacing() + 2;
@@ -306,7 +322,7 @@ void SinkManager::loadStreamConfig(std::string name) {
     json conf = core::configManager.conf["streams"][name];
     SinkManager::Stream* stream = streams[name];
     std::string provName = conf["sink"];
-    if (providers.find(provName) == providers.end()) {
+    if (providers.find(provName) == providers.end() || nullSinksOnly) {
         provName = providerNames[0];
     }
     if (stream->running) {
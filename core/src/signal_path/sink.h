@@ -98,9 +98,13 @@ public:
     void stopStream(std::string name);
 
     float getStreamSampleRate(std::string name);
+    bool streamEnded(std::string name);
 
     void setStreamSink(std::string name, std::string providerName);
 
+    // Route every stream to the null sink whatever the config says, used when running without audio output
+    void forceNullSinks(bool enabled);
+
     void showVolumeSlider(std::string name, std::string prefix, float width, float btnHeight = -1.0f, int btnBorder = 0, bool sameLine = false);
 
     dsp::stream<dsp::stereo_t>* bindStream(std::string name);
@@ -129,4 +133,5 @@ private:
     std::vector<std::string> providerNames;
     std::string providerNamesTxt;
     std::vector<std::string> streamNames;
+    bool nullSinksOnly = false;
 };
\ No newline at end of file
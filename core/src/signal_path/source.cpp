@@ -3,6 +3,10 @@
 #include <utils/flog.h>
 #include <signal_path/signal_path.h>
 #include <core.h>
+#include <chrono>
+
+thread_local bool SourceManager::enumerating = false;
+thread_local IQFrontEnd* SourceManager::routedFrontEnd = NULL;
 
 SourceManager::SourceManager() {
 }
@@ -22,11 +26,15 @@ void SourceManager::unregisterSource(std::string name) {
         return;
     }
     onSourceUnregister.emit(name);
+    waitEnumeration(name, false);
+    enumerations.erase(name);
+    if (isSecondary(name)) { removeSecondarySource(name); }
     if (name == selectedName) {
         if (selectedHandler != NULL) {
             sources[selectedName]->deselectHandler(sources[selectedName]->ctx);
         }
         sigpath::iqFrontEnd.setInput(&nullSource);
+        std::lock_guard<std::mutex> lck(routingMtx);
         selectedHandler = NULL;
     }
     sources.erase(name);
@@ -39,15 +47,38 @@ std::vector<std::string> SourceManager::getSourceNames() {
     return names;
 }
 
+void SourceManager::prefetchSources() {
+    for (auto const& [name, src] : sources) { startEnumeration(name); }
+}
+
+void SourceManager::refreshSources() {
+    for (auto const& [name, src] : sources) {
+        if (!src->enumerateHandler || name == selectedName || isSecondary(name)) { continue; }
+
+        // Leave the enumerations that are still running alone
+        auto it = enumerations.find(name);
+        if (it != enumerations.end()) {
+            if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) { continue; }
+            enumerations.erase(it);
+        }
+        startEnumeration(name);
+    }
+}
+
 void SourceManager::selectSource(std::string name) {
     if (sources.find(name) == sources.end()) {
         flog::error("Tried to select non existent source: {0}", name);
         return;
     }
+    if (isSecondary(name)) { removeSecondarySource(name); }
     if (selectedHandler != NULL) {
         sources[selectedName]->deselectHandler(sources[selectedName]->ctx);
     }
-    selectedHandler = sources[name];
+    waitEnumeration(name);
+    {
+        std::lock_guard<std::mutex> lck(routingMtx);
+        selectedHandler = sources[name];
+    }
     selectedHandler->selectHandler(selectedHandler->ctx);
     selectedName = name;
     if (core::args["server"].b()) {
@@ -70,7 +101,17 @@ void SourceManager::start() {
     if (selectedHandler == NULL) {
         return;
     }
+    stopRequested = false;
     selectedHandler->startHandler(selectedHandler->ctx);
+    running = true;
+
+    // Start the secondary sources along with the main one
+    for (auto& [name, sec] : secondaries) {
+        routedFrontEnd = sec->frontEnd;
+        sec->handler->startHandler(sec->handler->ctx);
+        sec->handler->tuneHandler(sec->frequency, sec->handler->ctx);
+        routedFrontEnd = NULL;
+    }
 }
 
 void SourceManager::stop() {
@@ -78,6 +119,21 @@ void SourceManager::stop() {
         return;
     }
     selectedHandler->stopHandler(selectedHandler->ctx);
+    running = false;
+
+    for (auto& [name, sec] : secondaries) {
+        routedFrontEnd = sec->frontEnd;
+        sec->handler->stopHandler(sec->handler->ctx);
+        routedFrontEnd = NULL;
+    }
+}
+
+void SourceManager::requestStop() {
+    stopRequested = true;
+}
+
+bool SourceManager::takeStopRequest() {
+    return stopRequested.exchange(false);
 }
 
 void SourceManager::tune(double freq) {
@@ -88,6 +144,9 @@ void SourceManager::tune(double freq) {
     selectedHandler->tuneHandler(abs(((tuneMode == TuningMode::NORMAL) ? freq : ifFreq) + tuneOffset), selectedHandler->ctx);
     onRetune.emit(freq);
     currentFreq = freq;
+
+    // VFOs on secondary sources are placed relative to the main center frequency
+    sigpath::vfoManager.updateSourceOffsets();
 }
 
 void SourceManager::setTuningOffset(double offset) {
@@ -103,4 +162,157 @@ void SourceManager::setTuningMode(TuningMode mode) {
 void SourceManager::setPanadapterIF(double freq) {
     ifFreq = freq;
     tune(currentFreq);
-}
\ No newline at end of file
+}
+
+IQFrontEnd* SourceManager::addSecondarySource(std::string name) {
+    if (sources.find(name) == sources.end()) {
+        flog::error("Tried to add non existent secondary source: {0}", name);
+        return NULL;
+    }
+    if (name == selectedName || isSecondary(name)) {
+        flog::error("Tried to add a source that is already in use as secondary source: {0}", name);
+        return NULL;
+    }
+
+    // Give the source its own front-end, the FFT is only computed for the main one
+    SecondarySource* sec = new SecondarySource;
+    sec->handler = sources[name];
+    sec->frontEnd = new IQFrontEnd;
+    sec->frontEnd->init(sec->handler->stream, 1000000.0, true, 1, false, 1024, 20.0, IQFrontEnd::FFTWindow::NUTTALL, NULL, NULL, NULL);
+    {
+        std::lock_guard<std::mutex> lck(routingMtx);
+        secondaries[name] = sec;
+    }
+
+    // Select it, the samplerate it reports is routed to its own front-end
+    waitEnumeration(name);
+    routedFrontEnd = sec->frontEnd;
+    sec->handler->selectHandler(sec->handler->ctx);
+    routedFrontEnd = NULL;
+    sec->frontEnd->start();
+
+    // If the main source is already running, start it right away
+    if (running) {
+        routedFrontEnd = sec->frontEnd;
+        sec->handler->startHandler(sec->handler->ctx);
+        routedFrontEnd = NULL;
+    }
+
+    onSecondaryAdd.emit(name);
+    return sec->frontEnd;
+}
+
+void SourceManager::removeSecondarySource(std::string name) {
+    if (!isSecondary(name)) {
+        flog::error("Tried to remove non existent secondary source: {0}", name);
+        return;
+    }
+    onSecondaryRemove.emit(name);
+    SecondarySource* sec = secondaries[name];
+
+    // Move the VFOs that use it back to the main source
+    sigpath::vfoManager.releaseSource(name);
+
+    {
+        // Samplerates reported by the source's threads from now on are ignored
+        std::lock_guard<std::mutex> lck(routingMtx);
+        secondaries.erase(name);
+    }
+
+    // Stop and deselect the source, then destroy its front-end
+    routedFrontEnd = sec->frontEnd;
+    if (running) { sec->handler->stopHandler(sec->handler->ctx); }
+    sec->handler->deselectHandler(sec->handler->ctx);
+    routedFrontEnd = NULL;
+    sec->frontEnd->stop();
+    delete sec->frontEnd;
+    delete sec;
+}
+
+void SourceManager::showSecondaryMenu(std::string name) {
+    if (!isSecondary(name)) { return; }
+    SecondarySource* sec = secondaries[name];
+    routedFrontEnd = sec->frontEnd;
+    sec->handler->menuHandler(sec->handler->ctx);
+    routedFrontEnd = NULL;
+}
+
+void SourceManager::tuneSecondary(std::string name, double freq) {
+    if (!isSecondary(name)) { return; }
+    SecondarySource* sec = secondaries[name];
+    routedFrontEnd = sec->frontEnd;
+    sec->handler->tuneHandler(freq, sec->handler->ctx);
+    routedFrontEnd = NULL;
+    sec->frequency = freq;
+    sigpath::vfoManager.updateSourceOffsets();
+    onSecondaryRetune.emit(name);
+}
+
+double SourceManager::getSecondaryFrequency(std::string name) {
+    if (!isSecondary(name)) { return 0.0; }
+    return secondaries[name]->frequency;
+}
+
+std::vector<std::string> SourceManager::getSecondaryNames() {
+    std::vector<std::string> names;
+    for (auto const& [name, sec] : secondaries) { names.push_back(name); }
+    return names;
+}
+
+bool SourceManager::isSecondary(std::string name) {
+    return secondaries.find(name) != secondaries.end();
+}
+
+IQFrontEnd* SourceManager::getFrontEnd(std::string name) {
+    if (!isSecondary(name)) { return &sigpath::iqFrontEnd; }
+    return secondaries[name]->frontEnd;
+}
+
+double SourceManager::getFrequencyOffset(std::string name) {
+    if (!isSecondary(name)) { return 0.0; }
+    return currentFreq - secondaries[name]->frequency;
+}
+
+void SourceManager::setSampleRate(SourceHandler* handler, double samplerate) {
+    {
+        std::lock_guard<std::mutex> lck(routingMtx);
+        for (auto const& [name, sec] : secondaries) {
+            if (sec->handler != handler) { continue; }
+            sec->frontEnd->setSampleRate(samplerate);
+            flog::info("New secondary source samplerate: {0}", samplerate);
+            return;
+        }
+
+        // A source that is neither selected nor secondary must not change the samplerate
+        if (handler != selectedHandler) { return; }
+    }
+    core::setInputSampleRate(samplerate);
+}
+
+bool SourceManager::routeSampleRate(double samplerate) {
+    // Sources aren't selected while enumerating, they must not change the samplerate
+    if (enumerating) { return true; }
+    if (!routedFrontEnd) { return false; }
+    routedFrontEnd->setSampleRate(samplerate);
+    flog::info("New secondary source samplerate: {0}", samplerate);
+    sigpath::vfoManager.updateSourceOffsets();
+    return true;
+}
+
+void SourceManager::startEnumeration(std::string name) {
+    SourceHandler* handler = sources[name];
+    if (!handler->enumerateHandler || enumerations.find(name) != enumerations.end()) { return; }
+    enumerations[name] = std::async(std::launch::async, [=]() {
+        enumerating = true;
+        auto start = std::chrono::steady_clock::now();
+        handler->enumerateHandler(handler->ctx);
+        auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        flog::info("Enumerated {0} in {1}ms", name, (int64_t)time.count());
+    }).share();
+}
+
+void SourceManager::waitEnumeration(std::string name, bool start) {
+    if (start) { startEnumeration(name); }
+    auto it = enumerations.find(name);
+    if (it != enumerations.end()) { it->second.wait(); }
+}
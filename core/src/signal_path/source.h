@@ -2,10 +2,15 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <future>
+#include <mutex>
+#include <atomic>
 #include <dsp/stream.h>
 #include <dsp/types.h>
 #include <utils/event.h>
 
+class IQFrontEnd;
+
 class SourceManager {
 public:
     SourceManager();
@@ -19,6 +24,10 @@ public:
         void (*stopHandler)(void* ctx);
         void (*tuneHandler)(double freq, void* ctx);
         void* ctx;
+
+        // Optional, lists the devices. Run in the background the first time the source is needed
+        // instead of when the module is created, so that startup doesn't wait on hardware probing.
+        void (*enumerateHandler)(void* ctx) = NULL;
     };
 
     enum TuningMode {
@@ -37,20 +46,72 @@ public:
     void setTuningMode(TuningMode mode);
     void setPanadapterIF(double freq);
 
+    // Can be called from any thread by the selected source when it stopped on its own (eg. device lost),
+    // the UI then stops playback as if the user did it
+    void requestStop();
+    bool takeStopRequest();
+
     std::vector<std::string> getSourceNames();
 
+    // Start enumerating the devices of every source that didn't already do it
+    void prefetchSources();
+
+    // Enumerate the devices of the sources not in use again, so that devices plugged in since show up
+    void refreshSources();
+
+    // Secondary sources run alongside the selected one, each through its own front-end
+    IQFrontEnd* addSecondarySource(std::string name);
+    void removeSecondarySource(std::string name);
+    void showSecondaryMenu(std::string name);
+    void tuneSecondary(std::string name, double freq);
+    double getSecondaryFrequency(std::string name);
+    std::vector<std::string> getSecondaryNames();
+    bool isSecondary(std::string name);
+
+    // Front-end of a source, the main one if the name is empty or not a secondary source
+    IQFrontEnd* getFrontEnd(std::string name);
+
+    // Difference between the main center frequency and the center frequency of a source
+    double getFrequencyOffset(std::string name);
+
+    // Apply the samplerate reported by a source, to its own front-end if it's a secondary source.
+    // Sources reporting it from their own threads must use this instead of core::setInputSampleRate()
+    void setSampleRate(SourceHandler* handler, double samplerate);
+
+    // Apply a samplerate reported by a secondary source from one of its handlers running on this thread
+    bool routeSampleRate(double samplerate);
+
     Event<std::string> onSourceRegistered;
     Event<std::string> onSourceUnregister;
     Event<std::string> onSourceUnregistered;
     Event<double> onRetune;
+    Event<std::string> onSecondaryAdd;
+    Event<std::string> onSecondaryRetune;
+    Event<std::string> onSecondaryRemove;
 
 private:
+    struct SecondarySource {
+        SourceHandler* handler;
+        IQFrontEnd* frontEnd;
+        double frequency = 0.0;
+    };
+
+    void startEnumeration(std::string name);
+    void waitEnumeration(std::string name, bool start = true);
+
     std::map<std::string, SourceHandler*> sources;
     std::string selectedName;
     SourceHandler* selectedHandler = NULL;
     double tuneOffset;
-    double currentFreq;
+    double currentFreq = 0.0;
     double ifFreq = 0.0;
     TuningMode tuneMode = TuningMode::NORMAL;
     dsp::stream<dsp::complex_t> nullSource;
+    std::map<std::string, SecondarySource*> secondaries;
+    std::mutex routingMtx;
+    static thread_local IQFrontEnd* routedFrontEnd;
+    std::map<std::string, std::shared_future<void>> enumerations;
+    static thread_local bool enumerating;
+    bool running = false;
+    std::atomic<bool> stopRequested = false;
 };
\ No newline at end of file
@@ -1,11 +1,13 @@
 #include <signal_path/vfo_manager.h>
 #include <signal_path/signal_path.h>
 #include <gui/gui.h>
+#include <utils/flog.h>
+#include <algorithm>
 
 VFOManager::VFO::VFO(std::string name, int reference, double offset, double bandwidth, double sampleRate, double minBandwidth, double maxBandwidth, bool bandwidthLocked) {
     this->name = name;
     _bandwidth = bandwidth;
-    dspVFO = sigpath::iqFrontEnd.addVFO(name, sampleRate, bandwidth, offset);
+    output = sigpath::iqFrontEnd.addVFO(name, sampleRate, bandwidth, offset);
     wtfVFO = new ImGui::WaterfallVFO;
     wtfVFO->setReference(reference);
     wtfVFO->setBandwidth(bandwidth);
@@ -13,23 +15,21 @@ VFOManager::VFO::VFO(std::string name, int reference, double offset, double band
     wtfVFO->minBandwidth = minBandwidth;
     wtfVFO->maxBandwidth = maxBandwidth;
     wtfVFO->bandwidthLocked = bandwidthLocked;
-    output = &dspVFO->out;
     gui::waterfall.vfos[name] = wtfVFO;
 }
 
 VFOManager::VFO::~VFO() {
-    dspVFO->stop();
     gui::waterfall.vfos.erase(name);
     if (gui::waterfall.selectedVFO == name) {
         gui::waterfall.selectFirstVFO();
     }
-    sigpath::iqFrontEnd.removeVFO(name);
+    frontEnd()->removeVFO(name);
     delete wtfVFO;
 }
 
 void VFOManager::VFO::setOffset(double offset) {
     wtfVFO->setOffset(offset);
-    dspVFO->setOffset(wtfVFO->centerOffset);
+    frontEnd()->setVFOOffset(name, frontEndOffset(wtfVFO->centerOffset));
 }
 
 double VFOManager::VFO::getOffset() {
@@ -38,18 +38,18 @@ double VFOManager::VFO::getOffset() {
 
 void VFOManager::VFO::setCenterOffset(double offset) {
     wtfVFO->setCenterOffset(offset);
-    dspVFO->setOffset(offset);
+    frontEnd()->setVFOOffset(name, frontEndOffset(offset));
 }
 
 void VFOManager::VFO::setBandwidth(double bandwidth, bool updateWaterfall) {
     if (_bandwidth == bandwidth) { return; }
     _bandwidth = bandwidth;
     if (updateWaterfall) { wtfVFO->setBandwidth(bandwidth); }
-    dspVFO->setBandwidth(bandwidth);
+    frontEnd()->setVFOBandwidth(name, bandwidth);
 }
 
 void VFOManager::VFO::setSampleRate(double sampleRate, double bandwidth) {
-    dspVFO->setOutSamplerate(sampleRate, bandwidth);
+    frontEnd()->setVFOSampleRate(name, sampleRate, bandwidth);
     wtfVFO->setBandwidth(bandwidth);
 }
 
@@ -89,6 +89,38 @@ std::string VFOManager::VFO::getName() {
     return name;
 }
 
+bool VFOManager::VFO::setSource(std::string source) {
+    if (!source.empty() && !sigpath::sourceManager.isSecondary(source)) {
+        flog::error("Tried to bind VFO '{0}' to a source that isn't a secondary source: {1}", name, source);
+        return false;
+    }
+
+    // Move the channel, the offset is translated to keep the VFO on the same frequency
+    IQFrontEnd* from = frontEnd();
+    this->source = source;
+    from->moveVFO(name, frontEnd(), frontEndOffset(wtfVFO->centerOffset));
+    return true;
+}
+
+std::string VFOManager::VFO::getSource() {
+    return source;
+}
+
+IQFrontEnd* VFOManager::VFO::frontEnd() {
+    return sigpath::sourceManager.getFrontEnd(source);
+}
+
+double VFOManager::VFO::frontEndOffset(double centerOffset) {
+    double offset = centerOffset + sigpath::sourceManager.getFrequencyOffset(source);
+
+    // A VFO on a secondary source can't go past the edges of that source's band
+    if (!source.empty()) {
+        double halfBw = frontEnd()->getEffectiveSamplerate() / 2.0;
+        offset = std::clamp<double>(offset, -halfBw, halfBw);
+    }
+    return offset;
+}
+
 VFOManager::VFOManager() {
 }
 
@@ -196,6 +228,20 @@ void VFOManager::setColor(std::string name, ImU32 color) {
     return vfos[name]->setColor(color);
 }
 
+bool VFOManager::setSource(std::string name, std::string source) {
+    if (vfos.find(name) == vfos.end()) {
+        return false;
+    }
+    return vfos[name]->setSource(source);
+}
+
+std::string VFOManager::getSource(std::string name) {
+    if (vfos.find(name) == vfos.end()) {
+        return "";
+    }
+    return vfos[name]->getSource();
+}
+
 bool VFOManager::vfoExists(std::string name) {
     return (vfos.find(name) != vfos.end());
 }
@@ -204,7 +250,21 @@ void VFOManager::updateFromWaterfall(ImGui::WaterFall* wtf) {
     for (auto const& [name, vfo] : vfos) {
         if (vfo->wtfVFO->centerOffsetChanged) {
             vfo->wtfVFO->centerOffsetChanged = false;
-            vfo->dspVFO->setOffset(vfo->wtfVFO->centerOffset);
+            vfo->frontEnd()->setVFOOffset(name, vfo->frontEndOffset(vfo->wtfVFO->centerOffset));
         }
     }
+}
+
+void VFOManager::updateSourceOffsets() {
+    // Only VFOs on secondary sources depend on the center frequencies
+    for (auto const& [name, vfo] : vfos) {
+        if (vfo->source.empty()) { continue; }
+        vfo->frontEnd()->setVFOOffset(name, vfo->frontEndOffset(vfo->wtfVFO->centerOffset));
+    }
+}
+
+void VFOManager::releaseSource(std::string source) {
+    for (auto const& [name, vfo] : vfos) {
+        if (vfo->source == source) { vfo->setSource(""); }
+    }
 }
\ No newline at end of file
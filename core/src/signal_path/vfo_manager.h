@@ -3,6 +3,8 @@
 #include <gui/widgets/waterfall.h>
 #include <utils/event.h>
 
+class IQFrontEnd;
+
 class VFOManager {
 public:
     VFOManager();
@@ -25,16 +27,21 @@ public:
         int getReference();
         void setColor(ImU32 color);
         std::string getName();
+        bool setSource(std::string source);
+        std::string getSource();
 
         dsp::stream<dsp::complex_t>* output;
 
         friend class VFOManager;
 
-        dsp::channel::RxVFO* dspVFO;
         ImGui::WaterfallVFO* wtfVFO;
 
     private:
+        IQFrontEnd* frontEnd();
+        double frontEndOffset(double centerOffset);
+
         std::string name;
+        std::string source;
         double _bandwidth;
 
     };
@@ -52,11 +59,15 @@ public:
     bool getBandwidthChanged(std::string name, bool erase = true);
     double getBandwidth(std::string name);
     void setColor(std::string name, ImU32 color);
+    bool setSource(std::string name, std::string source);
+    std::string getSource(std::string name);
     std::string getName();
     int getReference(std::string name);
     bool vfoExists(std::string name);
 
     void updateFromWaterfall(ImGui::WaterFall* wtf);
+    void updateSourceOffsets();
+    void releaseSource(std::string source);
 
     Event<VFOManager::VFO*> onVfoCreated;
     Event<VFOManager::VFO*> onVfoDelete;
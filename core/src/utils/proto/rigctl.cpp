@@ -2,6 +2,11 @@
 #include <math.h>
 
 namespace net::rigctl {
+    const char* modeStrings[] = {
+        "USB", "LSB", "CW", "CWR", "RTTY", "RTTYR", "AM", "FM", "WFM", "AMS",
+        "PKTLSB", "PKTUSB", "PKTFM", "ECSSUSB", "ECSSLSB", "FA", "SAM", "SAL", "SAH", "DSB"
+    };
+
     Client::Client(std::shared_ptr<Socket> sock) {
         this->sock = sock;
     }
@@ -26,7 +31,12 @@ namespace net::rigctl {
         return setFloat("F", freq);
     }
 
-    // TODO: get/setMode
+    // TODO: getMode
+
+    int Client::setMode(Mode mode) {
+        if (sendMode(mode) <= 0) { return -1; }
+        return recvStatus();
+    }
 
     // TODO: get/setVFO
 
@@ -132,10 +142,23 @@ namespace net::rigctl {
         return setInt("E", mem);
     }
 
-    int recvLine(std::shared_ptr<net::Socket> sock, std::vector<std::string>& args) {
+    int Client::sendFreq(double freq) {
+        char buf[128];
+        sprintf(buf, "F %lf\n", freq);
+        return sock->sendstr(buf);
+    }
+
+    int Client::sendMode(Mode mode, int passband) {
+        if (mode == MODE_INVALID) { return -1; }
+        char buf[128];
+        sprintf(buf, "M %s %d\n", modeStrings[mode], passband);
+        return sock->sendstr(buf);
+    }
+
+    int recvLine(std::shared_ptr<net::Socket> sock, std::vector<std::string>& args, int timeout = 1000) {
         // Read line
         std::string line = "";
-        int err = sock->recvline(line, 0, 1000);
+        int err = sock->recvline(line, 0, timeout);
         if (err <= 0) { return err; }
 
         // Split
@@ -166,6 +189,26 @@ namespace net::rigctl {
         return std::stoi(args[1]);
     }
 
+    bool Client::recvReply(int& status, int timeout) {
+        // Read line
+        std::vector<std::string> args;
+        int err = recvLine(sock, args, timeout);
+        if (err <= 0) { return false; }
+
+        // A line was received, it answers a command even if it can't be decoded
+        status = -1;
+        if (err != 2 || args[0] != "RPRT") { return true; }
+
+        // Decode status
+        try {
+            status = std::stoi(args[1]);
+        }
+        catch (const std::exception& e) {
+            status = -1;
+        }
+        return true;
+    }
+
     int Client::getInt(std::string cmd) {
         // Send command
         sock->sendstr(cmd + "\n");
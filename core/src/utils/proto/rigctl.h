@@ -30,6 +30,12 @@ namespace net::rigctl {
         MODE_DSB
     };
 
+    // Special passband values of the mode command
+    enum Passband {
+        PASSBAND_NOCHANGE   = -1,
+        PASSBAND_NORMAL     = 0
+    };
+
     enum VFO {
         VFO_INVALID = -1,
         VFO_VFOA,
@@ -263,6 +269,13 @@ namespace net::rigctl {
         int setTranceiveMode(TranceiveMode mode);
 
         int reset(ResetType type);
+
+        // Pipelined commands, these only send the command. The replies must be collected
+        // in the same order using recvReply() which allows multiple commands in flight.
+        // recvReply() returns false if nothing was received, status is -1 for a malformed reply.
+        int sendFreq(double freq);
+        int sendMode(Mode mode, int passband = PASSBAND_NOCHANGE);
+        bool recvReply(int& status, int timeout = 1000);
         
     private:
         int recvStatus();
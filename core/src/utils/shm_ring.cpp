@@ -0,0 +1,295 @@
+#include "shm_ring.h"
+#include <stdexcept>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <string.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <limits.h>
+#endif
+
+// Size of the header area, the data starts page aligned
+#define RING_HEADER_AREA    4096
+
+namespace shm {
+    int sampleSize(SampleFormat format) {
+        switch (format) {
+        case SAMPLE_FORMAT_INT8:
+            return sizeof(int8_t) * 2;
+        case SAMPLE_FORMAT_INT16:
+            return sizeof(int16_t) * 2;
+        case SAMPLE_FORMAT_INT32:
+            return sizeof(int32_t) * 2;
+        case SAMPLE_FORMAT_FLOAT32:
+            return sizeof(float) * 2;
+        default:
+            return 0;
+        }
+    }
+
+    static void* mapRing(const std::string& name, size_t& size, bool create, void*& handle) {
+#ifdef _WIN32
+        std::string path = "Local\\" + name;
+        HANDLE mapping;
+        if (create) {
+            mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, path.c_str());
+            if (mapping && GetLastError() == ERROR_ALREADY_EXISTS) {
+                CloseHandle(mapping);
+                throw std::runtime_error("A shared memory ring with this name already exists");
+            }
+        }
+        else {
+            mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, path.c_str());
+        }
+        if (!mapping) {
+            throw std::runtime_error("Could not open shared memory");
+        }
+        void* mem = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        if (!mem) {
+            CloseHandle(mapping);
+            throw std::runtime_error("Could not map shared memory");
+        }
+        handle = mapping;
+        return mem;
+#elif defined(__ANDROID__)
+        throw std::runtime_error("Shared memory is not supported on this platform");
+#else
+        std::string path = "/" + name;
+        int fd;
+        if (create) {
+            // Never take over the ring of another producer
+            fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd < 0 && errno == EEXIST) {
+                throw std::runtime_error("A shared memory ring with this name already exists");
+            }
+            if (fd >= 0 && ftruncate(fd, size) < 0) {
+                close(fd);
+                shm_unlink(path.c_str());
+                fd = -1;
+            }
+        }
+        else {
+            fd = shm_open(path.c_str(), O_RDWR, 0);
+            struct stat st;
+            if (fd >= 0 && fstat(fd, &st) == 0) { size = st.st_size; }
+        }
+        if (fd < 0) {
+            throw std::runtime_error("Could not open shared memory");
+        }
+        void* mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (mem == MAP_FAILED) {
+            if (create) { shm_unlink(path.c_str()); }
+            throw std::runtime_error("Could not map shared memory");
+        }
+        return mem;
+#endif
+    }
+
+    static void unmapRing(void* mem, size_t size, void* handle) {
+#ifdef _WIN32
+        UnmapViewOfFile(mem);
+        CloseHandle((HANDLE)handle);
+#else
+        munmap(mem, size);
+#endif
+    }
+
+    static void wakeReaders(std::atomic<uint32_t>* seq) {
+#ifdef __linux__
+        syscall(SYS_futex, (uint32_t*)seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#endif
+    }
+
+    static void waitSeq(std::atomic<uint32_t>* seq, std::atomic<uint32_t>* waiters, uint32_t old, int timeoutMs) {
+#ifdef __linux__
+        // The futex only sleeps if seq still is the old value, so a write between the two can't be missed
+        struct timespec ts;
+        ts.tv_sec = timeoutMs / 1000;
+        ts.tv_nsec = (timeoutMs % 1000) * 1000000;
+        waiters->fetch_add(1);
+        syscall(SYS_futex, (uint32_t*)seq, FUTEX_WAIT, old, &ts, NULL, 0);
+        waiters->fetch_sub(1);
+#else
+        // No cross-process wait primitive that works on shared memory everywhere, poll instead
+        auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+        while (seq->load(std::memory_order_acquire) == old && std::chrono::steady_clock::now() < end) {
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+#endif
+    }
+
+    RingWriter::RingWriter(const std::string& name, size_t capacity, SampleFormat format) {
+        this->name = name;
+        this->format = format;
+        int ss = sampleSize(format);
+        if (!ss || capacity < ss) {
+            throw std::runtime_error("Invalid ring parameters");
+        }
+        capacity -= capacity % ss;
+
+        mapSize = RING_HEADER_AREA + capacity;
+        void* handle = NULL;
+        uint8_t* mem = (uint8_t*)mapRing(name, mapSize, true, handle);
+#ifdef _WIN32
+        mapping = (HANDLE)handle;
+#endif
+
+        // Initialize the header, the magic is written last so that readers never see a half initialized ring
+        hdr = (RingHeader*)mem;
+        data = &mem[RING_HEADER_AREA];
+        hdr->version = RING_VERSION;
+        hdr->headerSize = RING_HEADER_AREA;
+        hdr->format = format;
+        hdr->capacity = capacity;
+        hdr->writePos = 0;
+        hdr->writeEnd = 0;
+        hdr->seq = 0;
+        hdr->writerAlive = 1;
+        hdr->waiters = 0;
+        hdr->samplerate = 0.0;
+        hdr->frequency = 0.0;
+        std::atomic_thread_fence(std::memory_order_release);
+        hdr->magic = RING_MAGIC;
+    }
+
+    RingWriter::~RingWriter() {
+        hdr->writerAlive = 0;
+        hdr->seq.fetch_add(1, std::memory_order_release);
+        wakeReaders(&hdr->seq);
+#ifdef _WIN32
+        unmapRing(hdr, mapSize, mapping);
+#else
+        unmapRing(hdr, mapSize, NULL);
+        shm_unlink(("/" + name).c_str());
+#endif
+    }
+
+    uint8_t* RingWriter::reserve(size_t size, size_t& avail) {
+        uint64_t writePos = hdr->writePos.load(std::memory_order_relaxed);
+        uint64_t pos = writePos % hdr->capacity;
+        avail = std::min<size_t>(size, hdr->capacity - pos);
+
+        // Announce the space before writing to it, readers check it to detect data overwritten while in use
+        hdr->writeEnd.store(writePos + avail, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return &data[pos];
+    }
+
+    void RingWriter::commit(size_t size) {
+        hdr->writePos.fetch_add(size, std::memory_order_release);
+        hdr->seq.fetch_add(1);
+
+        // Only go through the kernel if a reader is asleep
+        if (hdr->waiters.load()) { wakeReaders(&hdr->seq); }
+    }
+
+    void RingWriter::setSamplerate(double samplerate) {
+        hdr->samplerate = samplerate;
+    }
+
+    void RingWriter::setFrequency(double frequency) {
+        hdr->frequency = frequency;
+    }
+
+    RingReader::RingReader(const std::string& name) {
+        mapSize = 0;
+        void* handle = NULL;
+#ifdef _WIN32
+        // The size of a mapping can't be queried before mapping it, map the header first
+        mapSize = RING_HEADER_AREA;
+        RingHeader* tmp = (RingHeader*)mapRing(name, mapSize, false, handle);
+        uint64_t capacity = tmp->capacity;
+        bool valid = (tmp->magic == RING_MAGIC);
+        unmapRing(tmp, mapSize, handle);
+        if (!valid) { throw std::runtime_error("Not an IQ ring"); }
+        mapSize = RING_HEADER_AREA + capacity;
+#endif
+        uint8_t* mem = (uint8_t*)mapRing(name, mapSize, false, handle);
+#ifdef _WIN32
+        mapping = (HANDLE)handle;
+#endif
+
+        // Check that this is a compatible ring
+        hdr = (RingHeader*)mem;
+        if (mapSize < RING_HEADER_AREA || hdr->magic != RING_MAGIC || hdr->version != RING_VERSION || hdr->headerSize + hdr->capacity > mapSize || !sampleSize((SampleFormat)hdr->format)) {
+            unmapRing(mem, mapSize, handle);
+            throw std::runtime_error("Not a compatible IQ ring");
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        data = &mem[hdr->headerSize];
+
+        // Start with the most recent data
+        readPos = hdr->writePos.load(std::memory_order_acquire);
+    }
+
+    RingReader::~RingReader() {
+#ifdef _WIN32
+        unmapRing(hdr, mapSize, mapping);
+#else
+        unmapRing(hdr, mapSize, NULL);
+#endif
+    }
+
+    bool RingReader::wait(int timeoutMs) {
+        uint32_t seq = hdr->seq.load(std::memory_order_acquire);
+        if (hdr->writePos.load(std::memory_order_acquire) != readPos) { return true; }
+        if (!hdr->writerAlive) { return false; }
+        waitSeq(&hdr->seq, &hdr->waiters, seq, timeoutMs);
+        return hdr->writePos.load(std::memory_order_acquire) != readPos;
+    }
+
+    const uint8_t* RingReader::peek(size_t& size) {
+        uint64_t writePos = hdr->writePos.load(std::memory_order_acquire);
+
+        // If overrun, skip ahead keeping half of the ring to give some margin to the reader
+        if (writePos - readPos > hdr->capacity) {
+            overruns++;
+            int ss = sampleSize((SampleFormat)hdr->format);
+            readPos = writePos - (hdr->capacity / 2) / ss * ss;
+        }
+
+        uint64_t pos = readPos % hdr->capacity;
+        size = std::min<uint64_t>(writePos - readPos, hdr->capacity - pos);
+        return &data[pos];
+    }
+
+    bool RingReader::consume(size_t size) {
+        // If the writer reserved space past the start of the consumed data, it may have been overwritten while in use.
+        // This includes a write that is still in progress, the reserved end is published before the data is written.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t writeEnd = hdr->writeEnd.load(std::memory_order_relaxed);
+        bool valid = (writeEnd - readPos <= hdr->capacity);
+        if (!valid) { overruns++; }
+        readPos += size;
+        return valid;
+    }
+
+    bool RingReader::writerAlive() {
+        return hdr->writerAlive;
+    }
+
+    SampleFormat RingReader::getFormat() {
+        return (SampleFormat)hdr->format;
+    }
+
+    double RingReader::getSamplerate() {
+        return hdr->samplerate;
+    }
+
+    double RingReader::getFrequency() {
+        return hdr->frequency;
+    }
+}
@@ -0,0 +1,160 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <atomic>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+namespace shm {
+    enum SampleFormat : uint32_t {
+        SAMPLE_FORMAT_INT8,
+        SAMPLE_FORMAT_INT16,
+        SAMPLE_FORMAT_INT32,
+        SAMPLE_FORMAT_FLOAT32
+    };
+
+    /**
+     * Get the size of an IQ sample in a given format.
+     * @param format Sample format.
+     * @return Size of an IQ pair in bytes.
+     */
+    int sampleSize(SampleFormat format);
+
+    // 'SDRI' in little endian
+    const uint32_t RING_MAGIC = 0x49524453;
+    const uint32_t RING_VERSION = 3;
+
+    /**
+     * Header at the start of the shared memory. The data follows at offset headerSize.
+     * External producers and consumers must follow this layout.
+     */
+    struct RingHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t headerSize;
+        uint32_t format;
+        uint64_t capacity;                  // Size of the data area in bytes, multiple of the sample size
+        std::atomic<uint64_t> writePos;     // Total number of bytes ever written
+        std::atomic<uint64_t> writeEnd;     // End of the space reserved by the writer, set before writing to it
+        std::atomic<uint32_t> seq;          // Incremented on every write, readers can futex wait on it
+        std::atomic<uint32_t> writerAlive;  // Cleared when the writer closes the ring
+        std::atomic<uint32_t> waiters;      // Readers waiting on seq must increment it, the writer only wakes them if non-zero
+        std::atomic<double> samplerate;
+        std::atomic<double> frequency;
+    };
+
+    /**
+     * Single writer side of a shared memory IQ ring. The writer never waits for readers, readers that fall
+     * behind by more than the capacity are overrun and must skip ahead.
+     */
+    class RingWriter {
+    public:
+        /**
+         * Create a ring, only accessible by the current user. Throws a runtime_error on failure,
+         * including when a ring with the same name already exists.
+         * @param name Name of the shared memory object, without any leading slash.
+         * @param capacity Size of the data area in bytes, rounded down to a multiple of the sample size.
+         * @param format Format of the samples.
+         */
+        RingWriter(const std::string& name, size_t capacity, SampleFormat format);
+        ~RingWriter();
+
+        /**
+         * Get contiguous space to write to. Less than requested is returned when the end of the ring is reached.
+         * @param size Number of bytes wanted.
+         * @param avail Number of bytes that can be written to the returned pointer.
+         * @return Pointer inside the shared memory.
+         */
+        uint8_t* reserve(size_t size, size_t& avail);
+
+        /**
+         * Publish data written to the reserved space and wake up the readers.
+         * @param size Number of bytes written.
+         */
+        void commit(size_t size);
+
+        /**
+         * Set the samplerate advertised in the header.
+         * @param samplerate Samplerate in Hz.
+         */
+        void setSamplerate(double samplerate);
+
+        /**
+         * Set the frequency advertised in the header.
+         * @param frequency Center frequency in Hz.
+         */
+        void setFrequency(double frequency);
+
+        SampleFormat getFormat() { return format; }
+
+    private:
+        std::string name;
+        SampleFormat format;
+        size_t mapSize;
+        RingHeader* hdr;
+        uint8_t* data;
+#ifdef _WIN32
+        HANDLE mapping;
+#endif
+    };
+
+    /**
+     * Reader side of a shared memory IQ ring. Any number of readers can attach to the same ring.
+     */
+    class RingReader {
+    public:
+        /**
+         * Attach to an existing ring. Throws a runtime_error on failure.
+         * @param name Name of the shared memory object, without any leading slash.
+         */
+        RingReader(const std::string& name);
+        ~RingReader();
+
+        /**
+         * Wait for new data.
+         * @param timeoutMs Maximum time to wait in milliseconds.
+         * @return True if data is available.
+         */
+        bool wait(int timeoutMs);
+
+        /**
+         * Get the next contiguous block of data, it stays valid until the writer wraps around.
+         * If the reader was overrun, it first skips to the most recent data.
+         * @param size Number of bytes available at the returned pointer.
+         * @return Pointer inside the shared memory.
+         */
+        const uint8_t* peek(size_t& size);
+
+        /**
+         * Release data previously returned by peek.
+         * @param size Number of bytes consumed.
+         * @return False if the writer overwrote the data while it was being used.
+         */
+        bool consume(size_t size);
+
+        /**
+         * Check if the writer is still attached to the ring.
+         */
+        bool writerAlive();
+
+        SampleFormat getFormat();
+        double getSamplerate();
+        double getFrequency();
+
+        /**
+         * Number of times the reader was overrun by the writer since attached.
+         */
+        uint64_t overruns = 0;
+
+    private:
+        size_t mapSize;
+        RingHeader* hdr;
+        uint8_t* data;
+        uint64_t readPos;
+#ifdef _WIN32
+        HANDLE mapping;
+#endif
+    };
+}
@@ -4,6 +4,8 @@
 #include <dsp/sink/null_sink.h>
 #include <dsp/demod/gfsk.h>
 #include <dsp/routing/doubler.h>
+#include <dsp/digital/packed_binary_slicer.h>
+#include <dsp/digital/sync_correlator.h>
 #include <volk/volk.h>
 #include <codec2.h>
 #include <golay24.h>
@@ -19,6 +21,10 @@ extern "C" {
 #define M17_4FSK_HIGH_CUT ((1.0f + (1.0f/3.0f)) / 2.0f)
 
 #define M17_SYNC_SIZE            16
+
+// LSF and PKT sync only differ in 2 bits, words equally close to both are rejected by the correlator
+#define M17_SYNC_MAX_ERRORS      1
+
 #define M17_LICH_SIZE            96
 #define M17_PAYLOAD_SIZE         144
 #define M17_ENCODED_PAYLOAD_SIZE 296
@@ -120,23 +126,28 @@ namespace dsp {
             int count = _in->read();
             if (count < 0) { return -1; }
 
+            // Pack the two bits of each symbol, four symbols per byte
             float val;
+            int outCount = 0;
             for (int i = 0; i < count; i++) {
                 val = _in->readBuf[i];
-                out.writeBuf[i * 2] = (val < 0.0f);
-                out.writeBuf[(i * 2) + 1] = (fabsf(val) > M17_4FSK_HIGH_CUT);
+                packer.push(2, ((val < 0.0f) << 1) | (fabsf(val) > M17_4FSK_HIGH_CUT), out.writeBuf, outCount);
             }
 
             _in->flush();
 
-            if (!out.swap(count * 2)) { return -1; }
+            if (outCount) {
+                if (!out.swap(outCount)) { return -1; }
+            }
             return count;
         }
 
+        // Packed bits, MSB first
         stream<uint8_t> out;
 
     private:
         stream<float>* _in;
+        digital::BitPackerState packer;
     };
 
     class M17FrameDemux : public block {
@@ -145,16 +156,14 @@ namespace dsp {
 
         M17FrameDemux(stream<uint8_t>* in) { init(in); }
 
-        ~M17FrameDemux() {
-            if (!block::_block_init) { return; }
-            block::stop();
-            delete[] delay;
-        }
-
         void init(stream<uint8_t>* in) {
             _in = in;
 
-            delay = new uint8_t[STREAM_BUFFER_SIZE];
+            // The IDs of the sync words match the frame types
+            corr.init(M17_SYNC_SIZE, M17_SYNC_MAX_ERRORS);
+            corr.addSyncWord(M17_LSF_SYNC);
+            corr.addSyncWord(M17_STF_SYNC);
+            corr.addSyncWord(M17_PKF_SYNC);
 
             block::registerInput(_in);
             block::registerOutput(&linkSetupOut);
@@ -178,82 +187,13 @@ namespace dsp {
             int count = _in->read();
             if (count < 0) { return -1; }
 
-            memcpy(&delay[M17_SYNC_SIZE], _in->readBuf, count);
-
-            for (int i = 0; i < count;) {
-                if (detect) {
-                    if (outCount < M17_SYNC_SIZE) {
-                        outCount++;
-                        i++;
-                    }
-                    else {
-                        int id = M17_INTERLEAVER[outCount - M17_SYNC_SIZE];
-
-                        if (type == 0) {
-                            linkSetupOut.writeBuf[id] = delay[i++] ^ M17_SCRAMBLER[outCount - M17_SYNC_SIZE];
-                        }
-                        else if ((type == 1 || type == 2) && id < M17_LICH_SIZE) {
-                            lichOut.writeBuf[id] = delay[i++] ^ M17_SCRAMBLER[outCount - M17_SYNC_SIZE];
-                        }
-                        else if (type == 1) {
-                            streamOut.writeBuf[id - M17_LICH_SIZE] = (delay[i++] ^ M17_SCRAMBLER[outCount - M17_SYNC_SIZE]);
-                        }
-                        else if (type == 2) {
-                            packetOut.writeBuf[id - M17_LICH_SIZE] = (delay[i++] ^ M17_SCRAMBLER[outCount - M17_SYNC_SIZE]);
-                        }
-
-                        outCount++;
-                    }
-
-                    if (outCount >= M17_RAW_FRAME_SIZE) {
-                        detect = false;
-                        if (type == 0) {
-                            if (!linkSetupOut.swap(M17_CUT_FRAME_SIZE)) { return -1; }
-                        }
-                        else if (type == 1) {
-                            if (!lichOut.swap(M17_LICH_SIZE)) { return -1; }
-                            if (!streamOut.swap(M17_CUT_FRAME_SIZE)) { return -1; }
-                        }
-                        else if (type == 2) {
-                            if (!lichOut.swap(M17_LICH_SIZE)) { return -1; }
-                            if (!packetOut.swap(M17_CUT_FRAME_SIZE)) { return -1; }
-                        }
-                    }
-                    continue;
-                }
-
-                // Check for link setup syncword
-                if (!memcmp(&delay[i], M17_LSF_SYNC, M17_SYNC_SIZE)) {
-                    detect = true;
-                    outCount = 0;
-                    type = 0;
-                    //flog::warn("Found sync frame");
-                    continue;
-                }
-
-                // Check for stream syncword
-                if (!memcmp(&delay[i], M17_STF_SYNC, M17_SYNC_SIZE)) {
-                    detect = true;
-                    outCount = 0;
-                    type = 1;
-                    //flog::warn("Found stream frame");
-                    continue;
-                }
-
-                // Check for packet syncword
-                if (!memcmp(&delay[i], M17_PKF_SYNC, M17_SYNC_SIZE)) {
-                    detect = true;
-                    outCount = 0;
-                    type = 2;
-                    //flog::warn("Found packet frame");
-                    continue;
+            for (int i = 0; i < count; i++) {
+                uint8_t byte = _in->readBuf[i];
+                for (int j = 7; j >= 0; j--) {
+                    if (!processBit((byte >> j) & 1)) { return -1; }
                 }
-
-                i++;
             }
 
-            memmove(delay, &delay[count], 16);
-
             _in->flush();
 
             return count;
@@ -265,9 +205,55 @@ namespace dsp {
         stream<uint8_t> packetOut;
 
     private:
+        inline bool processBit(uint8_t bit) {
+            // The correlator is always fed so that a new search can start right at the end of a frame
+            int syncId = corr.push(bit);
+
+            if (!detect) {
+                if (syncId >= 0) {
+                    detect = true;
+                    outCount = M17_SYNC_SIZE;
+                    type = syncId;
+                }
+                return true;
+            }
+
+            int id = M17_INTERLEAVER[outCount - M17_SYNC_SIZE];
+            uint8_t val = bit ^ M17_SCRAMBLER[outCount - M17_SYNC_SIZE];
+
+            if (type == 0) {
+                linkSetupOut.writeBuf[id] = val;
+            }
+            else if ((type == 1 || type == 2) && id < M17_LICH_SIZE) {
+                lichOut.writeBuf[id] = val;
+            }
+            else if (type == 1) {
+                streamOut.writeBuf[id - M17_LICH_SIZE] = val;
+            }
+            else if (type == 2) {
+                packetOut.writeBuf[id - M17_LICH_SIZE] = val;
+            }
+
+            if (++outCount < M17_RAW_FRAME_SIZE) { return true; }
+
+            detect = false;
+            if (type == 0) {
+                if (!linkSetupOut.swap(M17_CUT_FRAME_SIZE)) { return false; }
+            }
+            else if (type == 1) {
+                if (!lichOut.swap(M17_LICH_SIZE)) { return false; }
+                if (!streamOut.swap(M17_CUT_FRAME_SIZE)) { return false; }
+            }
+            else if (type == 2) {
+                if (!lichOut.swap(M17_LICH_SIZE)) { return false; }
+                if (!packetOut.swap(M17_CUT_FRAME_SIZE)) { return false; }
+            }
+            return true;
+        }
+
         stream<uint8_t>* _in;
 
-        uint8_t* delay;
+        digital::SyncCorrelator corr;
 
         bool detect = false;
         int type;
@@ -8,7 +8,7 @@
 #include <dsp/taps/root_raised_cosine.h>
 #include <dsp/correction/dc_blocker.h>
 #include <dsp/loop/fast_agc.h>
-#include <dsp/digital/binary_slicer.h>
+#include <dsp/digital/packed_binary_slicer.h>
 #include <dsp/routing/doubler.h>
 
 class POCSAGDSP : public dsp::Processor<dsp::complex_t, uint8_t> {
@@ -27,20 +27,22 @@ public:
         shape = dsp::taps::fromArray<float>(10, taps);
         fir.init(NULL, shape);
         recov.init(NULL, samplerate/baudrate, 1e-4, 1.0, 0.05);
+        slicer.init(NULL);
 
         // Free useless buffers
         fir.out.free();
         recov.out.free();
+        slicer.out.free();
 
         // Init base
         base_type::init(in);
     }
 
-    int process(int count, dsp::complex_t* in, float* softOut, uint8_t* out) {
+    int process(int count, dsp::complex_t* in, float* softOut, uint8_t* out, int& outCount) {
         count = demod.process(count, in, demod.out.readBuf);
         count = fir.process(count, demod.out.readBuf, demod.out.readBuf);
         count = recov.process(count, demod.out.readBuf, softOut);
-        dsp::digital::BinarySlicer::process(count, softOut, out);
+        outCount = slicer.process(count, softOut, out);
         return count;
     }
 
@@ -56,10 +58,11 @@ public:
         int count = base_type::_in->read();
         if (count < 0) { return -1; }
 
-        count = process(count, base_type::_in->readBuf, soft.writeBuf, base_type::out.writeBuf);
+        int outCount;
+        count = process(count, base_type::_in->readBuf, soft.writeBuf, base_type::out.writeBuf, outCount);
 
         base_type::_in->flush();
-        if (!base_type::out.swap(count)) { return -1; }
+        if (outCount) { if (!base_type::out.swap(outCount)) { return -1; } }
         if (count) { if (!soft.swap(count)) { return -1; } }
         return count;
     }
@@ -71,6 +74,7 @@ private:
     dsp::tap<float> shape;
     dsp::filter::FIR<float, float> fir;
     dsp::clock_recovery::MM<float> recov;
+    dsp::digital::PackedBinarySlicer slicer;
 
     double _samplerate;
 };
\ No newline at end of file
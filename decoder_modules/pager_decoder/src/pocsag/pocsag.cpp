@@ -32,50 +32,43 @@ namespace pocsag {
     Decoder::Decoder() {
         // Zero out batch
         memset(batch, 0, sizeof(batch));
+
+        // Init sync correlator
+        syncCorr.init(32, POCSAG_SYNC_DIST);
+        syncCorr.addSyncWord(POCSAG_FRAME_SYNC_CODEWORD);
     }
 
-    void Decoder::process(uint8_t* symbols, int count) {
+    void Decoder::process(const uint8_t* bits, int count) {
         for (int i = 0; i < count; i++) {
-            // Get symbol
-            uint32_t s = symbols[i];
-
-            // If not sync, try to acquire sync (TODO: sync confidence)
-            if (!synced) {
-                // Append new symbol to sync shift register
-                syncSR = (syncSR << 1) | s;
-
-                // Test for sync
-                synced = (distance(syncSR, POCSAG_FRAME_SYNC_CODEWORD) <= POCSAG_SYNC_DIST);
-
-                // Go to next symbol
-                continue;
-            }
+            uint8_t byte = bits[i];
+            for (int j = 7; j >= 0; j--) {
+                // Get symbol
+                uint32_t s = (byte >> j) & 1;
+
+                // If not sync, try to acquire sync (TODO: sync confidence)
+                if (!synced) {
+                    synced = (syncCorr.push(s) >= 0);
+                    continue;
+                }
 
-            // TODO: Flush message on desync
+                // TODO: Flush message on desync
 
-            // Append bit to batch
-            batch[batchOffset >> 5] |= (s << (31 - (batchOffset & 0b11111)));
-            batchOffset++;
+                // Append bit to batch
+                batch[batchOffset >> 5] |= (s << (31 - (batchOffset & 0b11111)));
+                batchOffset++;
 
-            // On end of batch, decode and reset
-            if (batchOffset >= POCSAG_BATCH_BIT_COUNT) {
-                decodeBatch();
-                batchOffset = 0;
-                synced = false;
-                memset(batch, 0, sizeof(batch));
+                // On end of batch, decode and reset
+                if (batchOffset >= POCSAG_BATCH_BIT_COUNT) {
+                    decodeBatch();
+                    batchOffset = 0;
+                    synced = false;
+                    syncCorr.reset();
+                    memset(batch, 0, sizeof(batch));
+                }
             }
         }
     }
 
-    int Decoder::distance(uint32_t a, uint32_t b) {
-        uint32_t diff = a ^ b;
-        int dist = 0;
-        for (int i = 0; i < 32; i++) {
-            dist += (diff >> i ) & 1;
-        }
-        return dist;
-    }
-
     bool Decoder::correctCodeword(Codeword in, Codeword& out) {
 
 
@@ -2,6 +2,7 @@
 #include <string>
 #include <stdint.h>
 #include <utils/new_event.h>
+#include <dsp/digital/sync_correlator.h>
 
 #define POCSAG_SYNC_DIST            4
 #define POCSAG_BATCH_CODEWORD_COUNT 16
@@ -25,17 +26,17 @@ namespace pocsag {
     public:
         Decoder();
 
-        void process(uint8_t* symbols, int count);
+        // Bits are packed 8 per byte, MSB first
+        void process(const uint8_t* bits, int count);
 
         NewEvent<Address, MessageType, const std::string&> onMessage;
 
     private:
-        static int distance(uint32_t a, uint32_t b);
         bool correctCodeword(Codeword in, Codeword& out);
         void flushMessage();
         void decodeBatch();
 
-        uint32_t syncSR = 0;
+        dsp::digital::SyncCorrelator syncCorr;
         bool synced = false;
         int batchOffset = 0;
 
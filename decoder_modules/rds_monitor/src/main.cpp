@@ -0,0 +1,354 @@
+#include <imgui.h>
+#include <config.h>
+#include <core.h>
+#include <gui/style.h>
+#include <gui/gui.h>
+#include <signal_path/signal_path.h>
+#include <module.h>
+#include <utils/optionlist.h>
+#include <dsp/sink/handler_sink.h>
+#include <dsp/channel/fft_channelizer.h>
+#include <memory>
+#include <atomic>
+#include "rds_station.h"
+
+SDRPP_MOD_INFO{
+    /* Name:            */ "rds_monitor",
+    /* Description:     */ "Band-wide FM RDS monitor",
+    /* Author:          */ "Ryzerth",
+    /* Version:         */ 0, 1, 0,
+    /* Max instances    */ -1
+};
+
+#define FM_BAND_START           87500000.0
+#define FM_BAND_END             108000000.0
+#define CHANNEL_SAMPLERATE      250000.0
+#define CHANNEL_PASSBAND        100000.0
+#define LEVEL_HYSTERESIS        3.0f
+#define LEVEL_UPDATE_INTERVAL   64
+
+ConfigManager config;
+
+class RDSMonitorModule : public ModuleManager::Instance {
+public:
+    RDSMonitorModule(std::string name) {
+        this->name = name;
+
+        // Define channel spacings
+        spacings.define(50000, "50 KHz", 50000);
+        spacings.define(100000, "100 KHz", 100000);
+        spacings.define(200000, "200 KHz", 200000);
+
+        // Load config
+        bool autoStart = false;
+        config.acquire();
+        if (config.conf[name].contains("spacing")) {
+            int sp = config.conf[name]["spacing"];
+            if (spacings.keyExists(sp)) { spacing = sp; }
+        }
+        if (config.conf[name].contains("threshold")) {
+            threshold = config.conf[name]["threshold"];
+        }
+        if (config.conf[name].contains("running")) {
+            autoStart = config.conf[name]["running"];
+        }
+        config.release();
+        spacingId = spacings.valueId(spacing);
+
+        // Init DSP
+        handler.init(&iqStream, dataHandler, this);
+
+        // Follow the tuning even when the menu isn't drawn
+        retuneHandler.handler = onRetune;
+        retuneHandler.ctx = this;
+        sigpath::sourceManager.onRetune.bindHandler(&retuneHandler);
+
+        // Start if needed
+        if (autoStart) { start(); }
+
+        gui::menu.registerEntry(name, menuHandler, this, this);
+    }
+
+    ~RDSMonitorModule() {
+        gui::menu.removeEntry(name);
+        sigpath::sourceManager.onRetune.unbindHandler(&retuneHandler);
+        stop();
+    }
+
+    void postInit() {}
+
+    void enable() {
+        if (wasRunning) { start(); }
+        enabled = true;
+    }
+
+    void disable() {
+        wasRunning = running;
+        stop();
+        enabled = false;
+    }
+
+    bool isEnabled() {
+        return enabled;
+    }
+
+    void start() {
+        if (running) { return; }
+
+        // Force the channels to be regenerated by the DSP thread
+        samplerate = 0.0;
+        targetFreq = gui::waterfall.getCenterFrequency();
+        {
+            std::lock_guard<std::mutex> lck(snapshotMtx);
+            snapshot.clear();
+        }
+
+        sigpath::iqFrontEnd.bindIQStream(&iqStream);
+        handler.start();
+        running = true;
+    }
+
+    void stop() {
+        if (!running) { return; }
+        handler.stop();
+        sigpath::iqFrontEnd.unbindIQStream(&iqStream);
+        running = false;
+    }
+
+private:
+    static void menuHandler(void* ctx) {
+        RDSMonitorModule* _this = (RDSMonitorModule*)ctx;
+        float menuWidth = ImGui::GetContentRegionAvail().x;
+
+        if (!_this->enabled) { style::beginDisabled(); }
+
+        if (_this->running) { style::beginDisabled(); }
+        ImGui::LeftLabel("Spacing");
+        ImGui::FillWidth();
+        if (ImGui::Combo(("##rds_monitor_spacing_" + _this->name).c_str(), &_this->spacingId, _this->spacings.txt)) {
+            int spacing = _this->spacings.value(_this->spacingId);
+            _this->spacing = spacing;
+            config.acquire();
+            config.conf[_this->name]["spacing"] = spacing;
+            config.release(true);
+        }
+        if (_this->running) { style::endDisabled(); }
+
+        ImGui::LeftLabel("Threshold");
+        ImGui::FillWidth();
+        float threshold = _this->threshold;
+        if (ImGui::SliderFloat(("##rds_monitor_thresh_" + _this->name).c_str(), &threshold, -120.0f, 0.0f, "%.1f dB")) {
+            _this->threshold = threshold;
+            config.acquire();
+            config.conf[_this->name]["threshold"] = threshold;
+            config.release(true);
+        }
+
+        if (_this->running) {
+            if (ImGui::Button(("Stop##rds_monitor_stop_" + _this->name).c_str(), ImVec2(menuWidth, 0))) {
+                _this->stop();
+                config.acquire();
+                config.conf[_this->name]["running"] = false;
+                config.release(true);
+            }
+        }
+        else {
+            if (ImGui::Button(("Start##rds_monitor_start_" + _this->name).c_str(), ImVec2(menuWidth, 0))) {
+                _this->start();
+                config.acquire();
+                config.conf[_this->name]["running"] = true;
+                config.release(true);
+            }
+        }
+
+        // Station list
+        if (ImGui::BeginTable(("##rds_monitor_tbl_" + _this->name).c_str(), 5, ImGuiTableFlags_SizingFixedFit | ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+            ImGui::TableSetupColumn("Freq");
+            ImGui::TableSetupColumn("Level");
+            ImGui::TableSetupColumn("PI");
+            ImGui::TableSetupColumn("PS");
+            ImGui::TableSetupColumn("Radio Text");
+            ImGui::TableHeadersRow();
+
+            std::lock_guard<std::mutex> lck(_this->snapshotMtx);
+            for (auto& st : _this->snapshot) {
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                ImGui::Text("%.2lf", st.frequency / 1e6);
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%.1f", st.level);
+                ImGui::TableSetColumnIndex(2);
+                if (st.piValid) {
+                    ImGui::Text("%04X", st.pi);
+                }
+                else {
+                    ImGui::TextUnformatted("----");
+                }
+                ImGui::TableSetColumnIndex(3);
+                ImGui::TextUnformatted(st.ps.c_str());
+                ImGui::TableSetColumnIndex(4);
+                ImGui::TextUnformatted(st.radioText.c_str());
+            }
+
+            ImGui::EndTable();
+        }
+
+        if (!_this->enabled) { style::endDisabled(); }
+    }
+
+    static void onRetune(double freq, void* ctx) {
+        RDSMonitorModule* _this = (RDSMonitorModule*)ctx;
+        _this->targetFreq = freq;
+    }
+
+    // Only called from the DSP thread
+    void reconfigure(double sr, double center) {
+        samplerate = sr;
+        centerFreq = center;
+
+        // Reset the channelizer and stations
+        channelizer.init(samplerate, CHANNEL_SAMPLERATE, CHANNEL_PASSBAND);
+        stations.clear();
+        channelFreqs.clear();
+
+        // Add a channel for every raster frequency of the FM band visible in the baseband
+        double margin = CHANNEL_SAMPLERATE / 2.0;
+        double start = std::max<double>(FM_BAND_START, centerFreq - (samplerate / 2.0) + margin);
+        double end = std::min<double>(FM_BAND_END, centerFreq + (samplerate / 2.0) - margin);
+        double spacing = this->spacing;
+        for (double freq = ceil(start / spacing) * spacing; freq <= end; freq += spacing) {
+            channelFreqs.push_back(freq);
+            channelizer.addChannel(freq - centerFreq, false);
+            stations.push_back(NULL);
+        }
+        blockCounter = 0;
+
+        // The previous stations are gone
+        std::lock_guard<std::mutex> lck(snapshotMtx);
+        snapshot.clear();
+    }
+
+    void updateStations() {
+        // Enable the carriers above the threshold, stations are only allocated when first detected
+        float threshold = this->threshold;
+        int count = channelizer.getChannelCount();
+        for (int i = 0; i < count; i++) {
+            float level = channelizer.getChannelPower(i);
+            auto& st = stations[i];
+            bool active = st && st->active;
+            if (!active && level >= threshold) {
+                if (!st) {
+                    st = std::make_unique<RDSStation>(channelFreqs[i], channelizer.getChannelSamplerate(), channelizer.getResidualOffset(i));
+                }
+                st->active = true;
+                channelizer.setChannelEnabled(i, true);
+            }
+            else if (active && level < threshold - LEVEL_HYSTERESIS) {
+                st->active = false;
+                channelizer.setChannelEnabled(i, false);
+            }
+            if (st) { st->level = level; }
+        }
+
+        // Publish the stations for the GUI
+        std::vector<StationInfo> list;
+        for (auto& st : stations) {
+            if (!st) { continue; }
+            StationInfo info;
+            info.frequency = st->frequency;
+            info.level = st->level;
+            info.piValid = st->decoder.piCodeValid();
+            info.pi = st->decoder.getPICode();
+            if (st->decoder.PSNameValid()) { info.ps = st->decoder.getPSName(); }
+            if (st->decoder.radioTextValid()) { info.radioText = st->decoder.getRadioText(); }
+            list.push_back(std::move(info));
+        }
+        std::lock_guard<std::mutex> lck(snapshotMtx);
+        snapshot = std::move(list);
+    }
+
+    static void channelHandler(int channel, dsp::complex_t* data, int count, void* ctx) {
+        RDSMonitorModule* _this = (RDSMonitorModule*)ctx;
+        _this->stations[channel]->push(data, count);
+    }
+
+    static void dataHandler(dsp::complex_t* data, int count, void* ctx) {
+        RDSMonitorModule* _this = (RDSMonitorModule*)ctx;
+
+        // Regenerate the channels when the tuning or samplerate changed
+        double sr = sigpath::iqFrontEnd.getEffectiveSamplerate();
+        double center = _this->targetFreq;
+        if (sr <= 0.0) { return; }
+        if (sr != _this->samplerate || center != _this->centerFreq) {
+            _this->reconfigure(sr, center);
+        }
+        if (_this->stations.empty()) { return; }
+
+        _this->channelizer.process(count, data, channelHandler, _this);
+
+        // Periodically update which carriers are present
+        if (++_this->blockCounter >= LEVEL_UPDATE_INTERVAL) {
+            _this->blockCounter = 0;
+            _this->updateStations();
+        }
+    }
+
+    struct StationInfo {
+        double frequency;
+        float level;
+        bool piValid;
+        uint16_t pi;
+        std::string ps;
+        std::string radioText;
+    };
+
+    std::string name;
+    bool enabled = true;
+    bool running = false;
+    bool wasRunning = false;
+
+    OptionList<int, int> spacings;
+    std::atomic<int> spacing = 100000;
+    int spacingId = 0;
+    std::atomic<float> threshold = -60.0f;
+
+    double samplerate = 0.0;
+    double centerFreq = 0.0;
+    std::atomic<double> targetFreq = 0.0;
+
+    dsp::stream<dsp::complex_t> iqStream;
+    dsp::sink::Handler<dsp::complex_t> handler;
+    dsp::channel::FFTChannelizer channelizer;
+
+    EventHandler<double> retuneHandler;
+
+    // Owned by the DSP thread
+    std::vector<double> channelFreqs;
+    std::vector<std::unique_ptr<RDSStation>> stations;
+    int blockCounter = 0;
+
+    // Copy of the station list for the GUI
+    std::mutex snapshotMtx;
+    std::vector<StationInfo> snapshot;
+};
+
+MOD_EXPORT void _INIT_() {
+    json def = json({});
+    std::string root = (std::string)core::args["root"];
+    config.setPath(root + "/rds_monitor_config.json");
+    config.load(def);
+    config.enableAutoSave();
+}
+
+MOD_EXPORT ModuleManager::Instance* _CREATE_INSTANCE_(std::string name) {
+    return new RDSMonitorModule(name);
+}
+
+MOD_EXPORT void _DELETE_INSTANCE_(void* instance) {
+    delete (RDSMonitorModule*)instance;
+}
+
+MOD_EXPORT void _END_() {
+    config.disableAutoSave();
+    config.save();
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <dsp/channel/frequency_xlator.h>
+#include <dsp/demod/quadrature.h>
+#include <dsp/multirate/rational_resampler.h>
+#include <rds_demod.h>
+#include <rds.h>
+
+#define RDS_STATION_CHUNK_SIZE  4096
+#define RDS_STATION_DEVIATION   75000.0
+#define RDS_STATION_RDS_SR      5000.0
+
+// RDS-only receive path for a single FM carrier. Unlike the WFM demodulator this skips
+// the stereo PLL, audio filtering and resampling, only the 57KHz subcarrier is processed.
+class RDSStation {
+public:
+    RDSStation(double frequency, double samplerate, double residualOffset) {
+        this->frequency = frequency;
+
+        // Init DSP, only the process functions are used
+        xlator.init(NULL, -residualOffset, samplerate);
+        demod.init(NULL, RDS_STATION_DEVIATION, samplerate);
+        rdsXlator.init(NULL, -57000.0, samplerate);
+        rdsResamp.init(NULL, samplerate, RDS_STATION_RDS_SR);
+        rdsDemod.init(NULL, false);
+
+        // Free useless buffers
+        xlator.out.free();
+        demod.out.free();
+        rdsXlator.out.free();
+        rdsResamp.out.free();
+        rdsDemod.out.free();
+        rdsDemod.soft.free();
+
+        // Allocate work buffers
+        iq = dsp::buffer::alloc<dsp::complex_t>(RDS_STATION_CHUNK_SIZE);
+        mpx = dsp::buffer::alloc<float>(RDS_STATION_CHUNK_SIZE);
+        sub = dsp::buffer::alloc<dsp::complex_t>(RDS_STATION_CHUNK_SIZE);
+        rdsIn = dsp::buffer::alloc<dsp::complex_t>(RDS_STATION_CHUNK_SIZE);
+        soft = dsp::buffer::alloc<float>(RDS_STATION_CHUNK_SIZE);
+        bits = dsp::buffer::alloc<uint8_t>(RDS_STATION_CHUNK_SIZE);
+    }
+
+    ~RDSStation() {
+        dsp::buffer::free(iq);
+        dsp::buffer::free(mpx);
+        dsp::buffer::free(sub);
+        dsp::buffer::free(rdsIn);
+        dsp::buffer::free(soft);
+        dsp::buffer::free(bits);
+    }
+
+    void push(const dsp::complex_t* data, int count) {
+        while (count) {
+            int toCopy = std::min<int>(count, RDS_STATION_CHUNK_SIZE - fill);
+            memcpy(&iq[fill], data, toCopy * sizeof(dsp::complex_t));
+            fill += toCopy;
+            data += toCopy;
+            count -= toCopy;
+            if (fill < RDS_STATION_CHUNK_SIZE) { break; }
+            process(fill);
+            fill = 0;
+        }
+    }
+
+    double frequency;
+    float level = -100.0f;
+    bool active = false;
+    rds::Decoder decoder;
+
+private:
+    void process(int count) {
+        // Compensate the channelizer bin offset and demodulate
+        xlator.process(count, iq, iq);
+        demod.process(count, iq, mpx);
+
+        // Bring the RDS subcarrier to baseband
+        for (int i = 0; i < count; i++) {
+            sub[i].re = mpx[i];
+            sub[i].im = 0.0f;
+        }
+        rdsXlator.process(count, sub, sub);
+        count = rdsResamp.process(count, sub, rdsIn);
+
+        // Demodulate and decode
+        count = rdsDemod.process(count, rdsIn, soft, bits);
+        decoder.process(bits, count);
+    }
+
+    dsp::channel::FrequencyXlator xlator;
+    dsp::demod::Quadrature demod;
+    dsp::channel::FrequencyXlator rdsXlator;
+    dsp::multirate::RationalResampler<dsp::complex_t> rdsResamp;
+    RDSDemod rdsDemod;
+
+    dsp::complex_t* iq;
+    float* mpx;
+    dsp::complex_t* sub;
+    dsp::complex_t* rdsIn;
+    float* soft;
+    uint8_t* bits;
+    int fill = 0;
+};
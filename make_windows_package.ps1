@@ -81,6 +81,8 @@ cp $build_dir/decoder_modules/meteor_demodulator/Release/meteor_demodulator.dll
 
 cp $build_dir/decoder_modules/radio/Release/radio.dll sdrpp_windows_x64/modules/
 
+cp $build_dir/decoder_modules/rds_monitor/Release/rds_monitor.dll sdrpp_windows_x64/modules/
+
 
 # Copy misc modules
 cp $build_dir/misc_modules/discord_integration/Release/discord_integration.dll sdrpp_windows_x64/modules/
@@ -89,6 +91,8 @@ cp $build_dir/misc_modules/frequency_manager/Release/frequency_manager.dll sdrpp
 
 cp $build_dir/misc_modules/iq_exporter/Release/iq_exporter.dll sdrpp_windows_x64/modules/
 
+cp $build_dir/misc_modules/panorama/Release/panorama.dll sdrpp_windows_x64/modules/
+
 cp $build_dir/misc_modules/recorder/Release/recorder.dll sdrpp_windows_x64/modules/
 
 cp $build_dir/misc_modules/rigctl_client/Release/rigctl_client.dll sdrpp_windows_x64/modules/
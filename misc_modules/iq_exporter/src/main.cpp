@@ -1,4 +1,5 @@
 #include <utils/net.h>
+#include <utils/shm_ring.h>
 #include <imgui.h>
 #include <module.h>
 #include <gui/gui.h>
@@ -12,9 +13,12 @@
 #include <gui/dialogs/dialog_box.h>
 #include <core.h>
 
+// Size of the shared memory ring in bytes
+#define SHM_RING_SIZE   (32 * 1024 * 1024)
+
 SDRPP_MOD_INFO{
     /* Name:            */ "iq_exporter",
-    /* Description:     */ "Export raw IQ through TCP or UDP",
+    /* Description:     */ "Export raw IQ through TCP, UDP or shared memory",
     /* Author:          */ "Ryzerth",
     /* Version:         */ 0, 1, 0,
     /* Max instances    */ -1
@@ -31,7 +35,8 @@ enum Mode {
 enum Protocol {
     PROTOCOL_TCP_SERVER,
     PROTOCOL_TCP_CLIENT,
-    PROTOCOL_UDP
+    PROTOCOL_UDP,
+    PROTOCOL_SHM
 };
 
 enum SampleType {
@@ -68,6 +73,7 @@ public:
         protocols.define("TCP (Server)", PROTOCOL_TCP_SERVER);
         protocols.define("TCP (Client)", PROTOCOL_TCP_CLIENT);
         protocols.define("UDP", PROTOCOL_UDP);
+        protocols.define("Shared Memory", PROTOCOL_SHM);
 
         // Define sample types
         sampleTypes.define("Int8", SAMPLE_TYPE_INT8);
@@ -141,11 +147,17 @@ public:
 
         // Register menu entry
         gui::menu.registerEntry(name, menuHandler, this, this);
+
+        // The ring header is kept up to date from the GUI thread, which owns the tuning state
+        fftRedrawHandler.ctx = this;
+        fftRedrawHandler.handler = fftRedraw;
+        gui::waterfall.onFFTRedraw.bindHandler(&fftRedrawHandler);
     }
 
     ~IQExporterModule() {
         // Un-register menu entry
         gui::menu.removeEntry(name);
+        gui::waterfall.onFFTRedraw.unbindHandler(&fftRedrawHandler);
 
         // Stop networking
         stop();
@@ -207,6 +219,11 @@ public:
                 // Connect to TCP server
                 sock = net::connect(hostname, port);
             }
+            else if (proto == PROTOCOL_SHM) {
+                // Create the ring, the hostname field is used as its name
+                ring = std::make_shared<shm::RingWriter>(hostname, SHM_RING_SIZE, ringFormat());
+                updateRingInfo();
+            }
             else {
                 // Open UDP socket
                 sock = net::openudp(hostname, port, "0.0.0.0", 0, true);
@@ -255,6 +272,9 @@ public:
             }
         }
 
+        // Close the shared memory ring
+        ring.reset();
+
         running = false;
     }
 
@@ -344,19 +364,25 @@ private:
             config.release(true);
         }
 
-        // Hostname and port field
+        // Hostname and port field, or ring name for shared memory
+        if (_this->proto == PROTOCOL_SHM) {
+            ImGui::LeftLabel("Name");
+            ImGui::FillWidth();
+        }
         if (ImGui::InputText(("##iq_exporter_host_" + _this->name).c_str(), _this->hostname, sizeof(_this->hostname))) {
             config.acquire();
             config.conf[_this->name]["host"] = _this->hostname;
             config.release(true);
         }
-        ImGui::SameLine();
-        ImGui::FillWidth();
-        if (ImGui::InputInt(("##iq_exporter_port_" + _this->name).c_str(), &_this->port, 0, 0)) {
-            _this->port = std::clamp<int>(_this->port, 1, 65535);
-            config.acquire();
-            config.conf[_this->name]["port"] = _this->port;
-            config.release(true);
+        if (_this->proto != PROTOCOL_SHM) {
+            ImGui::SameLine();
+            ImGui::FillWidth();
+            if (ImGui::InputInt(("##iq_exporter_port_" + _this->name).c_str(), &_this->port, 0, 0)) {
+                _this->port = std::clamp<int>(_this->port, 1, 65535);
+                config.acquire();
+                config.conf[_this->name]["port"] = _this->port;
+                config.release(true);
+            }
         }
 
         if (_this->running) { ImGui::EndDisabled(); }
@@ -389,7 +415,10 @@ private:
         // Status text
         ImGui::TextUnformatted("Status:");
         ImGui::SameLine();
-        if (sockOpen) {
+        if (_this->ring) {
+            ImGui::TextColored(ImVec4(0.0, 1.0, 0.0, 1.0), "Sharing");
+        }
+        else if (sockOpen) {
             ImGui::TextColored(ImVec4(0.0, 1.0, 0.0, 1.0), (_this->proto == PROTOCOL_TCP_SERVER || _this->proto == PROTOCOL_TCP_CLIENT) ? "Connected" : "Sending");
         }
         else if (_this->listener && _this->listener->listening()) {
@@ -484,12 +513,80 @@ private:
         }
     }
 
+    shm::SampleFormat ringFormat() {
+        switch (sampType) {
+        case SAMPLE_TYPE_INT8:
+            return shm::SAMPLE_FORMAT_INT8;
+        case SAMPLE_TYPE_INT16:
+            return shm::SAMPLE_FORMAT_INT16;
+        case SAMPLE_TYPE_INT32:
+            return shm::SAMPLE_FORMAT_INT32;
+        default:
+            return shm::SAMPLE_FORMAT_FLOAT32;
+        }
+    }
+
+    void updateRingInfo() {
+        // Publish the samplerate and frequency of the exported samples
+        if (vfo) {
+            ring->setSamplerate(samplerate);
+            ring->setFrequency(gui::waterfall.getCenterFrequency() + vfo->getOffset());
+        }
+        else {
+            ring->setSamplerate(sigpath::iqFrontEnd.getEffectiveSamplerate());
+            ring->setFrequency(gui::waterfall.getCenterFrequency());
+        }
+    }
+
+    void convert(uint8_t* out, const dsp::complex_t* in, int count) {
+        switch (sampType) {
+        case SAMPLE_TYPE_INT8:
+            volk_32f_s32f_convert_8i((int8_t*)out, (float*)in, 128.0f, count*2);
+            break;
+        case SAMPLE_TYPE_INT16:
+            volk_32f_s32f_convert_16i((int16_t*)out, (float*)in, 32768.0f, count*2);
+            break;
+        case SAMPLE_TYPE_INT32:
+            volk_32f_s32f_convert_32i((int32_t*)out, (float*)in, 2147483647.0f, count*2);
+            break;
+        default:
+            memcpy(out, in, count*sizeof(dsp::complex_t));
+            break;
+        }
+    }
+
+    static void fftRedraw(ImGui::WaterFall::FFTRedrawArgs args, void* ctx) {
+        IQExporterModule* _this = (IQExporterModule*)ctx;
+        if (_this->ring) { _this->updateRingInfo(); }
+    }
+
+    void writeRing(dsp::complex_t* data, int count) {
+        // Convert directly into the ring, in two parts if it wraps around
+        int size = sampleSize();
+        while (count) {
+            size_t avail;
+            uint8_t* dst = ring->reserve(count*size, avail);
+            int n = avail / size;
+            convert(dst, data, n);
+            ring->commit(n*size);
+            data += n;
+            count -= n;
+        }
+    }
+
     static void dataHandler(dsp::complex_t* data, int count, void* ctx) {
         IQExporterModule* _this = (IQExporterModule*)ctx;
 
         // Try to cquire lock on socket
         if (!_this->sockMtx.try_lock()) { return; }
 
+        // Shared memory doesn't need a socket
+        if (_this->ring) {
+            _this->writeRing(data, count);
+            _this->sockMtx.unlock();
+            return;
+        }
+
         // If not valid or open, give uo
         if (!_this->sock || !_this->sock->isOpen()) {
             // Unlock socket mutex
@@ -559,6 +656,7 @@ private:
     dsp::stream<dsp::complex_t> iqStream;
     dsp::buffer::Reshaper<dsp::complex_t> reshape;
     dsp::sink::Handler<dsp::complex_t> handler;
+    EventHandler<ImGui::WaterFall::FFTRedrawArgs> fftRedrawHandler;
     uint8_t* buffer = NULL;
 
     std::thread listenWorkerThread;
@@ -566,6 +664,7 @@ private:
     std::mutex sockMtx;
     std::shared_ptr<net::Socket> sock;
     std::shared_ptr<net::Listener> listener;
+    std::shared_ptr<shm::RingWriter> ring;
 };
 
 MOD_EXPORT void _INIT_() {
@@ -0,0 +1,467 @@
+#include <imgui.h>
+#include <module.h>
+#include <gui/gui.h>
+#include <gui/style.h>
+#include <gui/tuner.h>
+#include <signal_path/signal_path.h>
+#include <utils/optionlist.h>
+#include <utils/flog.h>
+#include <config.h>
+#include <core.h>
+#include "stitcher.h"
+
+SDRPP_MOD_INFO{
+    /* Name:            */ "panorama",
+    /* Description:     */ "Wideband spectrum stitched from several sources or a sweep",
+    /* Author:          */ "Ryzerth",
+    /* Version:         */ 0, 1, 0,
+    /* Max instances    */ 1
+};
+
+ConfigManager config;
+
+enum Mode {
+    MODE_SOURCES,
+    MODE_SWEEP
+};
+
+class PanoramaModule : public ModuleManager::Instance {
+public:
+    PanoramaModule(std::string name) {
+        this->name = name;
+
+        // Define modes
+        modes.define("sources", "Sources", MODE_SOURCES);
+        modes.define("sweep", "Sweep", MODE_SWEEP);
+
+        // Define resolutions
+        for (int i = 1024; i <= 65536; i <<= 1) {
+            resolutions.define(i, std::to_string(i) + " bins", i);
+        }
+
+        // Load config
+        config.acquire();
+        if (config.conf[name].contains("mode")) {
+            std::string modeStr = config.conf[name]["mode"];
+            if (modes.keyExists(modeStr)) { mode = modes.value(modes.keyId(modeStr)); }
+        }
+        if (config.conf[name].contains("startFreq")) { startFreq = config.conf[name]["startFreq"]; }
+        if (config.conf[name].contains("stopFreq")) { stopFreq = config.conf[name]["stopFreq"]; }
+        if (config.conf[name].contains("resolution")) {
+            int res = config.conf[name]["resolution"];
+            if (resolutions.keyExists(res)) { resolution = resolutions.value(resolutions.keyId(res)); }
+        }
+        if (config.conf[name].contains("dcBins")) { dcBins = config.conf[name]["dcBins"]; }
+        if (config.conf[name].contains("overlap")) { overlap = config.conf[name]["overlap"]; }
+        if (config.conf[name].contains("settleFrames")) { settleFrames = config.conf[name]["settleFrames"]; }
+        if (config.conf[name].contains("framesPerStep")) { framesPerStep = config.conf[name]["framesPerStep"]; }
+        if (config.conf[name].contains("min")) { minDb = config.conf[name]["min"]; }
+        if (config.conf[name].contains("max")) { maxDb = config.conf[name]["max"]; }
+        config.release();
+
+        // Set menu IDs
+        modeId = modes.valueId(mode);
+        resolutionId = resolutions.valueId(resolution);
+
+        // Register event handlers
+        retuneHandler.handler = onRetune;
+        retuneHandler.ctx = this;
+        secondaryAddHandler.handler = onSecondaryAdd;
+        secondaryAddHandler.ctx = this;
+        secondaryRetuneHandler.handler = onSecondaryRetune;
+        secondaryRetuneHandler.ctx = this;
+        secondaryRemoveHandler.handler = onSecondaryRemove;
+        secondaryRemoveHandler.ctx = this;
+        fftRedrawHandler.handler = fftRedraw;
+        fftRedrawHandler.ctx = this;
+        sigpath::sourceManager.onRetune.bindHandler(&retuneHandler);
+        sigpath::sourceManager.onSecondaryAdd.bindHandler(&secondaryAddHandler);
+        sigpath::sourceManager.onSecondaryRetune.bindHandler(&secondaryRetuneHandler);
+        sigpath::sourceManager.onSecondaryRemove.bindHandler(&secondaryRemoveHandler);
+
+        gui::menu.registerEntry(name, menuHandler, this, NULL);
+    }
+
+    ~PanoramaModule() {
+        gui::menu.removeEntry(name);
+        stop();
+        sigpath::sourceManager.onRetune.unbindHandler(&retuneHandler);
+        sigpath::sourceManager.onSecondaryAdd.unbindHandler(&secondaryAddHandler);
+        sigpath::sourceManager.onSecondaryRetune.unbindHandler(&secondaryRetuneHandler);
+        sigpath::sourceManager.onSecondaryRemove.unbindHandler(&secondaryRemoveHandler);
+    }
+
+    void postInit() {}
+
+    void enable() {
+        enabled = true;
+    }
+
+    void disable() {
+        stop();
+        enabled = false;
+    }
+
+    bool isEnabled() {
+        return enabled;
+    }
+
+private:
+    struct SourceTap {
+        IQFrontEnd::FFTTap tap;
+        PanoramaModule* _this;
+        IQFrontEnd* frontEnd;
+        std::string source;
+        std::atomic<double> centerFreq;
+        int segment;
+    };
+
+    void start() {
+        if (running) { return; }
+
+        // Clear the spectrum
+        stitcher.configure(startFreq, stopFreq, resolution, dcBins);
+        stitcher.dropped = 0;
+        stitcher.start();
+        nextSegment = 0;
+
+        // The sweep is stepped from the GUI thread, nothing is collected until the first step on the next frame
+        if (mode == MODE_SWEEP) {
+            std::lock_guard<std::mutex> lck(stepMtx);
+            sweepIndex = 0;
+            discard = 0;
+            collected = framesPerStep;
+        }
+
+        // The main source is always used, in sweep mode it's the only one
+        addTap("", (mode == MODE_SWEEP) ? sweepHandler : tapHandler);
+        if (mode == MODE_SOURCES) {
+            for (auto& source : sigpath::sourceManager.getSecondaryNames()) {
+                addTap(source, tapHandler);
+            }
+        }
+        else {
+            gui::waterfall.onFFTRedraw.bindHandler(&fftRedrawHandler);
+        }
+
+        running = true;
+    }
+
+    void stop() {
+        if (!running) { return; }
+
+        // Stop the sweep
+        if (mode == MODE_SWEEP) {
+            gui::waterfall.onFFTRedraw.unbindHandler(&fftRedrawHandler);
+        }
+
+        // Unbind all taps
+        for (auto& tap : taps) {
+            tap->frontEnd->unbindFFTTap(&tap->tap);
+            delete tap;
+        }
+        taps.clear();
+
+        stitcher.stop();
+        running = false;
+    }
+
+    void addTap(const std::string& source, void (*handler)(const float* data, int size, double sampleRate, void* ctx)) {
+        SourceTap* tap = new SourceTap;
+        tap->_this = this;
+        tap->source = source;
+        tap->frontEnd = sigpath::sourceManager.getFrontEnd(source);
+        tap->centerFreq = source.empty() ? gui::waterfall.getCenterFrequency() : sigpath::sourceManager.getSecondaryFrequency(source);
+        tap->segment = nextSegment++;
+        tap->tap.handler = handler;
+        tap->tap.ctx = tap;
+        tap->frontEnd->bindFFTTap(&tap->tap);
+        taps.push_back(tap);
+    }
+
+    static void tapHandler(const float* data, int size, double sampleRate, void* ctx) {
+        SourceTap* tap = (SourceTap*)ctx;
+        tap->_this->stitcher.push(data, size, tap->centerFreq, sampleRate, tap->segment);
+    }
+
+    static void sweepHandler(const float* data, int size, double sampleRate, void* ctx) {
+        SourceTap* tap = (SourceTap*)ctx;
+        PanoramaModule* _this = tap->_this;
+
+        // Skip the frames that may contain samples from before the retune
+        double freq;
+        int step;
+        {
+            std::lock_guard<std::mutex> lck(_this->stepMtx);
+            if (_this->discard > 0) {
+                _this->discard--;
+                return;
+            }
+            if (_this->collected >= _this->framesPerStep) { return; }
+            _this->collected++;
+            freq = _this->stepFreq;
+            step = _this->step;
+        }
+
+        _this->stitcher.push(data, size, freq, sampleRate, step);
+    }
+
+    static void fftRedraw(ImGui::WaterFall::FFTRedrawArgs args, void* ctx) {
+        PanoramaModule* _this = (PanoramaModule*)ctx;
+
+        // Move on once the step has all its frames, or if they never came
+        auto now = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lck(_this->stepMtx);
+            if (_this->collected < _this->framesPerStep && now < _this->stepDeadline) { return; }
+        }
+
+        // Compute the steps from the current bandwidth, it may change during the sweep
+        double bw = sigpath::iqFrontEnd.getEffectiveSamplerate();
+        double stepSize = std::max<double>(bw * (1.0 - (double)_this->overlap / 100.0), 1.0);
+        int steps = std::max<int>(ceil((_this->stopFreq - _this->startFreq - bw) / stepSize), 0) + 1;
+        if (_this->sweepIndex >= steps) { _this->sweepIndex = 0; }
+        double freq = (steps > 1) ? (_this->startFreq + (bw / 2.0) + _this->sweepIndex * stepSize) : ((_this->startFreq + _this->stopFreq) / 2.0);
+
+        // Retune and drop what was received before
+        tuner::centerTuning("", freq);
+        sigpath::iqFrontEnd.flushInputBuffer();
+        {
+            std::lock_guard<std::mutex> lck(_this->stepMtx);
+            _this->discard = _this->settleFrames;
+            _this->collected = 0;
+            _this->stepFreq = freq;
+            _this->step = _this->sweepIndex;
+        }
+        _this->stepDeadline = now + std::chrono::seconds(2);
+        _this->sweepIndex++;
+    }
+
+    static void onRetune(double freq, void* ctx) {
+        PanoramaModule* _this = (PanoramaModule*)ctx;
+        if (!_this->running || _this->mode != MODE_SOURCES || _this->taps.empty()) { return; }
+        _this->taps[0]->centerFreq = freq;
+    }
+
+    static void onSecondaryAdd(std::string name, void* ctx) {
+        PanoramaModule* _this = (PanoramaModule*)ctx;
+        if (!_this->running || _this->mode != MODE_SOURCES) { return; }
+        _this->addTap(name, tapHandler);
+    }
+
+    static void onSecondaryRetune(std::string name, void* ctx) {
+        PanoramaModule* _this = (PanoramaModule*)ctx;
+        for (auto& tap : _this->taps) {
+            if (tap->source == name) { tap->centerFreq = sigpath::sourceManager.getSecondaryFrequency(name); }
+        }
+    }
+
+    static void onSecondaryRemove(std::string name, void* ctx) {
+        PanoramaModule* _this = (PanoramaModule*)ctx;
+        auto it = std::find_if(_this->taps.begin(), _this->taps.end(), [&](SourceTap* tap) { return tap->source == name; });
+        if (it == _this->taps.end()) { return; }
+        (*it)->frontEnd->unbindFFTTap(&(*it)->tap);
+        delete *it;
+        _this->taps.erase(it);
+    }
+
+    void drawSpectrum(float width, float height) {
+        ImVec2 min = ImGui::GetCursorScreenPos();
+        ImVec2 max = ImVec2(min.x + width, min.y + height);
+        ImDrawList* drawList = ImGui::GetWindowDrawList();
+        drawList->AddRectFilled(min, max, IM_COL32(0, 0, 0, 255));
+        ImGui::Dummy(ImVec2(width, height));
+
+        // Reduce the spectrum to one point per pixel only when it changed
+        int pixels = std::max<int>(width, 2);
+        if (stitcher.getSpectrum(spectrum, version) || (int)points.size() != pixels) {
+            points.resize(pixels);
+            int count = spectrum.size();
+            for (int i = 0; i < pixels && count; i++) {
+                int first = (i * count) / pixels;
+                int last = std::max<int>(((i + 1) * count) / pixels, first + 1);
+                float val = spectrum[first];
+                for (int j = first + 1; j < last; j++) { val = std::max<float>(val, spectrum[j]); }
+                points[i] = val;
+            }
+        }
+        if (spectrum.empty()) { return; }
+
+        // Draw the line
+        float range = std::max<float>(maxDb - minDb, 1.0f);
+        lineBuf.resize(pixels);
+        for (int i = 0; i < pixels; i++) {
+            float y = std::clamp<float>((points[i] - minDb) / range, 0.0f, 1.0f);
+            lineBuf[i] = ImVec2(min.x + i, max.y - y * height);
+        }
+        drawList->AddPolyline(lineBuf.data(), pixels, ImGui::GetColorU32(ImGuiCol_PlotLines), 0, 1.0f);
+    }
+
+    void saveConfig() {
+        config.acquire();
+        config.conf[name]["mode"] = modes.key(modeId);
+        config.conf[name]["startFreq"] = startFreq;
+        config.conf[name]["stopFreq"] = stopFreq;
+        config.conf[name]["resolution"] = resolution;
+        config.conf[name]["dcBins"] = dcBins;
+        config.conf[name]["overlap"] = overlap;
+        config.conf[name]["settleFrames"] = settleFrames;
+        config.conf[name]["framesPerStep"] = framesPerStep;
+        config.conf[name]["min"] = minDb;
+        config.conf[name]["max"] = maxDb;
+        config.release(true);
+    }
+
+    static void menuHandler(void* ctx) {
+        PanoramaModule* _this = (PanoramaModule*)ctx;
+        float menuWidth = ImGui::GetContentRegionAvail().x;
+
+        if (!_this->enabled) { ImGui::BeginDisabled(); }
+        if (_this->running) { ImGui::BeginDisabled(); }
+
+        ImGui::LeftLabel("Mode");
+        ImGui::FillWidth();
+        if (ImGui::Combo(("##panorama_mode_" + _this->name).c_str(), &_this->modeId, _this->modes.txt)) {
+            _this->mode = _this->modes.value(_this->modeId);
+            _this->saveConfig();
+        }
+
+        ImGui::LeftLabel("Start");
+        ImGui::FillWidth();
+        if (ImGui::InputDouble(("##panorama_start_" + _this->name).c_str(), &_this->startFreq, 100000.0, 1000000.0, "%0.0f")) {
+            _this->saveConfig();
+        }
+        ImGui::LeftLabel("Stop");
+        ImGui::FillWidth();
+        if (ImGui::InputDouble(("##panorama_stop_" + _this->name).c_str(), &_this->stopFreq, 100000.0, 1000000.0, "%0.0f")) {
+            _this->saveConfig();
+        }
+
+        ImGui::LeftLabel("Resolution");
+        ImGui::FillWidth();
+        if (ImGui::Combo(("##panorama_res_" + _this->name).c_str(), &_this->resolutionId, _this->resolutions.txt)) {
+            _this->resolution = _this->resolutions.value(_this->resolutionId);
+            _this->saveConfig();
+        }
+
+        ImGui::LeftLabel("DC notch bins");
+        ImGui::FillWidth();
+        if (ImGui::InputInt(("##panorama_dc_" + _this->name).c_str(), &_this->dcBins)) {
+            _this->dcBins = std::clamp<int>(_this->dcBins, 0, 64);
+            _this->saveConfig();
+        }
+
+        if (_this->mode == MODE_SWEEP) {
+            ImGui::LeftLabel("Overlap (%)");
+            ImGui::FillWidth();
+            if (ImGui::SliderInt(("##panorama_overlap_" + _this->name).c_str(), &_this->overlap, 0, 75)) {
+                _this->saveConfig();
+            }
+            ImGui::LeftLabel("Settle frames");
+            ImGui::FillWidth();
+            if (ImGui::InputInt(("##panorama_settle_" + _this->name).c_str(), &_this->settleFrames)) {
+                _this->settleFrames = std::clamp<int>(_this->settleFrames, 0, 100);
+                _this->saveConfig();
+            }
+            ImGui::LeftLabel("Frames per step");
+            ImGui::FillWidth();
+            if (ImGui::InputInt(("##panorama_fps_" + _this->name).c_str(), &_this->framesPerStep)) {
+                _this->framesPerStep = std::clamp<int>(_this->framesPerStep, 1, 100);
+                _this->saveConfig();
+            }
+        }
+
+        if (_this->running) { ImGui::EndDisabled(); }
+
+        ImGui::LeftLabel("Min");
+        ImGui::FillWidth();
+        if (ImGui::SliderFloat(("##panorama_min_" + _this->name).c_str(), &_this->minDb, -150.0f, 0.0f, "%.0f dB")) {
+            _this->saveConfig();
+        }
+        ImGui::LeftLabel("Max");
+        ImGui::FillWidth();
+        if (ImGui::SliderFloat(("##panorama_max_" + _this->name).c_str(), &_this->maxDb, -150.0f, 0.0f, "%.0f dB")) {
+            _this->saveConfig();
+        }
+
+        if (!_this->running && ImGui::Button(("Start##panorama_start_btn_" + _this->name).c_str(), ImVec2(menuWidth, 0))) {
+            _this->start();
+        }
+        else if (_this->running && ImGui::Button(("Stop##panorama_stop_btn_" + _this->name).c_str(), ImVec2(menuWidth, 0))) {
+            _this->stop();
+        }
+
+        _this->drawSpectrum(menuWidth, 150.0f * style::uiScale);
+        ImGui::Text("%.3lf - %.3lf MHz", _this->startFreq / 1e6, _this->stopFreq / 1e6);
+        if (_this->running && _this->stitcher.dropped) {
+            ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "Dropped frames: %d", (int)_this->stitcher.dropped);
+        }
+
+        if (!_this->enabled) { ImGui::EndDisabled(); }
+    }
+
+    std::string name;
+    bool enabled = true;
+    bool running = false;
+
+    Mode mode = MODE_SOURCES;
+    int modeId;
+    double startFreq = 88000000.0;
+    double stopFreq = 108000000.0;
+    int resolution = 4096;
+    int resolutionId;
+    int dcBins = 2;
+    int overlap = 20;
+    int settleFrames = 2;
+    int framesPerStep = 1;
+    float minDb = -120.0f;
+    float maxDb = -20.0f;
+
+    OptionList<std::string, Mode> modes;
+    OptionList<int, int> resolutions;
+
+    Stitcher stitcher;
+    std::vector<SourceTap*> taps;
+    int nextSegment = 0;
+
+    // Sweep state, stepped from the GUI thread and shared with the FFT thread
+    int sweepIndex = 0;
+    std::chrono::steady_clock::time_point stepDeadline;
+    std::mutex stepMtx;
+    int discard = 0;
+    int collected = 0;
+    int step = 0;
+    double stepFreq = 0.0;
+
+    // Display
+    std::vector<float> spectrum;
+    std::vector<float> points;
+    std::vector<ImVec2> lineBuf;
+    uint64_t version = 0;
+
+    EventHandler<double> retuneHandler;
+    EventHandler<std::string> secondaryAddHandler;
+    EventHandler<std::string> secondaryRetuneHandler;
+    EventHandler<std::string> secondaryRemoveHandler;
+    EventHandler<ImGui::WaterFall::FFTRedrawArgs> fftRedrawHandler;
+};
+
+MOD_EXPORT void _INIT_() {
+    json def = json({});
+    config.setPath(core::args["root"].s() + "/panorama_config.json");
+    config.load(def);
+    config.enableAutoSave();
+}
+
+MOD_EXPORT ModuleManager::Instance* _CREATE_INSTANCE_(std::string name) {
+    return new PanoramaModule(name);
+}
+
+MOD_EXPORT void _DELETE_INSTANCE_(void* instance) {
+    delete (PanoramaModule*)instance;
+}
+
+MOD_EXPORT void _END_() {
+    config.disableAutoSave();
+    config.save();
+}
@@ -0,0 +1,181 @@
+#include "stitcher.h"
+#include <algorithm>
+#include <math.h>
+
+// Level of the bins that weren't covered by any frame yet
+#define STITCHER_EMPTY_LEVEL    -150.0f
+
+Stitcher::~Stitcher() {
+    stop();
+}
+
+void Stitcher::configure(double startFreq, double stopFreq, int bins, int dcBins) {
+    bool wasRunning = run;
+    stop();
+
+    this->startFreq = std::min<double>(startFreq, stopFreq);
+    this->stopFreq = std::max<double>(startFreq, stopFreq);
+    this->bins = std::max<int>(bins, 1);
+    this->dcBins = std::max<int>(dcBins, 0);
+
+    // Clear the spectrum
+    power.assign(this->bins, STITCHER_EMPTY_LEVEL);
+    quality.assign(this->bins, 0.0f);
+    segments.assign(this->bins, -1);
+    stamps.assign(this->bins, 0);
+    frameCount = 0;
+    maxAge = 0;
+    segmentCount = 0;
+    {
+        std::lock_guard<std::mutex> lck(resultMtx);
+        result = power;
+        resultVersion++;
+    }
+
+    if (wasRunning) { start(); }
+}
+
+void Stitcher::start() {
+    if (run) { return; }
+    if ((int)power.size() != bins) { configure(startFreq, stopFreq, bins, dcBins); }
+    {
+        std::lock_guard<std::mutex> lck(queueMtx);
+        run = true;
+    }
+    workerThread = std::thread(&Stitcher::worker, this);
+}
+
+void Stitcher::stop() {
+    {
+        std::lock_guard<std::mutex> lck(queueMtx);
+        if (!run) { return; }
+        run = false;
+    }
+    queueCnd.notify_all();
+    if (workerThread.joinable()) { workerThread.join(); }
+
+    // Drop the frames that weren't processed
+    std::lock_guard<std::mutex> lck(queueMtx);
+    while (!queue.empty()) {
+        freeFrames.push_back(std::move(queue.front()));
+        queue.pop_front();
+    }
+}
+
+void Stitcher::push(const float* data, int size, double centerFreq, double sampleRate, int segment) {
+    {
+        std::lock_guard<std::mutex> lck(queueMtx);
+        if (!run) { return; }
+        if (queue.size() >= STITCHER_MAX_QUEUED_FRAMES) {
+            dropped++;
+            return;
+        }
+
+        // Reuse the storage of a previous frame to avoid allocating on every call
+        Frame frame;
+        if (!freeFrames.empty()) {
+            frame = std::move(freeFrames.back());
+            freeFrames.pop_back();
+        }
+        frame.data.assign(data, data + size);
+        frame.centerFreq = centerFreq;
+        frame.sampleRate = sampleRate;
+        frame.segment = segment;
+        queue.push_back(std::move(frame));
+    }
+    queueCnd.notify_one();
+}
+
+bool Stitcher::getSpectrum(std::vector<float>& out, uint64_t& version) {
+    std::lock_guard<std::mutex> lck(resultMtx);
+    if (version == resultVersion) { return false; }
+    out = result;
+    version = resultVersion;
+    return true;
+}
+
+void Stitcher::worker() {
+    Frame frame;
+    while (true) {
+        // Wait for a frame
+        {
+            std::unique_lock<std::mutex> lck(queueMtx);
+            queueCnd.wait(lck, [&]() { return !queue.empty() || !run; });
+            if (!run) { return; }
+            if (!frame.data.empty()) { freeFrames.push_back(std::move(frame)); }
+            frame = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        stitch(frame);
+
+        // Publish once all queued frames are processed
+        bool idle;
+        {
+            std::lock_guard<std::mutex> lck(queueMtx);
+            idle = queue.empty();
+        }
+        if (idle) {
+            std::lock_guard<std::mutex> lck(resultMtx);
+            result = power;
+            resultVersion++;
+        }
+    }
+}
+
+void Stitcher::stitch(Frame& frame) {
+    int size = frame.data.size();
+    if (!size || frame.sampleRate <= 0) { return; }
+
+    // Remove the DC spike of the frame
+    removeDC(frame.data);
+
+    // Values are kept until every segment had a chance to refresh them
+    frameCount++;
+    segmentCount = std::max<int>(segmentCount, frame.segment + 1);
+    maxAge = 2 * segmentCount + 2;
+
+    // Find the output bins covered by the frame
+    double outWidth = (stopFreq - startFreq) / (double)bins;
+    double inWidth = frame.sampleRate / (double)size;
+    double halfSpan = frame.sampleRate / 2.0;
+    double frameStart = frame.centerFreq - halfSpan;
+    int first = std::max<int>(ceil((frameStart - startFreq) / outWidth), 0);
+    int last = std::min<int>(floor((frame.centerFreq + halfSpan - startFreq) / outWidth), bins);
+
+    for (int i = first; i < last; i++) {
+        // Bins towards the edges of a frame suffer from the filter roll-off, prefer values closer to a center
+        double freq = startFreq + ((double)i + 0.5) * outWidth;
+        float q = 1.0f - (float)(fabs(freq - frame.centerFreq) / halfSpan);
+        bool stale = (frameCount - stamps[i] > maxAge);
+        if (segments[i] != frame.segment && q < quality[i] && !stale) { continue; }
+
+        // Take the peak of the input bins falling in the output bin
+        double a = (startFreq + (double)i * outWidth - frameStart) / inWidth;
+        int i0 = std::clamp<int>(floor(a), 0, size - 1);
+        int i1 = std::clamp<int>(ceil(a + outWidth / inWidth), i0 + 1, size);
+        float val = frame.data[i0];
+        for (int j = i0 + 1; j < i1; j++) { val = std::max<float>(val, frame.data[j]); }
+
+        power[i] = val;
+        quality[i] = q;
+        segments[i] = frame.segment;
+        stamps[i] = frameCount;
+    }
+}
+
+void Stitcher::removeDC(std::vector<float>& data) {
+    int size = data.size();
+    int center = size / 2;
+    int lo = center - dcBins - 1;
+    int hi = center + dcBins + 1;
+    if (!dcBins || lo < 0 || hi >= size) { return; }
+
+    // Interpolate between the bins on each side of the spike
+    float a = data[lo];
+    float b = data[hi];
+    for (int i = lo + 1; i < hi; i++) {
+        float t = (float)(i - lo) / (float)(hi - lo);
+        data[i] = a + (b - a) * t;
+    }
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <stdint.h>
+
+// Maximum number of frames waiting to be stitched, more are dropped
+#define STITCHER_MAX_QUEUED_FRAMES  32
+
+// Builds a single wide spectrum out of FFT frames covering parts of it. The frames can come from
+// several sources at once or from successive steps of a sweep, identified by a segment ID.
+// All the work is done in a background thread, the GUI only copies the latest result.
+class Stitcher {
+public:
+    ~Stitcher();
+
+    /**
+     * Set the covered range and resolution. Clears the spectrum.
+     * @param startFreq Lowest frequency in Hz.
+     * @param stopFreq Highest frequency in Hz.
+     * @param bins Number of bins of the output.
+     * @param dcBins Number of bins on each side of DC to replace by interpolation.
+     */
+    void configure(double startFreq, double stopFreq, int bins, int dcBins);
+
+    void start();
+    void stop();
+
+    /**
+     * Queue a frame for stitching. Safe to call from any thread, never blocks for long.
+     * @param data Power spectrum in dB, DC in the middle.
+     * @param size Number of bins of the frame.
+     * @param centerFreq Frequency of the center of the frame in Hz.
+     * @param sampleRate Width of the frame in Hz.
+     * @param segment ID of the source or sweep step that produced the frame.
+     */
+    void push(const float* data, int size, double centerFreq, double sampleRate, int segment);
+
+    /**
+     * Copy the latest spectrum if it changed since the given version.
+     * @param out Output vector, resized to the number of bins.
+     * @param version Version of the data already in out, updated if new data was copied.
+     * @return True if new data was copied.
+     */
+    bool getSpectrum(std::vector<float>& out, uint64_t& version);
+
+    /**
+     * Number of frames dropped because the worker couldn't keep up.
+     */
+    std::atomic<uint64_t> dropped = 0;
+
+private:
+    struct Frame {
+        std::vector<float> data;
+        double centerFreq;
+        double sampleRate;
+        int segment;
+    };
+
+    void worker();
+    void stitch(Frame& frame);
+    void removeDC(std::vector<float>& data);
+
+    // Parameters, only changed while the worker is stopped
+    double startFreq = 88e6;
+    double stopFreq = 108e6;
+    int bins = 4096;
+    int dcBins = 2;
+
+    // Input queue
+    std::mutex queueMtx;
+    std::condition_variable queueCnd;
+    std::deque<Frame> queue;
+    std::vector<Frame> freeFrames;
+    bool run = false;
+
+    // Stitched spectrum, each bin remembers the quality and age of its value
+    std::vector<float> power;
+    std::vector<float> quality;
+    std::vector<int> segments;
+    std::vector<uint64_t> stamps;
+    uint64_t frameCount = 0;
+    uint64_t maxAge = 0;
+    int segmentCount = 0;
+
+    // Result for the GUI
+    std::mutex resultMtx;
+    std::vector<float> result;
+    uint64_t resultVersion = 0;
+
+    std::thread workerThread;
+};
@@ -170,7 +170,8 @@ public:
         // Open file
         std::string vfoName = (recMode == RECORDER_MODE_AUDIO) ? selectedStreamName : "";
         std::string extension = ".wav";
-        std::string expandedPath = expandString(folderSelect.path + "/" + genFileName(nameTemplate, recMode, vfoName) + extension);
+        std::string fileName = namePrefix + genFileName(nameTemplate, recMode, vfoName);
+        std::string expandedPath = expandString(folderSelect.path + "/" + fileName + extension);
         if (!writer.open(expandedPath)) {
             flog::error("Failed to open file for recording: {0}", expandedPath);
             return;
@@ -557,12 +558,17 @@ private:
         else if (code == RECORDER_IFACE_CMD_STOP) {
             if (_this->recording) { _this->stop(); }
         }
+        else if (code == RECORDER_IFACE_CMD_SET_NAME_PREFIX) {
+            std::string* _in = (std::string*)in;
+            _this->namePrefix = *_in;
+        }
     }
 
     std::string name;
     bool enabled = true;
     std::string root;
     char nameTemplate[1024];
+    std::string namePrefix = "";
 
     OptionList<std::string, wav::Format> containers;
     OptionList<int, wav::SampleType> sampleTypes;
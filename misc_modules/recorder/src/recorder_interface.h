@@ -4,7 +4,8 @@ enum {
     RECORDER_IFACE_CMD_GET_MODE,
     RECORDER_IFACE_CMD_SET_MODE,
     RECORDER_IFACE_CMD_START,
-    RECORDER_IFACE_CMD_STOP
+    RECORDER_IFACE_CMD_STOP,
+    RECORDER_IFACE_CMD_SET_NAME_PREFIX
 };
 
 enum {
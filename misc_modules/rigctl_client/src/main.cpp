@@ -10,8 +10,17 @@
 #include <config.h>
 #include <cctype>
 #include <radio_interface.h>
+#include <thread>
+#include <deque>
+#include <chrono>
+#include <condition_variable>
+#include <atomic>
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
+#define MAX_COMMANDS_IN_FLIGHT  4
+#define REPLY_TIMEOUT_MS        100
+#define REPLY_DEADLINE_MS       1000
+
 SDRPP_MOD_INFO{
     /* Name:            */ "rigctl_client",
     /* Description:     */ "Client for the RigCTL protocol",
@@ -76,33 +85,61 @@ public:
         std::lock_guard<std::recursive_mutex> lck(mtx);
         if (running) { return; }
 
+        // Clean up after a previous connection failure
+        stop();
+
         // Connect to rigctl server
         try {
-            client = net::rigctl::connect(host, port);
+            std::atomic_store(&client, net::rigctl::connect(host, port));
         }
         catch (const std::exception& e) {
             flog::error("Could not connect: {}", e.what());
+            error = "Could not connect";
             return;
         }
+        error = NULL;
 
         // Switch source to panadapter mode
         sigpath::sourceManager.setPanadapterIF(ifFreq);
         sigpath::sourceManager.setTuningMode(SourceManager::TuningMode::PANADAPTER);
         sigpath::sourceManager.onRetune.bindHandler(&_retuneHandler);
 
+        // Start the command workers
+        pendingFreq = false;
+        pendingMode = false;
+        haveFreq = false;
+        resyncing = false;
+        sending = false;
+        lastMode = net::rigctl::MODE_INVALID;
+        inFlight.clear();
+        latency = 0.0;
+        stopWorkers = false;
+        sendThread = std::thread(&RigctlClientModule::sendWorker, this);
+        recvThread = std::thread(&RigctlClientModule::recvWorker, this);
+
         running = true;
     }
 
     void stop() {
         std::lock_guard<std::recursive_mutex> lck(mtx);
-        if (!running) { return; }
+        // The workers clear running themselves if the connection fails, clean up after them as well
+        if (!running && !sendThread.joinable()) { return; }
 
         // Switch source back to normal mode
         sigpath::sourceManager.onRetune.unbindHandler(&_retuneHandler);
         sigpath::sourceManager.setTuningMode(SourceManager::TuningMode::NORMAL);
 
+        // Stop the command workers
+        {
+            std::lock_guard<std::mutex> lck(cmdMtx);
+            stopWorkers = true;
+        }
+        cmdCnd.notify_all();
+        if (sendThread.joinable()) { sendThread.join(); }
+        if (recvThread.joinable()) { recvThread.join(); }
+
         // Disconnect from rigctl server
-        client->close();
+        std::atomic_load(&client)->close();
 
         running = false;
     }
@@ -138,6 +175,9 @@ private:
             config.release(true);
         }
 
+        // Clean up after a connection failure
+        if (!_this->running && _this->sendThread.joinable()) { _this->stop(); }
+
         ImGui::FillWidth();
         if (_this->running && ImGui::Button(CONCAT("Stop##_rigctl_cli_stop_", _this->name), ImVec2(menuWidth, 0))) {
             _this->stop();
@@ -148,12 +188,19 @@ private:
 
         ImGui::TextUnformatted("Status:");
         ImGui::SameLine();
-        if (_this->client && _this->client->isOpen() && _this->running) {
+        auto client = std::atomic_load(&_this->client);
+        if (client && client->isOpen() && _this->running) {
             ImGui::TextColored(ImVec4(0.0, 1.0, 0.0, 1.0), "Connected");
+            ImGui::TextUnformatted("Latency:");
+            ImGui::SameLine();
+            ImGui::Text("%.1lf ms", _this->latency.load());
         }
-        else if (_this->client && _this->running) {
+        else if (client && _this->running) {
             ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Disconnected");
         }
+        else if (_this->error) {
+            ImGui::TextColored(ImVec4(1.0, 0.0, 0.0, 1.0), "%s", _this->error.load());
+        }
         else {
             ImGui::TextUnformatted("Idle");
         }
@@ -161,15 +208,191 @@ private:
 
     static void retuneHandler(double freq, void* ctx) {
         RigctlClientModule* _this = (RigctlClientModule*)ctx;
-        if (!_this->client || !_this->client->isOpen()) { return; }
-        if (_this->client->setFreq(freq)) {
-            flog::error("Could not set frequency");
+
+        // Follow the mode of the selected radio if there is one
+        net::rigctl::Mode mode = net::rigctl::MODE_INVALID;
+        std::string vfoName = gui::waterfall.selectedVFO;
+        if (!vfoName.empty() && core::modComManager.getModuleName(vfoName) == "radio") {
+            int radioMode;
+            core::modComManager.callInterface(vfoName, RADIO_IFACE_CMD_GET_MODE, NULL, &radioMode);
+            mode = radioModeToRigctl(radioMode);
+        }
+
+        // Only keep the latest values, the send worker picks them up as soon as the rig can take more commands
+        {
+            std::lock_guard<std::mutex> lck(_this->cmdMtx);
+            _this->nextFreq = freq;
+            _this->pendingFreq = true;
+            _this->haveFreq = true;
+            if (mode != net::rigctl::MODE_INVALID && mode != _this->lastMode) {
+                _this->nextMode = mode;
+                _this->lastMode = mode;
+                _this->pendingMode = true;
+            }
+        }
+        _this->cmdCnd.notify_all();
+    }
+
+    static net::rigctl::Mode radioModeToRigctl(int mode) {
+        switch (mode) {
+        case RADIO_IFACE_MODE_NFM:  return net::rigctl::MODE_FM;
+        case RADIO_IFACE_MODE_WFM:  return net::rigctl::MODE_WFM;
+        case RADIO_IFACE_MODE_AM:   return net::rigctl::MODE_AM;
+        case RADIO_IFACE_MODE_DSB:  return net::rigctl::MODE_DSB;
+        case RADIO_IFACE_MODE_USB:  return net::rigctl::MODE_USB;
+        case RADIO_IFACE_MODE_CW:   return net::rigctl::MODE_CW;
+        case RADIO_IFACE_MODE_LSB:  return net::rigctl::MODE_LSB;
+        default:                    return net::rigctl::MODE_INVALID;
+        }
+    }
+
+    void sendWorker() {
+        while (true) {
+            bool sendMode = false;
+            bool sendFreq = false;
+            net::rigctl::Mode mode;
+            double freq;
+
+            // Wait for a new command and room in the pipeline
+            {
+                std::unique_lock<std::mutex> lck(cmdMtx);
+                cmdCnd.wait(lck, [this]() { return ((pendingFreq || pendingMode) && inFlight.size() < MAX_COMMANDS_IN_FLIGHT && !resyncing) || stopWorkers; });
+                if (stopWorkers) { break; }
+
+                // Queue the commands before sending them so that the reply always finds them.
+                // The mode goes first so that the rig doesn't change its filter after tuning.
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(REPLY_DEADLINE_MS);
+                if (pendingMode) {
+                    pendingMode = false;
+                    sendMode = true;
+                    mode = nextMode;
+                    inFlight.push_back({ std::chrono::steady_clock::now(), deadline, "mode" });
+                }
+                if (pendingFreq && inFlight.size() < MAX_COMMANDS_IN_FLIGHT) {
+                    pendingFreq = false;
+                    sendFreq = true;
+                    freq = nextFreq;
+                    inFlight.push_back({ std::chrono::steady_clock::now(), deadline, "frequency" });
+                }
+                sending = true;
+            }
+            cmdCnd.notify_all();
+
+            // Send without holding the lock, the retune handler must never wait on the socket
+            if ((sendMode && client->sendMode(mode) <= 0) || (sendFreq && client->sendFreq(freq) <= 0)) {
+                flog::error("Could not send command to the rigctl server");
+                fail("Connection lost");
+                break;
+            }
+            {
+                std::lock_guard<std::mutex> lck(cmdMtx);
+                sending = false;
+            }
+            cmdCnd.notify_all();
+        }
+    }
+
+    void recvWorker() {
+        while (true) {
+            // Wait for a command to be sent
+            {
+                std::unique_lock<std::mutex> lck(cmdMtx);
+                cmdCnd.wait(lck, [this]() { return !inFlight.empty() || stopWorkers; });
+                if (stopWorkers) { break; }
+            }
+
+            // Receive the reply, timing out regularly to be able to stop
+            int status;
+            bool gotReply = client->recvReply(status, REPLY_TIMEOUT_MS);
+            if (!gotReply && !client->isOpen()) {
+                flog::error("Connection to the rigctl server lost");
+                fail("Connection lost");
+                break;
+            }
+
+            bool timedOut;
+            {
+                std::unique_lock<std::mutex> lck(cmdMtx);
+                auto now = std::chrono::steady_clock::now();
+
+                // Retire the oldest command
+                if (gotReply && !inFlight.empty()) {
+                    Command cmd = inFlight.front();
+                    inFlight.pop_front();
+                    double rtt = std::chrono::duration<double, std::milli>(now - cmd.sendTime).count();
+                    double lat = latency;
+                    latency = (lat == 0.0) ? rtt : ((0.8 * lat) + (0.2 * rtt));
+                    if (status) { flog::error("Could not set {0} ({1})", cmd.name, status); }
+                }
+
+                // A command the rig never answered can't just be dropped, its reply could still come and be taken
+                // for the reply of the next one. Stop sending and start over on a new connection instead.
+                timedOut = (!inFlight.empty() && now > inFlight.front().deadline);
+                if (timedOut) {
+                    flog::warn("No reply to the {} command from the rigctl server, reconnecting", inFlight.front().name);
+                    resyncing = true;
+                    cmdCnd.wait(lck, [this]() { return !sending || stopWorkers; });
+                    if (stopWorkers) { break; }
+                    inFlight.clear();
+                }
+            }
+            cmdCnd.notify_all();
+
+            if (timedOut && !reconnect()) {
+                fail("Connection lost");
+                break;
+            }
         }
     }
 
+    // Only called from the receive worker while the send worker is held back
+    bool reconnect() {
+        std::shared_ptr<net::rigctl::Client> newClient;
+        try {
+            newClient = net::rigctl::connect(host, port);
+        }
+        catch (const std::exception& e) {
+            flog::error("Could not reconnect: {}", e.what());
+            return false;
+        }
+        std::atomic_load(&client)->close();
+        std::atomic_store(&client, newClient);
+
+        // Send the current state again, the commands that were in flight may not have been applied
+        {
+            std::lock_guard<std::mutex> lck(cmdMtx);
+            resyncing = false;
+            if (haveFreq) { pendingFreq = true; }
+            if (lastMode != net::rigctl::MODE_INVALID) {
+                nextMode = lastMode;
+                pendingMode = true;
+            }
+        }
+        cmdCnd.notify_all();
+        return true;
+    }
+
+    // Called by the workers, the GUI thread then cleans up through stop()
+    void fail(const char* err) {
+        error = err;
+        running = false;
+        {
+            std::lock_guard<std::mutex> lck(cmdMtx);
+            stopWorkers = true;
+        }
+        cmdCnd.notify_all();
+    }
+
+    struct Command {
+        std::chrono::time_point<std::chrono::steady_clock> sendTime;
+        std::chrono::time_point<std::chrono::steady_clock> deadline;
+        const char* name;
+    };
+
     std::string name;
     bool enabled = true;
-    bool running = false;
+    std::atomic<bool> running = false;
+    std::atomic<const char*> error = NULL;
     std::recursive_mutex mtx;
 
     char host[1024];
@@ -179,6 +402,22 @@ private:
     double ifFreq = 8830000.0;
 
     EventHandler<double> _retuneHandler;
+
+    std::thread sendThread;
+    std::thread recvThread;
+    std::mutex cmdMtx;
+    std::condition_variable cmdCnd;
+    bool stopWorkers = false;
+    bool pendingFreq = false;
+    bool pendingMode = false;
+    bool haveFreq = false;
+    bool resyncing = false;
+    bool sending = false;
+    double nextFreq;
+    net::rigctl::Mode nextMode;
+    net::rigctl::Mode lastMode = net::rigctl::MODE_INVALID;
+    std::deque<Command> inFlight;
+    std::atomic<double> latency = 0.0;
 };
 
 MOD_EXPORT void _INIT_() {
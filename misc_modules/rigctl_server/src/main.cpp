@@ -10,9 +10,13 @@
 #include <config.h>
 #include <cctype>
 #include <radio_interface.h>
+#include <thread>
+#include <chrono>
+#include <atomic>
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
 #define MAX_COMMAND_LENGTH 8192
+#define NOTIFY_INTERVAL_MS 100
 
 SDRPP_MOD_INFO{
     /* Name:            */ "rigctl_server",
@@ -63,8 +67,7 @@ public:
         sigpath::vfoManager.onVfoDeleted.unbindHandler(&vfoDeletedHandler);
         core::moduleManager.onInstanceCreated.unbindHandler(&modChangedHandler);
         core::moduleManager.onInstanceDeleted.unbindHandler(&modChangedHandler);
-        if (client) { client->close(); }
-        if (listener) { listener->close(); }
+        stopServer();
     }
 
     void postInit() {
@@ -184,8 +187,9 @@ private:
 
         ImGui::TextUnformatted("Status:");
         ImGui::SameLine();
-        if (_this->client && _this->client->isOpen()) {
-            ImGui::TextColored(ImVec4(0.0, 1.0, 0.0, 1.0), "Connected");
+        int clientCount = _this->getClientCount();
+        if (clientCount) {
+            ImGui::TextColored(ImVec4(0.0, 1.0, 0.0, 1.0), "Connected (%d client%s)", clientCount, (clientCount > 1) ? "s" : "");
         }
         else if (listening) {
             ImGui::TextColored(ImVec4(1.0, 1.0, 0.0, 1.0), "Listening");
@@ -202,12 +206,45 @@ private:
         }
         catch (const std::exception& e) {
             flog::error("Could not start rigctl server: {}", e.what());
+            return;
         }
+
+        // Start the notification worker
+        {
+            std::lock_guard lck(clientsMtx);
+            stopNotifier = false;
+        }
+        notifyThread = std::thread(&SigctlServerModule::notifyWorker, this);
     }
 
     void stopServer() {
-        if (client) { client->close(); }
-        listener->close();
+        // Stop accepting clients before closing the existing ones
+        if (listener) { listener->close(); }
+
+        // Stop the notification worker
+        {
+            std::lock_guard lck(clientsMtx);
+            stopNotifier = true;
+        }
+        notifyCnd.notify_all();
+        if (notifyThread.joinable()) { notifyThread.join(); }
+
+        // Disconnect all clients, without the lock since closing waits for their workers
+        std::vector<std::shared_ptr<RigctlClient>> closed;
+        {
+            std::lock_guard lck(clientsMtx);
+            closed.swap(clients);
+        }
+        for (auto& cl : closed) { cl->conn->close(); }
+    }
+
+    int getClientCount() {
+        std::lock_guard lck(clientsMtx);
+        int count = 0;
+        for (auto& cl : clients) {
+            if (cl->conn->isOpen() && !cl->quit) { count++; }
+        }
+        return count;
     }
 
     void refreshModules() {
@@ -304,33 +341,119 @@ private:
         _this->selectRecorderByName(_this->selectedRecorder);
     }
 
+    struct RigctlClient {
+        SigctlServerModule* server;
+        net::Conn conn;
+        uint8_t dataBuf[1024];
+        std::string command;
+        std::string reply;
+
+        // Flags are also read by the notification worker
+        std::atomic<bool> notify = false;
+        std::atomic<bool> quit = false;
+
+        // Serializes the replies and the notifications so that lines never interleave
+        std::mutex writeMtx;
+    };
+
     static void clientHandler(net::Conn _client, void* ctx) {
         SigctlServerModule* _this = (SigctlServerModule*)ctx;
-        //flog::info("New client!");
-
-        _this->client = std::move(_client);
-        _this->client->readAsync(1024, _this->dataBuf, dataHandler, _this, false);
-        _this->client->waitForEnd();
-        _this->client->close();
 
-        //flog::info("Client disconnected!");
+        // Register the client and start reading from it
+        auto cl = std::make_shared<RigctlClient>();
+        cl->server = _this;
+        cl->conn = std::move(_client);
+        {
+            std::lock_guard lck(_this->clientsMtx);
+            _this->clients.push_back(cl);
+        }
+        cl->conn->readAsync(sizeof(cl->dataBuf), cl->dataBuf, dataHandler, cl.get(), false);
 
+        // Immediately wait for the next client
         _this->listener->acceptAsync(clientHandler, _this);
     }
 
     static void dataHandler(int count, uint8_t* data, void* ctx) {
-        SigctlServerModule* _this = (SigctlServerModule*)ctx;
+        RigctlClient* cl = (RigctlClient*)ctx;
+        SigctlServerModule* _this = cl->server;
 
-        for (int i = 0; i < count; i++) {
-            if (data[i] == '\n') {
-                _this->commandHandler(_this->command);
-                _this->command.clear();
-                continue;
+        // Execute every complete command of the chunk, replies are batched into a single write
+        {
+            std::lock_guard lck(_this->commandMtx);
+            for (int i = 0; i < count && !cl->quit; i++) {
+                if (data[i] == '\n') {
+                    _this->commandHandler(cl, cl->command);
+                    cl->command.clear();
+                    continue;
+                }
+                if (cl->command.size() < MAX_COMMAND_LENGTH) { cl->command += (char)data[i]; }
             }
-            if (_this->command.size() < MAX_COMMAND_LENGTH) { _this->command += (char)data[i]; }
+        }
+        if (!cl->reply.empty()) {
+            std::lock_guard lck(cl->writeMtx);
+            cl->conn->write(cl->reply.size(), (uint8_t*)cl->reply.c_str());
+            cl->reply.clear();
         }
 
-        _this->client->readAsync(1024, _this->dataBuf, dataHandler, _this, false);
+        // The connection is closed by the notification worker once the client quits
+        if (cl->quit) { return; }
+        cl->conn->readAsync(sizeof(cl->dataBuf), cl->dataBuf, dataHandler, cl, false);
+    }
+
+    double getTunedFrequency() {
+        std::lock_guard lck(vfoMtx);
+
+        // Get center frequency of the SDR
+        double freq = gui::waterfall.getCenterFrequency();
+
+        // Add the offset of the VFO if it exists
+        if (sigpath::vfoManager.vfoExists(selectedVfo)) {
+            freq += sigpath::vfoManager.getOffset(selectedVfo);
+        }
+
+        return freq;
+    }
+
+    void notifyWorker() {
+        uint64_t lastFreq = 0;
+        while (true) {
+            // Only copy the list with the lock held, a write to a client that stopped reading
+            // blocks and the menu needs the lock every frame
+            std::vector<std::shared_ptr<RigctlClient>> closed;
+            std::vector<std::shared_ptr<RigctlClient>> subscribers;
+            {
+                // Wait for the next check or for the server to stop
+                std::unique_lock lck(clientsMtx);
+                notifyCnd.wait_for(lck, std::chrono::milliseconds(NOTIFY_INTERVAL_MS), [this]() { return stopNotifier; });
+                if (stopNotifier) { break; }
+
+                // Take out the clients that disconnected or quit, keep those that asked for notifications
+                for (auto it = clients.begin(); it != clients.end();) {
+                    if ((*it)->quit || !(*it)->conn->isOpen()) {
+                        closed.push_back(*it);
+                        it = clients.erase(it);
+                        continue;
+                    }
+                    if ((*it)->notify) { subscribers.push_back(*it); }
+                    it++;
+                }
+            }
+
+            // Closing a connection joins its workers which is why this can't be done from the data handler
+            for (auto& cl : closed) { cl->conn->close(); }
+
+            // Push the frequency to the clients that asked for it when it changes
+            if (subscribers.empty()) { continue; }
+            uint64_t freq = getTunedFrequency();
+            if (freq == lastFreq) { continue; }
+            lastFreq = freq;
+            char buf[128];
+            sprintf(buf, "Frequency: %" PRIu64 "\n", freq);
+            for (auto& cl : subscribers) {
+                std::lock_guard wlck(cl->writeMtx);
+                cl->conn->write(strlen(buf), (uint8_t*)buf);
+            }
+        }
     }
 
     std::map<int, const char*> radioModeToString = {
@@ -344,7 +467,7 @@ private:
         { RADIO_IFACE_MODE_RAW, "RAW" }
     };
 
-    void commandHandler(std::string cmd) {
+    void commandHandler(RigctlClient* cl, std::string cmd) {
         std::string corr = "";
         std::vector<std::string> parts;
         bool lastWasSpace = false;
@@ -367,8 +490,6 @@ private:
             parts.push_back(corr);
         }
 
-        // NOTE: THIS STUFF ISN'T THREADSAFE AND WILL LIKELY BREAK.
-
         // If the command is empty, do nothing
         if (parts.size() == 0) { return; }
 
@@ -377,7 +498,7 @@ private:
             std::string arguments;
             if (parts.size() > 1) { arguments = cmd.substr(parts[0].size()); }
             for (char c : parts[0]) {
-                commandHandler(c + arguments);
+                commandHandler(cl, c + arguments);
             }
             return;
         }
@@ -391,14 +512,14 @@ private:
             // if number of arguments isn't correct, return error
             if (parts.size() != 2) {
                 resp = "RPRT 1\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                cl->reply += resp;
                 return;
             }
 
             // If not controlling the VFO, return
             if (!tuningEnabled) {
                 resp = "RPRT 0\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                cl->reply += resp;
                 return;
             }
 
@@ -406,23 +527,15 @@ private:
             long long freq = std::stoll(parts[1]);
             tuner::tune(tuner::TUNER_MODE_NORMAL, selectedVfo, freq);
             resp = "RPRT 0\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            cl->reply += resp;
         }
         else if (parts[0] == "f" || parts[0] == "\\get_freq") {
-            std::lock_guard lck(vfoMtx);
-
-            // Get center frequency of the SDR
-            double freq = gui::waterfall.getCenterFrequency();
-
-            // Add the offset of the VFO if it exists
-            if (sigpath::vfoManager.vfoExists(selectedVfo)) {
-                freq += sigpath::vfoManager.getOffset(selectedVfo);
-            }
+            double freq = getTunedFrequency();
 
             // Respond with the frequency
             char buf[128];
             sprintf(buf, "%" PRIu64 "\n", (uint64_t)freq);
-            client->write(strlen(buf), (uint8_t*)buf);
+            cl->reply += buf;
         }
         else if (parts[0] == "M" || parts[0] == "\\set_mode") {
             std::lock_guard lck(vfoMtx);
@@ -431,14 +544,14 @@ private:
             // If client is querying, respond accordingly
             if (parts.size() >= 2 && parts[1] == "?") {
                 resp = "FM WFM AM DSB USB CW LSB RAW\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                cl->reply += resp;
                 return;
             }
 
             // if number of arguments isn't correct, return error
             if (parts.size() != 3) {
                 resp = "RPRT 1\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                cl->reply += resp;
                 return;
             }
 
@@ -447,7 +560,7 @@ private:
             for (char c : parts[2]) {
                 if (!std::isdigit(c) && !(c == '-' && !pos)) {
                     resp = "RPRT 1\n";
-                    client->write(resp.size(), (uint8_t*)resp.c_str());
+                    cl->reply += resp;
                     return;
                 }
                 pos++;
@@ -461,7 +574,7 @@ private:
             });
             if (it == radioModeToString.end()) {
                 resp = "RPRT 1\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                cl->reply += resp;
                 return;
             }
             int newMode = it->first;
@@ -474,7 +587,7 @@ private:
                 }
             }
 
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            cl->reply += resp;
         }
         else if (parts[0] == "m" || parts[0] == "\\get_mode") {
             std::lock_guard lck(vfoMtx);
@@ -492,7 +605,7 @@ private:
                 resp += "0\n";
             }
 
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            cl->reply += resp;
         }
         else if (parts[0] == "V" || parts[0] == "\\set_vfo") {
             std::lock_guard lck(vfoMtx);
@@ -501,7 +614,7 @@ private:
             // if number of arguments isn't correct or the VFO is not "VFO", return error
             if (parts.size() != 2) {
                 resp = "RPRT 1\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                cl->reply += resp;
                 return;
             }
 
@@ -512,27 +625,27 @@ private:
                 resp = "RPRT 1\n";
             }
 
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            cl->reply += resp;
         }
         else if (parts[0] == "v" || parts[0] == "\\get_vfo") {
             std::lock_guard lck(vfoMtx);
             resp = "VFO\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            cl->reply += resp;
         }
         else if (parts[0] == "\\chk_vfo") {
             std::lock_guard lck(vfoMtx);
             resp = "CHKVFO 0\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            cl->reply += resp;
         }
         else if (parts[0] == "s") {
             std::lock_guard lck(vfoMtx);
             resp = "0\nVFOA\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            cl->reply += resp;
         }
         else if (parts[0] == "S") {
             std::lock_guard lck(vfoMtx);
             resp = "RPRT 0\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            cl->reply += resp;
         }
         else if (parts[0] == "AOS" || parts[0] == "\\recorder_start") {
             std::lock_guard lck(recorderMtx);
@@ -540,7 +653,7 @@ private:
             // If not controlling the recorder, return
             if (!recordingEnabled) {
                 resp = "RPRT 0\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                cl->reply += resp;
                 return;
             }
 
@@ -554,7 +667,7 @@ private:
 
             // Respond with a success
             resp = "RPRT 0\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            cl->reply += resp;
         }
         else if (parts[0] == "LOS" || parts[0] == "\\recorder_stop") {
             std::lock_guard lck(recorderMtx);
@@ -562,7 +675,7 @@ private:
             // If not controlling the recorder, return
             if (!recordingEnabled) {
                 resp = "RPRT 0\n";
-                client->write(resp.size(), (uint8_t*)resp.c_str());
+                cl->reply += resp;
                 return;
             }
 
@@ -576,10 +689,25 @@ private:
 
             // Respond with a success
             resp = "RPRT 0\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            cl->reply += resp;
+        }
+        else if (parts[0] == "A" || parts[0] == "\\set_trn") {
+            // Transceive mode RIG enables frequency change notifications for this client
+            if (parts.size() != 2 || (parts[1] != "OFF" && parts[1] != "RIG" && parts[1] != "POLL")) {
+                resp = "RPRT 1\n";
+                cl->reply += resp;
+                return;
+            }
+            cl->notify = (parts[1] == "RIG");
+            resp = "RPRT 0\n";
+            cl->reply += resp;
+        }
+        else if (parts[0] == "a" || parts[0] == "\\get_trn") {
+            resp = cl->notify ? "RIG\n" : "OFF\n";
+            cl->reply += resp;
         }
         else if (parts[0] == "q" || parts[0] == "\\quit") {
-            // Will close automatically
+            cl->quit = true;
         }
         else if (parts[0] == "\\start") {
             gui::mainWindow.setPlayState(true);
@@ -657,18 +785,18 @@ private:
                 "0\n" /* RIG_PARM_NONE */
                 /* Bit field list of set parm */
                 "0\n" /* RIG_PARM_NONE */;
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            cl->reply += resp;
         }
         // This get_powerstat stuff is a wordaround for WSJT-X 2.7.0
         else if (parts[0] == "\\get_powerstat") {
             resp = "1\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            cl->reply += resp;
         }
         else {
             // If command is not recognized, return error
             flog::error("Rigctl client sent invalid command: '{0}'", cmd);
             resp = "RPRT 1\n";
-            client->write(resp.size(), (uint8_t*)resp.c_str());
+            cl->reply += resp;
             return;
         }
     }
@@ -678,11 +806,14 @@ private:
 
     char hostname[1024];
     int port = 4532;
-    uint8_t dataBuf[1024];
     net::Listener listener;
-    net::Conn client;
 
-    std::string command = "";
+    std::mutex clientsMtx;
+    std::vector<std::shared_ptr<RigctlClient>> clients;
+    std::mutex commandMtx;
+    std::thread notifyThread;
+    std::condition_variable notifyCnd;
+    bool stopNotifier = false;
 
     EventHandler<std::string> modChangedHandler;
     EventHandler<VFOManager::VFO*> vfoCreatedHandler;
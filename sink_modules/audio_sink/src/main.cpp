@@ -1,9 +1,11 @@
 #include <imgui.h>
 #include <module.h>
 #include <gui/gui.h>
+#include <gui/style.h>
 #include <signal_path/signal_path.h>
 #include <signal_path/sink.h>
 #include <dsp/buffer/packer.h>
+#include <dsp/sink/audio_fifo.h>
 #include <dsp/convert/stereo_to_mono.h>
 #include <utils/flog.h>
 #include <RtAudio.h>
@@ -12,6 +14,9 @@
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
+// Number of audio buffers worth of samples kept in the FIFO
+#define TARGET_LATENCY_BUFFERS  2
+
 SDRPP_MOD_INFO{
     /* Name:            */ "audio_sink",
     /* Description:     */ "Audio sink module for SDR++",
@@ -22,6 +27,33 @@ SDRPP_MOD_INFO{
 
 ConfigManager config;
 
+// List the output devices, shared by the audio sinks and the mixer
+void listOutputDevices(RtAudio& audio, std::vector<RtAudio::DeviceInfo>& devList, std::vector<unsigned int>& deviceIds, std::string& txtDevList, unsigned int& defaultDevId) {
+    RtAudio::DeviceInfo info;
+#if RTAUDIO_VERSION_MAJOR >= 6
+    for (int i : audio.getDeviceIds()) {
+#else
+    int count = audio.getDeviceCount();
+    for (int i = 0; i < count; i++) {
+#endif
+        try {
+            info = audio.getDeviceInfo(i);
+#if !defined(RTAUDIO_VERSION_MAJOR) || RTAUDIO_VERSION_MAJOR < 6
+            if (!info.probed) { continue; }
+#endif
+            if (info.outputChannels == 0) { continue; }
+            if (info.isDefaultOutput) { defaultDevId = devList.size(); }
+            devList.push_back(info);
+            deviceIds.push_back(i);
+            txtDevList += info.name;
+            txtDevList += '\0';
+        }
+        catch (const std::exception& e) {
+            flog::error("AudioSinkModule Error getting audio device ({}) info: {}", i, e.what());
+        }
+    }
+}
+
 class AudioSink : SinkManager::Sink {
 public:
     AudioSink(SinkManager::Stream* stream, std::string streamName) {
@@ -29,7 +61,11 @@ public:
         _streamName = streamName;
         s2m.init(_stream->sinkOut);
         monoPacker.init(&s2m.out, 512);
-        stereoPacker.init(_stream->sinkOut, 512);
+        fifo.init(_stream->sinkOut, 512 * TARGET_LATENCY_BUFFERS);
+        fifo.setRealTime(sigpath::iqFrontEnd.isBuffering());
+        bufferingHandler.handler = bufferingChangedHandler;
+        bufferingHandler.ctx = this;
+        sigpath::iqFrontEnd.onBufferingChanged.bindHandler(&bufferingHandler);
 
 #if RTAUDIO_VERSION_MAJOR >= 6
         audio.setErrorCallback(&errorCallback);
@@ -46,34 +82,13 @@ public:
         device = config.conf[_streamName]["device"];
         config.release(created);
 
-        RtAudio::DeviceInfo info;
-#if RTAUDIO_VERSION_MAJOR >= 6
-        for (int i : audio.getDeviceIds()) {
-#else
-        int count = audio.getDeviceCount();
-        for (int i = 0; i < count; i++) {
-#endif
-            try {
-                info = audio.getDeviceInfo(i);
-#if !defined(RTAUDIO_VERSION_MAJOR) || RTAUDIO_VERSION_MAJOR < 6
-                if (!info.probed) { continue; }
-#endif
-                if (info.outputChannels == 0) { continue; }
-                if (info.isDefaultOutput) { defaultDevId = devList.size(); }
-                devList.push_back(info);
-                deviceIds.push_back(i);
-                txtDevList += info.name;
-                txtDevList += '\0';
-            }
-            catch (const std::exception& e) {
-                flog::error("AudioSinkModule Error getting audio device ({}) info: {}", i, e.what());
-            }
-        }
+        listOutputDevices(audio, devList, deviceIds, txtDevList, defaultDevId);
         selectByName(device);
     }
 
     ~AudioSink() {
         stop();
+        sigpath::iqFrontEnd.onBufferingChanged.unbindHandler(&bufferingHandler);
     }
 
     void start() {
@@ -194,9 +209,9 @@ private:
 
         try {
             audio.openStream(&parameters, NULL, RTAUDIO_FLOAT32, sampleRate, &bufferFrames, &callback, this, &opts);
-            stereoPacker.setSampleCount(bufferFrames);
+            fifo.setTargetFill(bufferFrames * TARGET_LATENCY_BUFFERS);
             audio.startStream();
-            stereoPacker.start();
+            fifo.start();
         }
         catch (const std::exception& e) {
             flog::error("Could not open audio device {0}", e.what());
@@ -210,29 +225,28 @@ private:
     void doStop() {
         s2m.stop();
         monoPacker.stop();
-        stereoPacker.stop();
-        monoPacker.out.stopReader();
-        stereoPacker.out.stopReader();
+        fifo.stop();
         audio.stopStream();
         audio.closeStream();
-        monoPacker.out.clearReadStop();
-        stereoPacker.out.clearReadStop();
+        if (fifo.dropped) { flog::warn("Audio sink '{}' dropped {} samples", _streamName, (int)fifo.dropped); }
+    }
+
+    static void bufferingChangedHandler(bool buffering, void* ctx) {
+        AudioSink* _this = (AudioSink*)ctx;
+        _this->fifo.setRealTime(buffering);
     }
 
     static int callback(void* outputBuffer, void* inputBuffer, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void* userData) {
         AudioSink* _this = (AudioSink*)userData;
-        int count = _this->stereoPacker.out.read();
-        if (count < 0) { return 0; }
-
-        memcpy(outputBuffer, _this->stereoPacker.out.readBuf, nBufferFrames * sizeof(dsp::stereo_t));
-        _this->stereoPacker.out.flush();
+        _this->fifo.read((dsp::stereo_t*)outputBuffer, nBufferFrames);
         return 0;
     }
 
     SinkManager::Stream* _stream;
     dsp::convert::StereoToMono s2m;
     dsp::buffer::Packer<float> monoPacker;
-    dsp::buffer::Packer<dsp::stereo_t> stereoPacker;
+    dsp::sink::AudioFIFO fifo;
+    EventHandler<bool> bufferingHandler;
 
     std::string _streamName;
 
@@ -254,6 +268,346 @@ private:
     RtAudio audio;
 };
 
+// Mixes any number of streams into a single output device
+class AudioMixer {
+public:
+    struct Input {
+        SinkManager::Stream* stream;
+        std::string name;
+        dsp::sink::AudioFIFO fifo;
+        float gain = 1.0f;
+        float pan = 0.0f;
+        bool muted = false;
+        std::atomic<float> gainL = 1.0f;
+        std::atomic<float> gainR = 1.0f;
+        std::atomic<bool> running = false;
+    };
+
+    AudioMixer() {
+#if RTAUDIO_VERSION_MAJOR >= 6
+        audio.setErrorCallback(&AudioSink::errorCallback);
+#endif
+        listOutputDevices(audio, devList, deviceIds, txtDevList, defaultDevId);
+        bufferingHandler.handler = bufferingChangedHandler;
+        bufferingHandler.ctx = this;
+        sigpath::iqFrontEnd.onBufferingChanged.bindHandler(&bufferingHandler);
+
+        bool created = false;
+        config.acquire();
+        if (!config.conf.contains("mixer")) {
+            created = true;
+            config.conf["mixer"]["device"] = "";
+            config.conf["mixer"]["devices"] = json({});
+            config.conf["mixer"]["inputs"] = json({});
+        }
+        std::string device = config.conf["mixer"]["device"];
+        config.release(created);
+
+        // Select the device
+        devId = defaultDevId;
+        for (int i = 0; i < devList.size(); i++) {
+            if (devList[i].name == device) {
+                devId = i;
+                break;
+            }
+        }
+        if (!devList.empty()) { selectDevice(devId); }
+    }
+
+    ~AudioMixer() {
+        sigpath::iqFrontEnd.onBufferingChanged.unbindHandler(&bufferingHandler);
+        closeDevice();
+        if (mixBuf) { dsp::buffer::free(mixBuf); }
+    }
+
+    Input* addInput(SinkManager::Stream* stream, std::string name) {
+        Input* in = new Input;
+        in->stream = stream;
+        in->name = name;
+        in->fifo.init(stream->sinkOut, 512 * TARGET_LATENCY_BUFFERS);
+        in->fifo.setRealTime(sigpath::iqFrontEnd.isBuffering());
+        stream->setSampleRate(sampleRate);
+
+        // Load the mixing parameters
+        config.acquire();
+        if (config.conf["mixer"]["inputs"].contains(name)) {
+            in->gain = config.conf["mixer"]["inputs"][name]["gain"];
+            in->pan = config.conf["mixer"]["inputs"][name]["pan"];
+            in->muted = config.conf["mixer"]["inputs"][name]["muted"];
+        }
+        config.release();
+        updateGains(in);
+
+        std::lock_guard<std::mutex> lck(inputMtx);
+        inputs.push_back(in);
+        return in;
+    }
+
+    void removeInput(Input* in) {
+        stopInput(in);
+        {
+            std::lock_guard<std::mutex> lck(inputMtx);
+            inputs.erase(std::find(inputs.begin(), inputs.end(), in));
+        }
+        delete in;
+    }
+
+    void startInput(Input* in) {
+        if (in->running) { return; }
+        in->fifo.reset();
+        in->fifo.start();
+        in->running = true;
+        if (!deviceOpen) { openDevice(); }
+    }
+
+    void stopInput(Input* in) {
+        if (!in->running) { return; }
+
+        // Taking the lock guarantees that the callback isn't reading from the input anymore
+        {
+            std::lock_guard<std::mutex> lck(inputMtx);
+            in->running = false;
+        }
+        in->fifo.stop();
+        if (in->fifo.dropped) { flog::warn("Audio mixer input '{}' dropped {} samples", in->name, (int)in->fifo.dropped); }
+
+        // Close the device once nothing plays on it
+        for (const auto& i : inputs) {
+            if (i->running) { return; }
+        }
+        closeDevice();
+    }
+
+    void menuHandler(Input* in) {
+        float menuWidth = ImGui::GetContentRegionAvail().x;
+
+        ImGui::SetNextItemWidth(menuWidth);
+        if (ImGui::Combo(("##_audio_mixer_dev_" + in->name).c_str(), &devId, txtDevList.c_str())) {
+            selectDevice(devId);
+            config.acquire();
+            config.conf["mixer"]["device"] = devList[devId].name;
+            config.release(true);
+        }
+
+        ImGui::SetNextItemWidth(menuWidth);
+        if (ImGui::Combo(("##_audio_mixer_sr_" + in->name).c_str(), &srId, sampleRatesTxt.c_str())) {
+            setSampleRate(sampleRates[srId]);
+            config.acquire();
+            config.conf["mixer"]["devices"][devList[devId].name] = sampleRate;
+            config.release(true);
+        }
+
+        // Mixing parameters of this stream
+        bool changed = false;
+        ImGui::LeftLabel("Gain");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        changed |= ImGui::SliderFloat(("##_audio_mixer_gain_" + in->name).c_str(), &in->gain, 0.0f, 2.0f);
+        ImGui::LeftLabel("Pan");
+        ImGui::SetNextItemWidth(menuWidth - ImGui::GetCursorPosX());
+        changed |= ImGui::SliderFloat(("##_audio_mixer_pan_" + in->name).c_str(), &in->pan, -1.0f, 1.0f);
+        changed |= ImGui::Checkbox(("Mute##_audio_mixer_mute_" + in->name).c_str(), &in->muted);
+        if (changed) {
+            updateGains(in);
+            config.acquire();
+            config.conf["mixer"]["inputs"][in->name]["gain"] = in->gain;
+            config.conf["mixer"]["inputs"][in->name]["pan"] = in->pan;
+            config.conf["mixer"]["inputs"][in->name]["muted"] = in->muted;
+            config.release(true);
+        }
+    }
+
+private:
+    void selectDevice(int id) {
+        devId = id;
+        bool created = false;
+        config.acquire();
+        if (!config.conf["mixer"]["devices"].contains(devList[id].name)) {
+            created = true;
+            config.conf["mixer"]["devices"][devList[id].name] = devList[id].preferredSampleRate;
+        }
+        unsigned int sr = config.conf["mixer"]["devices"][devList[id].name];
+        config.release(created);
+
+        sampleRates = devList[id].sampleRates;
+        sampleRatesTxt = "";
+        char buf[256];
+        bool found = false;
+        unsigned int defaultId = 0;
+        unsigned int defaultSr = devList[id].preferredSampleRate;
+        for (int i = 0; i < sampleRates.size(); i++) {
+            if (sampleRates[i] == sr) {
+                found = true;
+                srId = i;
+            }
+            if (sampleRates[i] == defaultSr) {
+                defaultId = i;
+            }
+            sprintf(buf, "%d", sampleRates[i]);
+            sampleRatesTxt += buf;
+            sampleRatesTxt += '\0';
+        }
+        if (!found) {
+            sr = defaultSr;
+            srId = defaultId;
+        }
+
+        setSampleRate(sr);
+    }
+
+    void setSampleRate(unsigned int sr) {
+        // Every stream is resampled by its source to the rate of the device
+        sampleRate = sr;
+        for (auto& in : inputs) {
+            in->stream->setSampleRate(sampleRate);
+        }
+
+        if (deviceOpen) {
+            closeDevice();
+            openDevice();
+        }
+    }
+
+    void openDevice() {
+        if (devList.empty()) { return; }
+        RtAudio::StreamParameters parameters;
+        parameters.deviceId = deviceIds[devId];
+        parameters.nChannels = 2;
+        unsigned int bufferFrames = sampleRate / 60;
+        RtAudio::StreamOptions opts;
+        opts.flags = RTAUDIO_MINIMIZE_LATENCY;
+        opts.streamName = "Mixer";
+
+        try {
+            audio.openStream(&parameters, NULL, RTAUDIO_FLOAT32, sampleRate, &bufferFrames, &callback, this, &opts);
+
+            // The FIFOs are resized for the actual buffer size, the callback isn't running yet
+            if (mixBuf) { dsp::buffer::free(mixBuf); }
+            mixBuf = dsp::buffer::alloc<dsp::stereo_t>(bufferFrames);
+            mixBufSize = bufferFrames;
+            for (auto& in : inputs) {
+                in->fifo.setTargetFill(bufferFrames * TARGET_LATENCY_BUFFERS);
+            }
+
+            audio.startStream();
+        }
+        catch (const std::exception& e) {
+            flog::error("Could not open audio device {0}", e.what());
+            return;
+        }
+
+        deviceOpen = true;
+        flog::info("RtAudio mixer stream open");
+    }
+
+    void closeDevice() {
+        if (!deviceOpen) { return; }
+        audio.stopStream();
+        audio.closeStream();
+        deviceOpen = false;
+    }
+
+    static void bufferingChangedHandler(bool buffering, void* ctx) {
+        AudioMixer* _this = (AudioMixer*)ctx;
+        std::lock_guard<std::mutex> lck(_this->inputMtx);
+        for (auto& in : _this->inputs) {
+            in->fifo.setRealTime(buffering);
+        }
+    }
+
+    void updateGains(Input* in) {
+        float gain = in->muted ? 0.0f : in->gain;
+        in->gainL = gain * std::min<float>(1.0f, 1.0f - in->pan);
+        in->gainR = gain * std::min<float>(1.0f, 1.0f + in->pan);
+    }
+
+    static int callback(void* outputBuffer, void* inputBuffer, unsigned int nBufferFrames, double streamTime, RtAudioStreamStatus status, void* userData) {
+        AudioMixer* _this = (AudioMixer*)userData;
+        float* out = (float*)outputBuffer;
+        memset(out, 0, nBufferFrames * sizeof(dsp::stereo_t));
+
+        // Inputs are only added or removed from the UI, output silence instead of waiting for it
+        std::unique_lock<std::mutex> lck(_this->inputMtx, std::try_to_lock);
+        if (!lck.owns_lock()) { return 0; }
+
+        for (int offset = 0; offset < nBufferFrames; offset += _this->mixBufSize) {
+            int count = std::min<int>(nBufferFrames - offset, _this->mixBufSize);
+            float* dst = &out[offset * 2];
+            float* src = (float*)_this->mixBuf;
+            for (auto& in : _this->inputs) {
+                if (!in->running) { continue; }
+
+                // Muted inputs are still read so that their FIFO keeps draining
+                in->fifo.read(_this->mixBuf, count);
+                float gl = in->gainL;
+                float gr = in->gainR;
+                if (gl == 0.0f && gr == 0.0f) { continue; }
+
+                // Apply gain and pan, then sum the interleaved samples
+                if (gl == gr) {
+                    if (gl != 1.0f) { volk_32f_s32f_multiply_32f(src, src, gl, count * 2); }
+                }
+                else {
+                    for (int i = 0; i < count; i++) {
+                        src[2 * i] *= gl;
+                        src[2 * i + 1] *= gr;
+                    }
+                }
+                volk_32f_x2_add_32f(dst, dst, src, count * 2);
+            }
+        }
+
+        return 0;
+    }
+
+    std::mutex inputMtx;
+    std::vector<Input*> inputs;
+    EventHandler<bool> bufferingHandler;
+
+    dsp::stereo_t* mixBuf = NULL;
+    int mixBufSize = 0;
+    bool deviceOpen = false;
+
+    int srId = 0;
+    int devId = 0;
+    unsigned int defaultDevId = 0;
+    std::vector<RtAudio::DeviceInfo> devList;
+    std::vector<unsigned int> deviceIds;
+    std::string txtDevList;
+    std::vector<unsigned int> sampleRates;
+    std::string sampleRatesTxt;
+    unsigned int sampleRate = 48000;
+
+    RtAudio audio;
+};
+
+class MixerSink : SinkManager::Sink {
+public:
+    MixerSink(AudioMixer* mixer, SinkManager::Stream* stream, std::string streamName) {
+        _mixer = mixer;
+        input = _mixer->addInput(stream, streamName);
+    }
+
+    ~MixerSink() {
+        _mixer->removeInput(input);
+    }
+
+    void start() {
+        _mixer->startInput(input);
+    }
+
+    void stop() {
+        _mixer->stopInput(input);
+    }
+
+    void menuHandler() {
+        _mixer->menuHandler(input);
+    }
+
+private:
+    AudioMixer* _mixer;
+    AudioMixer::Input* input;
+};
+
 class AudioSinkModule : public ModuleManager::Instance {
 public:
     AudioSinkModule(std::string name) {
@@ -262,11 +616,16 @@ public:
         provider.ctx = this;
 
         sigpath::sinkManager.registerSinkProvider("Audio", provider);
+
+        mixerProvider.create = create_mixer_sink;
+        mixerProvider.ctx = this;
+        sigpath::sinkManager.registerSinkProvider("Audio Mixer", mixerProvider);
     }
 
     ~AudioSinkModule() {
         // Unregister sink, this will automatically stop and delete all instances of the audio sink
         sigpath::sinkManager.unregisterSinkProvider("Audio");
+        sigpath::sinkManager.unregisterSinkProvider("Audio Mixer");
     }
 
     void postInit() {}
@@ -288,9 +647,16 @@ private:
         return (SinkManager::Sink*)(new AudioSink(stream, streamName));
     }
 
+    static SinkManager::Sink* create_mixer_sink(SinkManager::Stream* stream, std::string streamName, void* ctx) {
+        AudioSinkModule* _this = (AudioSinkModule*)ctx;
+        return (SinkManager::Sink*)(new MixerSink(&_this->mixer, stream, streamName));
+    }
+
     std::string name;
     bool enabled = true;
     SinkManager::SinkProvider provider;
+    SinkManager::SinkProvider mixerProvider;
+    AudioMixer mixer;
 };
 
 MOD_EXPORT void _INIT_() {
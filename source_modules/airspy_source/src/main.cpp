@@ -42,17 +42,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
-
-        refresh();
-        if (sampleRateList.size() > 0) {
-            sampleRate = sampleRateList[0];
-        }
-
-        // Select device from config
-        config.acquire();
-        std::string devSerial = config.conf["device"];
-        config.release();
-        selectByString(devSerial);
+        handler.enumerateHandler = enumerate;
 
         sigpath::sourceManager.registerSource("Airspy", &handler);
     }
@@ -246,6 +236,20 @@ private:
         return std::string(buf);
     }
 
+    static void enumerate(void* ctx) {
+        AirspySourceModule* _this = (AirspySourceModule*)ctx;
+        _this->refresh();
+        if (_this->sampleRateList.size() > 0) {
+            _this->sampleRate = _this->sampleRateList[0];
+        }
+
+        // Select device from config
+        config.acquire();
+        std::string devSerial = config.conf["device"];
+        config.release();
+        _this->selectByString(devSerial);
+    }
+
     static void menuSelected(void* ctx) {
         AirspySourceModule* _this = (AirspySourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
@@ -42,13 +42,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
-
-        refresh();
-
-        config.acquire();
-        std::string devSerial = config.conf["device"];
-        config.release();
-        selectByString(devSerial);
+        handler.enumerateHandler = enumerate;
 
         sigpath::sourceManager.registerSource("Airspy HF+", &handler);
     }
@@ -224,6 +218,16 @@ private:
         return std::string(buf);
     }
 
+    static void enumerate(void* ctx) {
+        AirspyHFSourceModule* _this = (AirspyHFSourceModule*)ctx;
+        _this->refresh();
+
+        config.acquire();
+        std::string devSerial = config.conf["device"];
+        config.release();
+        _this->selectByString(devSerial);
+    }
+
     static void menuSelected(void* ctx) {
         AirspyHFSourceModule* _this = (AirspyHFSourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
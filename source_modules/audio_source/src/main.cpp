@@ -49,19 +49,8 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
+        handler.enumerateHandler = enumerate;
 
-        // Refresh devices
-        refresh();
-
-        // Select device
-        std::string device = "";
-        config.acquire();
-        if (config.conf.contains("device")) {
-            device = config.conf["device"];
-        }
-        config.release();
-        select(device);
-        
         sigpath::sourceManager.registerSource("Audio", &handler);
     }
 
@@ -169,6 +158,21 @@ private:
         return std::string(buf);
     }
 
+    static void enumerate(void* ctx) {
+        AudioSourceModule* _this = (AudioSourceModule*)ctx;
+        // Refresh devices
+        _this->refresh();
+
+        // Select device
+        std::string device = "";
+        config.acquire();
+        if (config.conf.contains("device")) {
+            device = config.conf["device"];
+        }
+        config.release();
+        _this->select(device);
+    }
+
     static void menuSelected(void* ctx) {
         AudioSourceModule* _this = (AudioSourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
@@ -52,14 +52,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
-
-        refresh();
-
-        // Select device here
-        config.acquire();
-        std::string serial = config.conf["device"];
-        config.release();
-        selectBySerial(serial);
+        handler.enumerateHandler = enumerate;
 
         sigpath::sourceManager.registerSource("BladeRF", &handler);
     }
@@ -347,6 +340,17 @@ private:
         return std::string(buf);
     }
 
+    static void enumerate(void* ctx) {
+        BladeRFSourceModule* _this = (BladeRFSourceModule*)ctx;
+        _this->refresh();
+
+        // Select device here
+        config.acquire();
+        std::string serial = config.conf["device"];
+        config.release();
+        _this->selectBySerial(serial);
+    }
+
     static void menuSelected(void* ctx) {
         BladeRFSourceModule* _this = (BladeRFSourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
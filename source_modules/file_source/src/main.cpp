@@ -45,6 +45,14 @@ public:
         handler.tuneHandler = tune;
         handler.stream = &stream;
         sigpath::sourceManager.registerSource("File", &handler);
+
+        // In offline mode, the file comes from the command line and is played only once
+        std::string offlinePath = core::args["offline"].s();
+        if (!offlinePath.empty()) {
+            offline = true;
+            openFile(offlinePath);
+            if (reader) { float32Mode = (reader->getBitDepth() == 32); }
+        }
     }
 
     ~FileSourceModule() {
@@ -91,6 +99,7 @@ private:
         FileSourceModule* _this = (FileSourceModule*)ctx;
         if (_this->running) { return; }
         if (_this->reader == NULL) { return; }
+        _this->stream.clearEndOfStream();
         _this->running = true;
         _this->workerThread = _this->float32Mode ? std::thread(floatWorker, _this) : std::thread(worker, _this);
         flog::info("FileSourceModule '{0}': Start!", _this->name);
@@ -118,30 +127,13 @@ private:
 
         if (_this->fileSelect.render("##file_source_" + _this->name)) {
             if (_this->fileSelect.pathIsValid()) {
-                if (_this->reader != NULL) {
-                    _this->reader->close();
-                    delete _this->reader;
-                }
-                try {
-                    _this->reader = new WavReader(_this->fileSelect.path);
-                    if (_this->reader->getSampleRate() == 0) {
-                        _this->reader->close();
-                        delete _this->reader;
-                        _this->reader = NULL;
-                        throw std::runtime_error("Sample rate may not be zero");
-                    }
-                    _this->sampleRate = _this->reader->getSampleRate();
+                if (_this->openFile(_this->fileSelect.path)) {
                     core::setInputSampleRate(_this->sampleRate);
-                    std::string filename = std::filesystem::path(_this->fileSelect.path).filename().string();
-                    _this->centerFreq = _this->getFrequency(filename);
                     tuner::tune(tuner::TUNER_MODE_IQ_ONLY, "", _this->centerFreq);
                     //gui::freqSelect.minFreq = _this->centerFreq - (_this->sampleRate/2);
                     //gui::freqSelect.maxFreq = _this->centerFreq + (_this->sampleRate/2);
                     //gui::freqSelect.limitFreq = true;
                 }
-                catch (const std::exception& e) {
-                    flog::error("Error: {}", e.what());
-                }
                 config.acquire();
                 config.conf["path"] = _this->fileSelect.path;
                 config.release(true);
@@ -158,9 +150,15 @@ private:
         int16_t* inBuf = new int16_t[blockSize * 2];
 
         while (true) {
-            _this->reader->readSamples(inBuf, blockSize * 2 * sizeof(int16_t));
-            volk_16i_s32f_convert_32f((float*)_this->stream.writeBuf, inBuf, 32768.0f, blockSize * 2);
-            if (!_this->stream.swap(blockSize)) { break; };
+            int count = _this->reader->readSamples(inBuf, blockSize * 2 * sizeof(int16_t), !_this->offline) / (2 * sizeof(int16_t));
+            volk_16i_s32f_convert_32f((float*)_this->stream.writeBuf, inBuf, 32768.0f, count * 2);
+            if (count && !_this->stream.swap(count)) { break; };
+
+            // Looped files always fill the block, so this is either the end of the file in offline mode or a file without samples
+            if (count < blockSize) {
+                if (_this->offline) { _this->stream.setEndOfStream(); }
+                break;
+            }
         }
 
         delete[] inBuf;
@@ -173,13 +171,44 @@ private:
         dsp::complex_t* inBuf = new dsp::complex_t[blockSize];
 
         while (true) {
-            _this->reader->readSamples(_this->stream.writeBuf, blockSize * sizeof(dsp::complex_t));
-            if (!_this->stream.swap(blockSize)) { break; };
+            int count = _this->reader->readSamples(_this->stream.writeBuf, blockSize * sizeof(dsp::complex_t), !_this->offline) / sizeof(dsp::complex_t);
+            if (count && !_this->stream.swap(count)) { break; };
+
+            // Looped files always fill the block, so this is either the end of the file in offline mode or a file without samples
+            if (count < blockSize) {
+                if (_this->offline) { _this->stream.setEndOfStream(); }
+                break;
+            }
         }
 
         delete[] inBuf;
     }
 
+    bool openFile(const std::string& path) {
+        if (reader != NULL) {
+            reader->close();
+            delete reader;
+            reader = NULL;
+        }
+        try {
+            reader = new WavReader(path);
+            if (reader->getSampleRate() == 0) {
+                reader->close();
+                delete reader;
+                reader = NULL;
+                throw std::runtime_error("Sample rate may not be zero");
+            }
+            sampleRate = reader->getSampleRate();
+            std::string filename = std::filesystem::path(path).filename().string();
+            centerFreq = getFrequency(filename);
+        }
+        catch (const std::exception& e) {
+            flog::error("Error: {}", e.what());
+            return false;
+        }
+        return true;
+    }
+
     double getFrequency(std::string filename) {
         std::regex expr("[0-9]+Hz");
         std::smatch matches;
@@ -202,6 +231,7 @@ private:
     double centerFreq = 100000000;
 
     bool float32Mode = false;
+    bool offline = false;
 };
 
 MOD_EXPORT void _INIT_() {
@@ -38,19 +38,26 @@ public:
         return valid;
     }
 
-    void readSamples(void* data, size_t size) {
+    size_t readSamples(void* data, size_t size, bool loop = true) {
         char* _data = (char*)data;
         file.read(_data, size);
-        int read = file.gcount();
-        if (read < size) {
+        size_t read = file.gcount();
+
+        // Files shorter than the requested size are looped as many times as needed
+        while (read < size && loop) {
             file.clear();
             file.seekg(sizeof(WavHeader_t));
             file.read(&_data[read], size - read);
+            size_t count = file.gcount();
+            if (!count) { break; }
+            read += count;
         }
-        bytesRead += size;
+        bytesRead += read;
+        return read;
     }
 
     void rewind() {
+        file.clear();
         file.seekg(sizeof(WavHeader_t));
     }
 
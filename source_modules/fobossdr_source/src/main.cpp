@@ -44,21 +44,14 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &ddc.out;
-
-        // Refresh devices
-        refresh();
-
-        // Select device from config
-        config.acquire();
-        std::string devSerial = config.conf["device"];
-        config.release();
-        select(devSerial);
+        handler.enumerateHandler = enumerate;
 
         sigpath::sourceManager.registerSource("FobosSDR", &handler);
     }
 
     ~FobosSDRSourceModule() {
-        // Nothing to do
+        stop(this);
+        sigpath::sourceManager.unregisterSource("FobosSDR");
     }
 
     void postInit() {}
@@ -240,6 +233,18 @@ private:
         core::setInputSampleRate(sampleRate);
     }
 
+    static void enumerate(void* ctx) {
+        FobosSDRSourceModule* _this = (FobosSDRSourceModule*)ctx;
+        // Refresh devices
+        _this->refresh();
+
+        // Select device from config
+        config.acquire();
+        std::string devSerial = config.conf["device"];
+        config.release();
+        _this->select(devSerial);
+    }
+
     static void menuSelected(void* ctx) {
         FobosSDRSourceModule* _this = (FobosSDRSourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
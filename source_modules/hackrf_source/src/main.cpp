@@ -97,21 +97,15 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
-
-        refresh();
-
-        config.acquire();
-        std::string confSerial = config.conf["device"];
-        config.release();
-        selectBySerial(confSerial);
+        handler.enumerateHandler = enumerate;
 
         sigpath::sourceManager.registerSource("HackRF", &handler);
     }
 
     ~HackRFSourceModule() {
         stop(this);
-        hackrf_exit();
         sigpath::sourceManager.unregisterSource("HackRF");
+        hackrf_exit();
     }
 
     void postInit() {}
@@ -224,6 +218,16 @@ public:
     }
 
 private:
+    static void enumerate(void* ctx) {
+        HackRFSourceModule* _this = (HackRFSourceModule*)ctx;
+        _this->refresh();
+
+        config.acquire();
+        std::string confSerial = config.conf["device"];
+        config.release();
+        _this->selectBySerial(confSerial);
+    }
+
     static void menuSelected(void* ctx) {
         HackRFSourceModule* _this = (HackRFSourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
@@ -33,18 +33,14 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
-
-        // Refresh devices
-        refresh();
-
-        // Select first (TODO: Select from config)
-        select("");
+        handler.enumerateHandler = enumerate;
 
         sigpath::sourceManager.registerSource("Harogic", &handler);
     }
 
     ~HarogicSourceModule() {
-        
+        stop(this);
+        sigpath::sourceManager.unregisterSource("Harogic");
     }
 
     void postInit() {}
@@ -182,6 +178,15 @@ private:
         selectedSerial = serial;
     }
 
+    static void enumerate(void* ctx) {
+        HarogicSourceModule* _this = (HarogicSourceModule*)ctx;
+        // Refresh devices
+        _this->refresh();
+
+        // Select first (TODO: Select from config)
+        _this->select("");
+    }
+
     static void menuSelected(void* ctx) {
         HarogicSourceModule* _this = (HarogicSourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
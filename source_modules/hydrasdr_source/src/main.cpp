@@ -49,14 +49,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
-
-        refresh();
-
-        // Select device from config
-        config.acquire();
-        std::string devSerial = config.conf["device"];
-        config.release();
-        selectByString(devSerial);
+        handler.enumerateHandler = enumerate;
 
         sigpath::sourceManager.registerSource("HydraSDR", &handler);
     }
@@ -241,6 +234,17 @@ private:
         return std::string(buf);
     }
 
+    static void enumerate(void* ctx) {
+        HydraSDRSourceModule* _this = (HydraSDRSourceModule*)ctx;
+        _this->refresh();
+
+        // Select device from config
+        config.acquire();
+        std::string devSerial = config.conf["device"];
+        config.release();
+        _this->selectByString(devSerial);
+    }
+
     static void menuSelected(void* ctx) {
         HydraSDRSourceModule* _this = (HydraSDRSourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
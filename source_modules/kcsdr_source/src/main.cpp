@@ -41,18 +41,14 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
-
-        // Refresh devices
-        refresh();
-
-        // Select first (TODO: Select from config)
-        select("");
+        handler.enumerateHandler = enumerate;
 
         sigpath::sourceManager.registerSource("KCSDR", &handler);
     }
 
     ~KCSDRSourceModule() {
-        
+        stop(this);
+        sigpath::sourceManager.unregisterSource("KCSDR");
     }
 
     void postInit() {}
@@ -115,6 +111,15 @@ private:
         selectedSerial = serial;
     }
 
+    static void enumerate(void* ctx) {
+        KCSDRSourceModule* _this = (KCSDRSourceModule*)ctx;
+        // Refresh devices
+        _this->refresh();
+
+        // Select first (TODO: Select from config)
+        _this->select("");
+    }
+
     static void menuSelected(void* ctx) {
         KCSDRSourceModule* _this = (KCSDRSourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
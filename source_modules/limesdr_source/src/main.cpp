@@ -38,11 +38,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
-
-        refresh();
-
-        // Select device from config
-        selectFirst();
+        handler.enumerateHandler = enumerate;
 
         sigpath::sourceManager.registerSource("LimeSDR", &handler);
     }
@@ -305,6 +301,14 @@ private:
         return bandwidths[bandwidths.size() - 1];
     }
 
+    static void enumerate(void* ctx) {
+        LimeSDRSourceModule* _this = (LimeSDRSourceModule*)ctx;
+        _this->refresh();
+
+        // Select device from config
+        _this->selectFirst();
+    }
+
     static void menuSelected(void* ctx) {
         LimeSDRSourceModule* _this = (LimeSDRSourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
@@ -39,16 +39,10 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
+        handler.enumerateHandler = enumerate;
 
         perseus_set_debug(9);
 
-        refresh();
-
-        config.acquire();
-        std::string serial = config.conf["device"];
-        config.release();
-        select(serial);
-
         sigpath::sourceManager.registerSource("Perseus", &handler);
     }
 
@@ -230,6 +224,16 @@ private:
         return std::string(buf);
     }
 
+    static void enumerate(void* ctx) {
+        PerseusSourceModule* _this = (PerseusSourceModule*)ctx;
+        _this->refresh();
+
+        config.acquire();
+        std::string serial = config.conf["device"];
+        config.release();
+        _this->select(serial);
+    }
+
     static void menuSelected(void* ctx) {
         PerseusSourceModule* _this = (PerseusSourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
@@ -10,9 +10,25 @@
 #include <utils/optionlist.h>
 #include <algorithm>
 #include <regex>
+#include <deque>
+#include <condition_variable>
+#include <atomic>
 
 #define CONCAT(a, b) ((std::string(a) + b).c_str())
 
+// Number of buffers queued by the kernel, lets the device keep streaming while a buffer is being read
+#define PLUTOSDR_KERNEL_BUFFERS     4
+
+// Number of raw blocks waiting for conversion before the receive thread starts dropping samples
+#define PLUTOSDR_QUEUE_BLOCKS       16
+
+// Number of blocks between two checks of the overflow flag, reading it costs a round trip to the device
+#define PLUTOSDR_OVERFLOW_CHECK     20
+
+// Status register of the ADI ADC core, the overflow bit is cleared by writing it back
+#define ADI_STATUS_REG              0x80000088
+#define ADI_STATUS_OVERFLOW         (1 << 2)
+
 SDRPP_MOD_INFO{
     /* Name:            */ "plutosdr_source",
     /* Description:     */ "PlutoSDR source module for SDR++",
@@ -52,15 +68,6 @@ public:
         gainModes.define("slow_attack", "Slow Attack", "slow_attack");
         gainModes.define("hybrid", "Hybrid", "hybrid");
 
-        // Enumerate devices
-        refresh();
-
-        // Select device
-        config.acquire();
-        devDesc = config.conf["device"];
-        config.release();
-        select(devDesc);
-
         // Register source
         handler.ctx = this;
         handler.selectHandler = menuSelected;
@@ -70,6 +77,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
+        handler.enumerateHandler = enumerate;
         sigpath::sourceManager.registerSource("PlutoSDR", &handler);
     }
 
@@ -262,6 +270,18 @@ private:
         }
     }
 
+    static void enumerate(void* ctx) {
+        PlutoSDRSourceModule* _this = (PlutoSDRSourceModule*)ctx;
+        // Enumerate devices
+        _this->refresh();
+
+        // Select device
+        config.acquire();
+        _this->devDesc = config.conf["device"];
+        config.release();
+        _this->select(_this->devDesc);
+    }
+
     static void menuSelected(void* ctx) {
         PlutoSDRSourceModule* _this = (PlutoSDRSourceModule*)ctx;
         core::setInputSampleRate(_this->samplerate);
@@ -321,22 +341,90 @@ private:
         // Configure the ADC filters
         ad9361_set_bb_rate(_this->phy, round(_this->samplerate));
 
-        // Start worker thread
+        // Acquire channels
+        _this->rxI = iio_device_find_channel(_this->dev, "voltage0", 0);
+        _this->rxQ = iio_device_find_channel(_this->dev, "voltage1", 0);
+        if (!_this->rxI || !_this->rxQ) {
+            flog::error("Failed to acquire RX channels");
+            iio_context_destroy(_this->ctx);
+            _this->ctx = NULL;
+            return;
+        }
+
+        // Start streaming
+        iio_channel_enable(_this->rxI);
+        iio_channel_enable(_this->rxQ);
+
+        // Let the kernel queue several buffers so that no samples are lost while one is transferred
+        if (iio_device_set_kernel_buffers_count(_this->dev, PLUTOSDR_KERNEL_BUFFERS) < 0) {
+            flog::warn("Could not set the number of kernel buffers of the pluto");
+        }
+
+        // Allocate buffer
+        _this->blockSize = _this->samplerate / 200.0f;
+        _this->rxbuf = iio_device_create_buffer(_this->dev, _this->blockSize, false);
+        if (!_this->rxbuf) {
+            flog::error("Could not create RX buffer");
+            iio_channel_disable(_this->rxI);
+            iio_channel_disable(_this->rxQ);
+            iio_context_destroy(_this->ctx);
+            _this->ctx = NULL;
+            return;
+        }
+
+        // 8-bit transfers are never requested since stock firmware has no way to do it. Only custom firmwares
+        // that already expose 8-bit channels use them, everything else is 16-bit.
+        const iio_data_format* fmt = iio_channel_get_data_format(_this->rxI);
+        _this->sampleBits = (fmt && fmt->length == 8) ? 8 : 16;
+        _this->sampleStep = iio_buffer_step(_this->rxbuf);
+
+        // Allocate the raw blocks passed to the conversion thread
+        for (int i = 0; i < PLUTOSDR_QUEUE_BLOCKS; i++) {
+            _this->freeBlocks.push_back(new uint8_t[_this->blockSize * _this->sampleStep]);
+        }
+
+        // Clear a stale overflow flag
+        _this->checkOverflow();
+        _this->overflows = 0;
+        _this->dropped = 0;
+        _this->streamFailed = false;
+
+        // Start worker threads
+        _this->run = true;
         _this->running = true;
         _this->workerThread = std::thread(worker, _this);
-        flog::info("PlutoSDRSourceModule '{0}': Start!", _this->name);
+        _this->convThread = std::thread(converter, _this);
+        flog::info("PlutoSDRSourceModule '{0}': Start! ({1}-bit samples)", _this->name, _this->sampleBits);
     }
 
     static void stop(void* ctx) {
         PlutoSDRSourceModule* _this = (PlutoSDRSourceModule*)ctx;
         if (!_this->running) { return; }
 
-        // Stop worker thread
+        // Stop worker threads
         _this->running = false;
+        {
+            std::lock_guard<std::mutex> lck(_this->queueMtx);
+            _this->run = false;
+        }
+        _this->queueCnd.notify_all();
         _this->stream.stopWriter();
-        _this->workerThread.join();
+        if (_this->workerThread.joinable()) { _this->workerThread.join(); }
+        if (_this->convThread.joinable()) { _this->convThread.join(); }
         _this->stream.clearWriteStop();
 
+        // Stop streaming
+        iio_buffer_destroy(_this->rxbuf);
+        _this->rxbuf = NULL;
+        iio_channel_disable(_this->rxI);
+        iio_channel_disable(_this->rxQ);
+
+        // Free the raw blocks
+        for (auto& block : _this->readyBlocks) { _this->freeBlocks.push_back(block.data); }
+        _this->readyBlocks.clear();
+        for (auto& data : _this->freeBlocks) { delete[] data; }
+        _this->freeBlocks.clear();
+
         // Close device
         if (_this->ctx != NULL) {
             iio_context_destroy(_this->ctx);
@@ -433,6 +521,19 @@ private:
             }
         }
         if (_this->gmId) { SmGui::EndDisabled(); }
+
+        // Stream info
+        if (_this->running) {
+            SmGui::LeftLabel("Samples");
+            SmGui::Text((_this->sampleBits == 8) ? "8-bit" : "16-bit");
+            SmGui::LeftLabel("Overflows");
+            SmGui::Text(std::to_string(_this->overflows).c_str());
+            SmGui::LeftLabel("Dropped");
+            SmGui::Text(std::to_string(_this->dropped).c_str());
+        }
+        if (_this->streamFailed) {
+            SmGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Lost connection to the pluto");
+        }
     }
 
     void setBandwidth(int bw) {
@@ -444,53 +545,108 @@ private:
         }
     }
 
+    void checkOverflow() {
+        uint32_t status;
+        if (iio_device_reg_read(dev, ADI_STATUS_REG, &status) < 0) { return; }
+        if (status & ADI_STATUS_OVERFLOW) {
+            overflows++;
+            iio_device_reg_write(dev, ADI_STATUS_REG, ADI_STATUS_OVERFLOW);
+        }
+    }
+
     static void worker(void* ctx) {
         PlutoSDRSourceModule* _this = (PlutoSDRSourceModule*)ctx;
-        int blockSize = _this->samplerate / 200.0f;
+        int blockBytes = _this->blockSize * _this->sampleStep;
+        int checkCounter = 0;
 
-        // Acquire channels
-        iio_channel* rx0_i = iio_device_find_channel(_this->dev, "voltage0", 0);
-        iio_channel* rx0_q = iio_device_find_channel(_this->dev, "voltage1", 0);
-        if (!rx0_i || !rx0_q) {
-            flog::error("Failed to acquire RX channels");
-            return;
-        }
+        // Receive loop, never waits on the DSP so that the device is always read in time
+        while (_this->run) {
+            // Read samples
+            if (iio_buffer_refill(_this->rxbuf) < 0) {
+                flog::error("Failed to receive samples from the pluto");
+                _this->streamFailed = true;
+
+                // Wake up the conversion thread and have the UI stop the source, which cleans up
+                {
+                    std::lock_guard<std::mutex> lck(_this->queueMtx);
+                    _this->run = false;
+                }
+                _this->queueCnd.notify_all();
+                sigpath::sourceManager.requestStop();
+                break;
+            }
 
-        // Start streaming
-        iio_channel_enable(rx0_i);
-        iio_channel_enable(rx0_q);
+            // Check if the device lost samples
+            if (++checkCounter >= PLUTOSDR_OVERFLOW_CHECK) {
+                checkCounter = 0;
+                _this->checkOverflow();
+            }
 
-        // Allocate buffer
-        iio_buffer* rxbuf = iio_device_create_buffer(_this->dev, blockSize, false);
-        if (!rxbuf) {
-            flog::error("Could not create RX buffer");
-            return;
+            // Get a free block, drop the samples if the conversion thread can't keep up
+            RawBlock block;
+            {
+                std::lock_guard<std::mutex> lck(_this->queueMtx);
+                if (_this->freeBlocks.empty()) {
+                    _this->dropped++;
+                    continue;
+                }
+                block.data = _this->freeBlocks.back();
+                _this->freeBlocks.pop_back();
+            }
+
+            // Copy the samples out, the buffer is reused by the next refill
+            uint8_t* first = (uint8_t*)iio_buffer_first(_this->rxbuf, _this->rxI);
+            uint8_t* end = (uint8_t*)iio_buffer_end(_this->rxbuf);
+            int bytes = std::min<int>(end - first, blockBytes);
+            memcpy(block.data, first, bytes);
+            block.count = bytes / _this->sampleStep;
+
+            // Hand it over to the conversion thread
+            {
+                std::lock_guard<std::mutex> lck(_this->queueMtx);
+                _this->readyBlocks.push_back(block);
+            }
+            _this->queueCnd.notify_one();
         }
+    }
 
-        // Receive loop
+    static void converter(void* ctx) {
+        PlutoSDRSourceModule* _this = (PlutoSDRSourceModule*)ctx;
         while (true) {
-            // Read samples
-            iio_buffer_refill(rxbuf);
-
-            // Get buffer pointer
-            int16_t* buf = (int16_t*)iio_buffer_first(rxbuf, rx0_i);
-            if (!buf) { break; }
+            // Wait for a block
+            RawBlock block;
+            {
+                std::unique_lock<std::mutex> lck(_this->queueMtx);
+                _this->queueCnd.wait(lck, [=]() { return !_this->readyBlocks.empty() || !_this->run; });
+                if (!_this->run) { break; }
+                block = _this->readyBlocks.front();
+                _this->readyBlocks.pop_front();
+            }
 
             // Convert samples to CF32
-            volk_16i_s32f_convert_32f((float*)_this->stream.writeBuf, buf, 32768.0f, blockSize * 2);
+            if (_this->sampleBits == 8) {
+                volk_8i_s32f_convert_32f((float*)_this->stream.writeBuf, (int8_t*)block.data, 128.0f, block.count * 2);
+            }
+            else {
+                volk_16i_s32f_convert_32f((float*)_this->stream.writeBuf, (int16_t*)block.data, 32768.0f, block.count * 2);
+            }
+
+            // Give the block back
+            {
+                std::lock_guard<std::mutex> lck(_this->queueMtx);
+                _this->freeBlocks.push_back(block.data);
+            }
 
             // Send out the samples
-            if (!_this->stream.swap(blockSize)) { break; };
+            if (!_this->stream.swap(block.count)) { break; }
         }
-
-        // Stop streaming
-        iio_channel_disable(rx0_i);
-        iio_channel_disable(rx0_q);
-
-        // Free buffer
-        iio_buffer_destroy(rxbuf);
     }
 
+    struct RawBlock {
+        uint8_t* data;
+        int count;
+    };
+
     std::string name;
     bool enabled = true;
     dsp::stream<dsp::complex_t> stream;
@@ -501,8 +657,25 @@ private:
     iio_device* dev = NULL;
     iio_channel* rxLO = NULL;
     iio_channel* rxChan = NULL;
+    iio_channel* rxI = NULL;
+    iio_channel* rxQ = NULL;
+    iio_buffer* rxbuf = NULL;
     bool running = false;
 
+    // Streaming
+    std::thread convThread;
+    std::atomic<bool> run = false;
+    int blockSize = 0;
+    int sampleBits = 16;
+    int sampleStep = 4;
+    std::mutex queueMtx;
+    std::condition_variable queueCnd;
+    std::vector<uint8_t*> freeBlocks;
+    std::deque<RawBlock> readyBlocks;
+    std::atomic<uint64_t> overflows = 0;
+    std::atomic<uint64_t> dropped = 0;
+    std::atomic<bool> streamFailed = false;
+
     std::string devDesc = "";
     std::string uri = "";
 
@@ -33,18 +33,14 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
-
-        // Refresh devices
-        refresh();
-
-        // Select first (TODO: Select from config)
-        select("");
+        handler.enumerateHandler = enumerate;
 
         sigpath::sourceManager.registerSource("RFNM", &handler);
     }
 
     ~RFNMSourceModule() {
-        
+        stop(this);
+        sigpath::sourceManager.unregisterSource("RFNM");
     }
 
     void postInit() {}
@@ -231,6 +227,15 @@ private:
         gainMax = dev->s->rx.ch[currentPath.chId].gain_range.max;
     }
 
+    static void enumerate(void* ctx) {
+        RFNMSourceModule* _this = (RFNMSourceModule*)ctx;
+        // Refresh devices
+        _this->refresh();
+
+        // Select first (TODO: Select from config)
+        _this->select("");
+    }
+
     static void menuSelected(void* ctx) {
         RFNMSourceModule* _this = (RFNMSourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
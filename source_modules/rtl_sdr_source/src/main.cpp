@@ -71,6 +71,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
+        handler.enumerateHandler = enumerate;
 
         strcpy(dbTxt, "--");
 
@@ -79,19 +80,6 @@ public:
             sampleRateListTxt += '\0';
         }
 
-        refresh();
-
-        config.acquire();
-        if (!config.conf["device"].is_string()) {
-            selectedDevName = "";
-            config.conf["device"] = "";
-        }
-        else {
-            selectedDevName = config.conf["device"];
-        }
-        config.release(true);
-        selectByName(selectedDevName);
-
         sigpath::sourceManager.registerSource("RTL-SDR", &handler);
     }
 
@@ -272,6 +260,22 @@ private:
         return std::string(buf);
     }
 
+    static void enumerate(void* ctx) {
+        RTLSDRSourceModule* _this = (RTLSDRSourceModule*)ctx;
+        _this->refresh();
+
+        config.acquire();
+        if (!config.conf["device"].is_string()) {
+            _this->selectedDevName = "";
+            config.conf["device"] = "";
+        }
+        else {
+            _this->selectedDevName = config.conf["device"];
+        }
+        config.release(true);
+        _this->selectByName(_this->selectedDevName);
+    }
+
     static void menuSelected(void* ctx) {
         RTLSDRSourceModule* _this = (RTLSDRSourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
@@ -42,21 +42,14 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &ddc.out;
-
-        // Refresh devices
-        refresh();
-
-        // Select device from config
-        config.acquire();
-        std::string devSerial = config.conf["device"];
-        config.release();
-        select(devSerial);
+        handler.enumerateHandler = enumerate;
 
         sigpath::sourceManager.registerSource("SDDC", &handler);
     }
 
     ~SDDCSourceModule() {
-        // Nothing to do
+        stop(this);
+        sigpath::sourceManager.unregisterSource("SDDC");
     }
 
     void postInit() {}
@@ -203,6 +196,18 @@ private:
         core::setInputSampleRate(sampleRate);
     }
 
+    static void enumerate(void* ctx) {
+        SDDCSourceModule* _this = (SDDCSourceModule*)ctx;
+        // Refresh devices
+        _this->refresh();
+
+        // Select device from config
+        config.acquire();
+        std::string devSerial = config.conf["device"];
+        config.release();
+        _this->select(devSerial);
+    }
+
     static void menuSelected(void* ctx) {
         SDDCSourceModule* _this = (SDDCSourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
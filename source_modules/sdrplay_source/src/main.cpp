@@ -110,13 +110,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
-
-        refresh();
-
-        config.acquire();
-        std::string confSelectDev = config.conf["device"];
-        config.release();
-        selectByName(confSelectDev);
+        handler.enumerateHandler = enumerate;
 
         sigpath::sourceManager.registerSource("SDRplay", &handler);
 
@@ -125,8 +119,8 @@ public:
 
     ~SDRPlaySourceModule() {
         stop(this);
-        if (initOk) { sdrplay_api_Close(); }
         sigpath::sourceManager.unregisterSource("SDRplay");
+        if (initOk) { sdrplay_api_Close(); }
     }
 
     void postInit() {}
@@ -480,6 +474,16 @@ private:
         return std::string(buf);
     }
 
+    static void enumerate(void* ctx) {
+        SDRPlaySourceModule* _this = (SDRPlaySourceModule*)ctx;
+        _this->refresh();
+
+        config.acquire();
+        std::string confSelectDev = config.conf["device"];
+        config.release();
+        _this->selectByName(confSelectDev);
+    }
+
     static void menuSelected(void* ctx) {
         SDRPlaySourceModule* _this = (SDRPlaySourceModule*)ctx;
         core::setInputSampleRate(_this->sampleRate);
@@ -234,7 +234,7 @@ private:
     void tryConnect() {
         try {
             if (client) { client.reset(); }
-            client = server::connect(hostname, port, &stream);
+            client = server::connect(hostname, port, &stream, &handler);
             deviceInit();
         }
         catch (const std::exception& e) {
@@ -3,13 +3,15 @@
 #include <cstring>
 #include <utils/flog.h>
 #include <core.h>
+#include <signal_path/signal_path.h>
 
 using namespace std::chrono_literals;
 
 namespace server {
-    Client::Client(std::shared_ptr<net::Socket> sock, dsp::stream<dsp::complex_t>* out) {
+    Client::Client(std::shared_ptr<net::Socket> sock, dsp::stream<dsp::complex_t>* out, SourceManager::SourceHandler* handler) {
         this->sock = sock;
         output = out;
+        this->handler = handler;
 
         // Allocate buffers
         rbuffer = new uint8_t[SERVER_MAX_PACKET_SIZE];
@@ -52,6 +54,8 @@ namespace server {
                 throw std::runtime_error("Timed out");
             case CONN_ERR_BUSY:
                 throw std::runtime_error("Server busy");
+            case CONN_ERR_VERSION:
+                throw std::runtime_error("Incompatible server version");
             default:
                 throw std::runtime_error("Unknown error");
             }
@@ -91,14 +95,21 @@ namespace server {
                 flog::warn("Action requires resync");
                 auto waiter = awaitCommandAck(COMMAND_UI_ACTION);
                 sendCommand(COMMAND_UI_ACTION, size);
+                bool fullResync = false;
                 if (waiter->await(PROTOCOL_TIMEOUT_MS)) {
-                    std::lock_guard lck(dlMtx);
-                    dl.load(r_cmd_data, r_pkt_hdr->size - sizeof(PacketHeader) - sizeof(CommandHeader));
+                    if (loadUI() < 0) {
+                        flog::error("Invalid UI update received");
+                        fullResync = true;
+                    }
                 }
                 else {
                     flog::error("Timeout out after asking for UI");
+                    fullResync = true;
                 }
                 waiter->handled();
+
+                // A missed or invalid delta leaves the UI out of sync with the server, fetch it entirely
+                if (fullResync) { getUI(); }
                 flog::warn("Resync done");
             }
             else {
@@ -181,7 +192,7 @@ namespace server {
                 // TODO: Move to command handler
                 if (r_cmd_hdr->cmd == COMMAND_SET_SAMPLERATE && r_pkt_hdr->size == sizeof(PacketHeader) + sizeof(CommandHeader) + sizeof(double)) {
                     currentSampleRate = *(double*)r_cmd_data;
-                    core::setInputSampleRate(currentSampleRate);
+                    sigpath::sourceManager.setSampleRate(handler, currentSampleRate);
                 }
                 else if (r_cmd_hdr->cmd == COMMAND_DISCONNECT) {
                     flog::error("Asked to disconnect by the server");
@@ -238,10 +249,18 @@ namespace server {
     int Client::getUI() {
         if (!isOpen()) { return -1; }
         auto waiter = awaitCommandAck(COMMAND_GET_UI);
-        sendCommand(COMMAND_GET_UI, 0);
+        *(uint32_t*)s_cmd_data = SERVER_PROTOCOL_VERSION;
+        sendCommand(COMMAND_GET_UI, 4);
         if (waiter->await(PROTOCOL_TIMEOUT_MS)) {
-            std::lock_guard lck(dlMtx);
-            dl.load(r_cmd_data, r_pkt_hdr->size - sizeof(PacketHeader) - sizeof(CommandHeader));
+            int err = loadUI();
+            if (err == CONN_ERR_VERSION) {
+                flog::error("The server uses an incompatible protocol version");
+                waiter->handled();
+                return CONN_ERR_VERSION;
+            }
+            else if (err < 0) {
+                flog::error("Invalid UI received");
+            }
         }
         else {
             if (!serverBusy) { flog::error("Timeout out after asking for UI"); };
@@ -252,6 +271,16 @@ namespace server {
         return 0;
     }
 
+    int Client::loadUI() {
+        // Check the protocol version first, the rest is a draw list delta
+        uint8_t* data = r_cmd_data;
+        int len = r_pkt_hdr->size - sizeof(PacketHeader) - sizeof(CommandHeader);
+        if (len < 4 || *(uint32_t*)data != SERVER_PROTOCOL_VERSION) { return CONN_ERR_VERSION; }
+
+        std::lock_guard lck(dlMtx);
+        return dl.loadDelta(&data[4], len - 4);
+    }
+
     void Client::sendPacket(PacketType type, int len) {
         s_pkt_hdr->type = type;
         s_pkt_hdr->size = sizeof(PacketHeader) + len;
@@ -280,7 +309,7 @@ namespace server {
         _this->output->swap(count);
     }
 
-    std::shared_ptr<Client> connect(std::string host, uint16_t port, dsp::stream<dsp::complex_t>* out) {
-        return std::make_shared<Client>(net::connect(host, port), out);
+    std::shared_ptr<Client> connect(std::string host, uint16_t port, dsp::stream<dsp::complex_t>* out, SourceManager::SourceHandler* handler) {
+        return std::make_shared<Client>(net::connect(host, port), out, handler);
     }
 }
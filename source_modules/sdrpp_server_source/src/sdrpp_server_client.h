@@ -11,6 +11,7 @@
 #include <dsp/compression/sample_stream_decompressor.h>
 #include <dsp/sink.h>
 #include <dsp/routing/stream_link.h>
+#include <signal_path/source.h>
 #include <zstd.h>
 #include <chrono>
 
@@ -74,12 +75,13 @@ namespace server {
 
     enum ConnectionError {
         CONN_ERR_TIMEOUT    = -1,
-        CONN_ERR_BUSY       = -2
+        CONN_ERR_BUSY       = -2,
+        CONN_ERR_VERSION    = -3
     };
 
     class Client {
     public:
-        Client(std::shared_ptr<net::Socket> sock, dsp::stream<dsp::complex_t>* out);
+        Client(std::shared_ptr<net::Socket> sock, dsp::stream<dsp::complex_t>* out, SourceManager::SourceHandler* handler);
         ~Client();
 
         void showMenu();
@@ -103,6 +105,7 @@ namespace server {
         void worker();
 
         int getUI();
+        int loadUI();
 
         void sendPacket(PacketType type, int len);
         void sendCommand(Command cmd, int len);
@@ -120,6 +123,7 @@ namespace server {
         dsp::compression::SampleStreamDecompressor decomp;
         dsp::routing::StreamLink<dsp::complex_t> link;
         dsp::stream<dsp::complex_t>* output;
+        SourceManager::SourceHandler* handler;
 
         uint8_t* rbuffer = NULL;
         uint8_t* sbuffer = NULL;
@@ -144,5 +148,5 @@ namespace server {
         double currentSampleRate = 1000000.0;
     };
 
-    std::shared_ptr<Client> connect(std::string host, uint16_t port, dsp::stream<dsp::complex_t>* out);
+    std::shared_ptr<Client> connect(std::string host, uint16_t port, dsp::stream<dsp::complex_t>* out, SourceManager::SourceHandler* handler);
 }
@@ -0,0 +1,316 @@
+#include <utils/shm_ring.h>
+#include <utils/flog.h>
+#include <module.h>
+#include <gui/gui.h>
+#include <signal_path/signal_path.h>
+#include <core.h>
+#include <gui/style.h>
+#include <config.h>
+#include <gui/smgui.h>
+#include <gui/tuner.h>
+#include <volk/volk.h>
+#include <atomic>
+
+SDRPP_MOD_INFO{
+    /* Name:            */ "shm_source",
+    /* Description:     */ "Shared Memory Source Module",
+    /* Author:          */ "Ryzerth",
+    /* Version:         */ 0, 1, 0,
+    /* Max instances    */ 1
+};
+
+ConfigManager config;
+
+class SHMSourceModule : public ModuleManager::Instance {
+public:
+    SHMSourceModule(std::string name) {
+        this->name = name;
+
+        handler.ctx = this;
+        handler.selectHandler = menuSelected;
+        handler.deselectHandler = menuDeselected;
+        handler.menuHandler = menuHandler;
+        handler.startHandler = start;
+        handler.stopHandler = stop;
+        handler.tuneHandler = tune;
+        handler.stream = &stream;
+
+        // Load config
+        config.acquire();
+        if (config.conf[name].contains("ringName")) {
+            std::string ringStr = config.conf[name]["ringName"];
+            strcpy(ringName, ringStr.c_str());
+        }
+        if (config.conf[name].contains("samplerate")) {
+            samplerate = config.conf[name]["samplerate"];
+        }
+        config.release();
+
+        sigpath::sourceManager.registerSource("Shared Memory", &handler);
+    }
+
+    ~SHMSourceModule() {
+        stop(this);
+        sigpath::sourceManager.unregisterSource("Shared Memory");
+    }
+
+    void postInit() {}
+
+    void enable() {
+        enabled = true;
+    }
+
+    void disable() {
+        enabled = false;
+    }
+
+    bool isEnabled() {
+        return enabled;
+    }
+
+private:
+    std::string getSrScaled(double sr) {
+        char buf[1024];
+        if (sr >= 1000000.0) {
+            sprintf(buf, "%.1lf MS/s", sr / 1000000.0);
+        }
+        else if (sr >= 1000.0) {
+            sprintf(buf, "%.1lf KS/s", sr / 1000.0);
+        }
+        else {
+            sprintf(buf, "%.1lf S/s", sr);
+        }
+        return std::string(buf);
+    }
+
+    void refresh() {
+        // Attach to the ring just long enough to read its header
+        try {
+            shm::RingReader reader(ringName);
+            double sr = reader.getSamplerate();
+            if (sr > 0) { samplerate = sr; }
+            double freq = reader.getFrequency();
+            if (freq > 0) { producerFreq = freq; }
+            errorStr = "";
+        }
+        catch (const std::exception& e) {
+            errorStr = e.what();
+            return;
+        }
+
+        // Apply the samplerate of the producer
+        core::setInputSampleRate(samplerate);
+        applyFrequency();
+        config.acquire();
+        config.conf[name]["samplerate"] = samplerate;
+        config.release(true);
+    }
+
+    void applyFrequency() {
+        // The frequency is chosen by the producer, show it but don't let the user change it
+        double freq = producerFreq;
+        if (freq <= 0 || freq == this->freq) { return; }
+        this->freq = freq;
+        tuner::tune(tuner::TUNER_MODE_IQ_ONLY, "", freq);
+    }
+
+    static void menuSelected(void* ctx) {
+        SHMSourceModule* _this = (SHMSourceModule*)ctx;
+        _this->freq = 0.0;
+        _this->refresh();
+        core::setInputSampleRate(_this->samplerate);
+        gui::waterfall.centerFrequencyLocked = true;
+        flog::info("SHMSourceModule '{0}': Menu Select!", _this->name);
+    }
+
+    static void menuDeselected(void* ctx) {
+        SHMSourceModule* _this = (SHMSourceModule*)ctx;
+        gui::waterfall.centerFrequencyLocked = false;
+        flog::info("SHMSourceModule '{0}': Menu Deselect!", _this->name);
+    }
+
+    static void start(void* ctx) {
+        SHMSourceModule* _this = (SHMSourceModule*)ctx;
+        if (_this->running) { return; }
+
+        // Attach to the ring
+        try {
+            _this->reader = std::make_unique<shm::RingReader>(_this->ringName);
+        }
+        catch (const std::exception& e) {
+            flog::error("Could not start Shared Memory Source: {}", e.what());
+            _this->errorStr = e.what();
+            return;
+        }
+        _this->errorStr = "";
+
+        // The samplerate can't be changed while running, only warn if the producer changed it
+        double sr = _this->reader->getSamplerate();
+        if (sr > 0 && sr != _this->samplerate) {
+            flog::warn("SHMSourceModule '{0}': Producer samplerate is {1} but {2} is in use, press refresh", _this->name, sr, _this->samplerate);
+        }
+
+        // Start receive worker
+        _this->overruns = 0;
+        _this->producerClosed = false;
+        _this->run = true;
+        _this->workerThread = std::thread(&SHMSourceModule::worker, _this);
+
+        _this->running = true;
+        flog::info("SHMSourceModule '{0}': Start!", _this->name);
+    }
+
+    static void stop(void* ctx) {
+        SHMSourceModule* _this = (SHMSourceModule*)ctx;
+        if (!_this->running) { return; }
+
+        // Stop worker thread
+        _this->run = false;
+        _this->stream.stopWriter();
+        if (_this->workerThread.joinable()) { _this->workerThread.join(); }
+        _this->stream.clearWriteStop();
+
+        // Detach from the ring
+        _this->reader.reset();
+
+        _this->running = false;
+        flog::info("SHMSourceModule '{0}': Stop!", _this->name);
+    }
+
+    static void tune(double freq, void* ctx) {
+        SHMSourceModule* _this = (SHMSourceModule*)ctx;
+        // The frequency is chosen by the producer, the center frequency is locked so only it can retune
+        flog::info("SHMSourceModule '{0}': Tune: {1}!", _this->name, freq);
+    }
+
+    static void menuHandler(void* ctx) {
+        SHMSourceModule* _this = (SHMSourceModule*)ctx;
+
+        // Follow the producer when it retunes
+        _this->applyFrequency();
+
+        if (_this->running) { SmGui::BeginDisabled(); }
+
+        // Ring name field
+        SmGui::LeftLabel("Name");
+        SmGui::FillWidth();
+        if (SmGui::InputText(("##shm_source_name_" + _this->name).c_str(), _this->ringName, sizeof(_this->ringName))) {
+            config.acquire();
+            config.conf[_this->name]["ringName"] = _this->ringName;
+            config.release(true);
+        }
+
+        // Reload the samplerate from the producer
+        SmGui::FillWidth();
+        if (SmGui::Button(("Refresh##shm_source_refresh_" + _this->name).c_str())) {
+            _this->refresh();
+        }
+
+        if (_this->running) { SmGui::EndDisabled(); }
+
+        // Info
+        SmGui::LeftLabel("Samplerate");
+        SmGui::Text(_this->getSrScaled(_this->samplerate).c_str());
+        if (_this->running) {
+            SmGui::LeftLabel("Overruns");
+            SmGui::Text(std::to_string(_this->overruns).c_str());
+        }
+
+        // Status
+        if (!_this->errorStr.empty()) {
+            SmGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), _this->errorStr.c_str());
+        }
+        else if (_this->producerClosed) {
+            SmGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "Producer closed the ring");
+        }
+    }
+
+    void worker() {
+        int sampleSize = shm::sampleSize(reader->getFormat());
+        shm::SampleFormat format = reader->getFormat();
+
+        while (run) {
+            // Wait for the producer
+            if (!reader->wait(100)) {
+                if (!reader->writerAlive()) {
+                    flog::warn("SHMSourceModule '{0}': Producer closed the ring", name);
+                    producerClosed = true;
+                    sigpath::sourceManager.requestStop();
+                    break;
+                }
+                continue;
+            }
+
+            // Get the available samples, at most a stream buffer worth
+            size_t bytes;
+            const uint8_t* data = reader->peek(bytes);
+            int count = std::min<size_t>(bytes / sampleSize, STREAM_BUFFER_SIZE);
+            if (!count) { continue; }
+
+            // Convert to CF32 straight from the shared memory
+            switch (format) {
+            case shm::SAMPLE_FORMAT_INT8:
+                volk_8i_s32f_convert_32f((float*)stream.writeBuf, (int8_t*)data, 128.0f, count*2);
+                break;
+            case shm::SAMPLE_FORMAT_INT16:
+                volk_16i_s32f_convert_32f((float*)stream.writeBuf, (int16_t*)data, 32768.0f, count*2);
+                break;
+            case shm::SAMPLE_FORMAT_INT32:
+                volk_32i_s32f_convert_32f((float*)stream.writeBuf, (int32_t*)data, 2147483647.0f, count*2);
+                break;
+            case shm::SAMPLE_FORMAT_FLOAT32:
+                memcpy(stream.writeBuf, data, count * sampleSize);
+                break;
+            default:
+                break;
+            }
+            producerFreq = reader->getFrequency();
+
+            // Drop the chunk if the producer overwrote it during the conversion
+            bool valid = reader->consume(count * sampleSize);
+            overruns = reader->overruns;
+            if (!valid) { continue; }
+
+            // Send out converted samples
+            if (!stream.swap(count)) { break; }
+        }
+    }
+
+    std::string name;
+    bool enabled = true;
+    dsp::stream<dsp::complex_t> stream;
+    SourceManager::SourceHandler handler;
+    bool running = false;
+    double freq = 0.0;
+
+    double samplerate = 1000000.0;
+    char ringName[1024] = "sdrpp";
+    std::string errorStr = "";
+
+    std::unique_ptr<shm::RingReader> reader;
+    std::thread workerThread;
+    std::atomic<bool> run = false;
+    std::atomic<bool> producerClosed = false;
+    std::atomic<double> producerFreq = 0.0;
+    std::atomic<uint64_t> overruns = 0;
+};
+
+MOD_EXPORT void _INIT_() {
+    json def = json({});
+    config.setPath(core::args["root"].s() + "/shm_source_config.json");
+    config.load(def);
+    config.enableAutoSave();
+}
+
+MOD_EXPORT ModuleManager::Instance* _CREATE_INSTANCE_(std::string name) {
+    return new SHMSourceModule(name);
+}
+
+MOD_EXPORT void _DELETE_INSTANCE_(ModuleManager::Instance* instance) {
+    delete (SHMSourceModule*)instance;
+}
+
+MOD_EXPORT void _END_() {
+    config.disableAutoSave();
+    config.save();
+}
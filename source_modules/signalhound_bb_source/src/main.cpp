@@ -69,14 +69,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
-
-        refresh();
-
-        int devSerial = 0;
-        config.acquire();
-        if (config.conf.contains("device")) { devSerial = config.conf["device"]; }
-        config.release();
-        selectBySerial(devSerial);
+        handler.enumerateHandler = enumerate;
 
         sigpath::sourceManager.registerSource("SignalHound BB", &handler);
     }
@@ -187,6 +180,17 @@ private:
         return true;
     }
 
+    static void enumerate(void* ctx) {
+        SignalHoundBBModule* _this = (SignalHoundBBModule*)ctx;
+        _this->refresh();
+
+        int devSerial = 0;
+        config.acquire();
+        if (config.conf.contains("device")) { devSerial = config.conf["device"]; }
+        config.release();
+        _this->selectBySerial(devSerial);
+    }
+
     static void menuSelected(void* ctx) {
         SignalHoundBBModule* _this = (SignalHoundBBModule*)ctx;
         core::setInputSampleRate(_this->actualSampleRate);
@@ -33,14 +33,6 @@ public:
 
         uiGains = new float[1];
 
-        refresh();
-
-        // Select default device
-        config.acquire();
-        std::string devName = config.conf["device"];
-        config.release();
-        selectDevice(devName);
-
         handler.ctx = this;
         handler.selectHandler = menuSelected;
         handler.deselectHandler = menuDeselected;
@@ -49,6 +41,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
+        handler.enumerateHandler = enumerate;
         sigpath::sourceManager.registerSource("SoapySDR", &handler);
     }
 
@@ -299,6 +292,17 @@ private:
         config.release(true);
     }
 
+    static void enumerate(void* ctx) {
+        SoapyModule* _this = (SoapyModule*)ctx;
+        _this->refresh();
+
+        // Select default device
+        config.acquire();
+        std::string devName = config.conf["device"];
+        config.release();
+        _this->selectDevice(devName);
+    }
+
     static void menuSelected(void* ctx) {
         SoapyModule* _this = (SoapyModule*)ctx;
         flog::info("SoapyModule '{0}': Menu Select!", _this->name);
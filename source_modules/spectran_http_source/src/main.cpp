@@ -185,7 +185,8 @@ private:
     }
 
     void onSamplerateChanged(double newSr) {
-        core::setInputSampleRate(newSr);
+        // Reported from the client's thread, tell the source manager which source it comes from
+        sigpath::sourceManager.setSampleRate(&handler, newSr);
     }
 
     std::string name;
@@ -67,15 +67,7 @@ public:
         handler.stopHandler = stop;
         handler.tuneHandler = tune;
         handler.stream = &stream;
-
-        refresh();
-
-        // Select device from config
-        config.acquire();
-        std::string devSerial = config.conf["device"];
-        config.release();
-        // TODO: Select
-        selectSerial("");
+        handler.enumerateHandler = enumerate;
 
         sigpath::sourceManager.registerSource("Spectran", &handler);
     }
@@ -219,6 +211,18 @@ private:
         return std::string(buf);
     }
 
+    static void enumerate(void* ctx) {
+        SpectranSourceModule* _this = (SpectranSourceModule*)ctx;
+        _this->refresh();
+
+        // Select device from config
+        config.acquire();
+        std::string devSerial = config.conf["device"];
+        config.release();
+        // TODO: Select
+        _this->selectSerial("");
+    }
+
     static void menuSelected(void* ctx) {
         SpectranSourceModule* _this = (SpectranSourceModule*)ctx;
         core::setInputSampleRate(_this->samplerate.effective);